@@ -15,6 +15,9 @@
 #include <Carna/qt/CarnaQt.h>
 #include <Carna/base/noncopyable.h>
 #include <QApplication>
+#include <memory>
+#include <string>
+#include <vector>
 
 /** \file   Application.h
   * \brief  Defines \ref Carna::qt::Application.
@@ -36,6 +39,19 @@ namespace qt
   * Specializes `QApplication` s.t. %Carna exceptions are processed properly. Also
   * setups the `base::Log` s.t. it gets Qt-compatible.
   *
+  * The shader programs are compiled lazily, when a \ref Display renders its first
+  * frame, s.t. the first frame of each view hitches. This can be avoided by
+  * \ref warmUpShaders "warming the shaders up" before the UI is built. The names
+  * of the shaders, that the materials and presets in use acquire from Carna, must
+  * be passed explicitly:
+  *
+  * \code
+  * Carna::qt::Application app( argc, argv );
+  * std::vector< std::string > presetShaders;
+  * presetShaders.push_back( "unshaded" );
+  * app.warmUpShaders( presetShaders );
+  * \endcode
+  *
   * \author Leonid Kostrykin
   * \date   2.4.15
   */
@@ -44,6 +60,9 @@ class CARNAQT_LIB Application : public QApplication
 
     NON_COPYABLE
 
+    struct Details;
+    const std::unique_ptr< Details > pimpl;
+
 public:
 
     /** \brief
@@ -54,7 +73,8 @@ public:
     Application( int& argc, char** argv );
     
     /** \brief
-      * Shuts down the log.
+      * Releases the \ref warmUpShaders "warmed up" shader programs and shuts down
+      * the log.
       */
     virtual ~Application();
     
@@ -62,6 +82,32 @@ public:
       * Reports uncatched exceptions to the user through `QMessageBox`.
       */
     virtual bool notify( QObject* receiver, QEvent* ev ) override;
+    
+    /** \brief
+      * Compiles and links all shader programs of this library, and those of the
+      * \a presetShaders, on a hidden OpenGL context. The \ref Display instances,
+      * that are created afterwards, share this context, s.t. they do not need to
+      * compile the programs when they render their first frames. The programs are
+      * kept until the application is deleted.
+      *
+      * The \a presetShaders are the names of the shader programs, that are
+      * acquired from the `base::ShaderManager` by the rendering stages in use.
+      *
+      * \pre `hasWarmedUpShaders() == false` and no \ref Display instance exists.
+      */
+    void warmUpShaders( const std::vector< std::string >& presetShaders = std::vector< std::string >() );
+    
+    /** \brief
+      * Tells whether \ref warmUpShaders was called.
+      */
+    bool hasWarmedUpShaders() const;
+    
+    /** \brief
+      * Tells how many milliseconds the \ref warmUpShaders "warm-up" took.
+      *
+      * \pre `hasWarmedUpShaders() == true`
+      */
+    double shaderWarmUpTime() const;
 
 }; // Application
 
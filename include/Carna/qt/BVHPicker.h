@@ -0,0 +1,141 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#ifndef BVHPICKER_H_0874895466
+#define BVHPICKER_H_0874895466
+
+#include <Carna/qt/CarnaQt.h>
+#include <Carna/base/noncopyable.h>
+#include <Carna/base/NodeListener.h>
+#include <Carna/base/Aggregation.h>
+#include <Carna/base/math.h>
+#include <memory>
+
+/** \file   BVHPicker.h
+  * \brief  Defines \ref Carna::qt::BVHPicker.
+  */
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// BVHPicker
+// ----------------------------------------------------------------------------------
+
+/** \brief
+  * Picks geometry objects on the CPU by casting rays against a bounding volume
+  * hierarchy, so that no color-coded render pass is required.
+  *
+  * The hierarchy is built over the world space axis-aligned bounding boxes of all
+  * geometry objects of a particular type beneath the root node. Each object must
+  * have a `base::BoundingBox` set as its bounding volume, otherwise it is not
+  * pickable. Rays are tested against the oriented bounding boxes of the objects
+  * that remain after traversing the hierarchy.
+  *
+  * The picker listens to the scene graph: When a `base::Spatial` moves, the boxes
+  * of the affected objects are updated and the hierarchy is refitted the next time
+  * a query is made. Only the leafs, that hold affected objects, and their
+  * ancestors are refitted. It is rebuilt from scratch only when the structure of the
+  * scene graph changes.
+  *
+  * A \ref Display uses this picker for drag-&-drop behaviour and hover feedback
+  * when it is \ref Display::setPicker "supplied".
+  *
+  * \author Leonid Kostrykin
+  * \date   19.10.26
+  */
+class CARNAQT_LIB BVHPicker : public base::NodeListener
+{
+
+    NON_COPYABLE
+
+    struct Details;
+    const std::unique_ptr< Details > pimpl;
+
+public:
+
+    /** \brief
+      * Instantiates.
+      *
+      * \param root is the node whose subtree is to be picked from.
+      * \param geometryType is the type of the pickable geometry objects.
+      */
+    BVHPicker( base::Node& root, unsigned int geometryType );
+
+    /** \brief
+      * Stops listening to the scene graph.
+      */
+    virtual ~BVHPicker();
+
+    /** \brief
+      * Holds the type of the pickable geometry objects.
+      */
+    const unsigned int geometryType;
+
+    /** \brief
+      * Picks the closest geometry object that the ray from \a origin along
+      * \a direction intersects. Both are given in world space. Returns
+      * `base::Aggregation<const base::Geometry>::%NULL_PTR` if there is none.
+      */
+    base::Aggregation< const base::Geometry > pick
+        ( const base::math::Vector3f& origin
+        , const base::math::Vector3f& direction );
+
+    /** \brief
+      * Picks the closest geometry object at \a x and \a y, that refer to the upper
+      * left corner of the render targets that \a vp belongs to.
+      */
+    base::Aggregation< const base::Geometry > pick
+        ( const base::Camera& cam
+        , const base::Viewport& vp
+        , unsigned int x, unsigned int y );
+
+    /** \brief
+      * Tells the number of pickable geometry objects. This causes the hierarchy
+      * to be rebuilt if required.
+      */
+    std::size_t size();
+
+    /** \brief
+      * Tells how often the hierarchy has been built from scratch.
+      */
+    std::size_t rebuilds() const;
+
+    /** \brief
+      * Tells how often the hierarchy has been refitted.
+      */
+    std::size_t refits() const;
+
+    /** \brief
+      * Tells the number of hierarchy nodes, that were updated by the last refit.
+      */
+    std::size_t lastRefitNodes() const;
+
+    virtual void onNodeDelete( const base::Node& node ) override;
+
+    virtual void onTreeChange( base::Node& node, bool inThisSubtree ) override;
+
+    virtual void onTreeInvalidated( base::Node& subtree ) override;
+
+}; // BVHPicker
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
+
+#endif // BVHPICKER_H_0874895466
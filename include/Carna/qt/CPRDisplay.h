@@ -0,0 +1,258 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#ifndef CPRDISPLAY_H_0874895466
+#define CPRDISPLAY_H_0874895466
+
+#include <Carna/qt/CarnaQt.h>
+#include <Carna/base/noncopyable.h>
+#include <Carna/base/math.h>
+#include <Carna/base/HUVolume.h>
+#include <QWidget>
+#include <QImage>
+#include <memory>
+#include <vector>
+
+/** \file   CPRDisplay.h
+  * \brief  Defines \ref Carna::qt::CPRDisplay.
+  */
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// CPRDisplay
+// ----------------------------------------------------------------------------------
+
+/** \brief
+  * Shows a curved planar reformation (CPR) of a volume along a polyline, e.g.
+  * the centerline of a vessel or the spine.
+  *
+  * The surface that is swept by the \ref setUpVector "up vector" along the
+  * \ref setCenterline "centerline" is unfolded into the image plane. Each
+  * segment of the polyline occupies a block of image columns. The positions the
+  * volume is sampled at are computed per block and cached together with the
+  * sampled HUV. When a \ref setControlPoint "control point is edited", only the
+  * blocks of the two adjacent segments are sampled again. Changing the windowing
+  * does not require any sampling at all.
+  *
+  * The volume is sampled on the CPU by a \ref Reslicer, hence no OpenGL context
+  * is required. The centerline is given in millimeters w.r.t. the center of the
+  * volume, along the axes of the volume's grid:
+  *
+  * \code
+  * Carna::qt::CPRDisplay cpr( *volume, spacing );
+  * cpr.setCenterline( centerline );
+  * cpr.setMode( Carna::qt::CPRDisplay::straightened );
+  * cpr.show();
+  * \endcode
+  *
+  * Multiple displays of the same volume should share a single \ref Reslicer,
+  * s.t. the voxels are held in memory only once:
+  *
+  * \code
+  * Carna::qt::Reslicer reslicer( *volume );
+  * Carna::qt::CPRDisplay vessel1( reslicer, spacing );
+  * Carna::qt::CPRDisplay vessel2( reslicer, spacing );
+  * \endcode
+  *
+  * \author Leonid Kostrykin
+  * \date   19.10.26
+  */
+class CARNAQT_LIB CPRDisplay : public QWidget
+{
+
+    NON_COPYABLE
+
+    struct Details;
+    const std::unique_ptr< Details > pimpl;
+
+public:
+
+    /** \brief
+      * Holds the default edge length of the pixels in millimeters.
+      */
+    const static float DEFAULT_PIXEL_SIZE;
+
+    /** \brief
+      * Holds the default extent of the image along the up vector in millimeters.
+      */
+    const static float DEFAULT_FIELD_HEIGHT;
+
+    /** \brief
+      * Enumerates the ways the surface is unfolded.
+      */
+    enum Mode
+    {
+        /** \brief
+          * The columns are laid out along the arc length of the centerline and the
+          * rows along the up vector, projected perpendicular to each segment. The
+          * centerline appears as a straight line in the center row.
+          */
+        straightened,
+
+        /** \brief
+          * The columns are laid out along the arc length of the centerline,
+          * projected onto the plane perpendicular to the up vector, and the rows
+          * along the up vector, centered on the volume center. The curvature of
+          * the centerline along the up vector is preserved.
+          */
+        stretched
+    };
+
+    /** \brief
+      * Instantiates. The voxels of \a volume are copied, s.t. \a volume is not
+      * referenced any longer afterwards.
+      *
+      * \param spacing is the distance between the voxel centers in millimeters.
+      */
+    CPRDisplay( const base::HUVolume& volume, const base::math::Vector3f& spacing, QWidget* parent = nullptr );
+
+    /** \brief
+      * Instantiates. The volume is sampled by \a reslicer, that is referenced,
+      * s.t. it can be shared among multiple displays of the same volume.
+      *
+      * \param spacing is the distance between the voxel centers in millimeters.
+      *
+      * \pre \a reslicer outlives this display.
+      */
+    CPRDisplay( const Reslicer& reslicer, const base::math::Vector3f& spacing, QWidget* parent = nullptr );
+
+    /** \brief
+      * Deletes.
+      */
+    virtual ~CPRDisplay();
+
+    /** \brief
+      * References the \ref Reslicer that the volume is sampled by.
+      */
+    const Reslicer& reslicer() const;
+
+    /** \brief
+      * Sets the control points of the centerline. All blocks are sampled again.
+      */
+    void setCenterline( const std::vector< base::math::Vector3f >& controlPoints );
+
+    /** \brief
+      * References the control points of the centerline.
+      */
+    const std::vector< base::math::Vector3f >& centerline() const;
+
+    /** \brief
+      * Moves the control point \a index to \a position. Only the blocks of the
+      * adjacent segments are sampled again.
+      *
+      * \pre `index < centerline().size()`
+      */
+    void setControlPoint( std::size_t index, const base::math::Vector3f& position );
+
+    /** \brief
+      * Sets how the surface is unfolded. The default is \ref straightened.
+      */
+    void setMode( Mode mode );
+
+    /** \brief
+      * Tells how the surface is unfolded.
+      */
+    Mode mode() const;
+
+    /** \brief
+      * Sets the direction that the image rows are laid out along. The default is
+      * the y-axis of the volume's grid.
+      *
+      * \pre `upVector.norm() > 0`
+      */
+    void setUpVector( const base::math::Vector3f& upVector );
+
+    /** \brief
+      * Tells the direction that the image rows are laid out along.
+      */
+    const base::math::Vector3f& upVector() const;
+
+    /** \brief
+      * Sets the edge length of the pixels in millimeters. The default is
+      * \ref DEFAULT_PIXEL_SIZE.
+      *
+      * \pre `pixelSize > 0`
+      */
+    void setPixelSize( float pixelSize );
+
+    /** \brief
+      * Tells the edge length of the pixels in millimeters.
+      */
+    float pixelSize() const;
+
+    /** \brief
+      * Sets the extent of the image along the up vector in millimeters. The
+      * default is \ref DEFAULT_FIELD_HEIGHT.
+      *
+      * \pre `fieldHeight > 0`
+      */
+    void setFieldHeight( float fieldHeight );
+
+    /** \brief
+      * Tells the extent of the image along the up vector in millimeters.
+      */
+    float fieldHeight() const;
+
+    /** \brief
+      * Sets windowing level to \a windowingLevel.
+      */
+    void setWindowingLevel( base::HUV windowingLevel );
+
+    /** \brief
+      * Sets windowing width to \a windowingWidth.
+      */
+    void setWindowingWidth( unsigned int windowingWidth );
+
+    /** \brief
+      * Tells the windowing level.
+      */
+    base::HUV windowingLevel() const;
+
+    /** \brief
+      * Tells the windowing width.
+      */
+    unsigned int windowingWidth() const;
+
+    /** \brief
+      * References the unfolded image. The blocks that need to be sampled are
+      * sampled first.
+      */
+    const QImage& image() const;
+
+    /** \brief
+      * Tells the number of image columns that have been sampled since this
+      * display was created.
+      */
+    std::size_t sampledColumns() const;
+
+protected:
+
+    /** \brief
+      * Draws the \ref image scaled to fit the widget, preserving its aspect ratio.
+      */
+    virtual void paintEvent( QPaintEvent* ev ) override;
+
+}; // CPRDisplay
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
+
+#endif // CPRDISPLAY_H_0874895466
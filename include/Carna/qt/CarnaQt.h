@@ -49,30 +49,43 @@ namespace Carna
     namespace qt
     {
         class Application;
+        class BVHPicker;
         class ColorMapEditor;
         class ColorMapSpanPainter;
         class ColorMapTracker;
         class ColorMapTrackerEditor;
         class ColorPicker;
         class ColorPickerPainter;
+        class CPRDisplay;
         class Display;
         class DRRControl;
         class DVRControl;
         class ExpandableGroupBox;
         class FrameRendererFactory;
+        class GeometryConsumer;
+        class InteractionReplay;
+        class InteractionTrace;
         class IntSpanPainter;
+        class LightboxDisplay;
         class MIPControl;
         class MIPControlLayer;
         class MIPLayerEditor;
         class MPR;
         class MPRDisplay;
+        class MPRDisplayPool;
         class MultiSpanSlider;
         class MultiSpanSliderModelViewMapping;
         class MultiSpanSliderTracker;
         class NullIntSpanPainter;
+        class PickingStage;
+        class RenderOrchestrator;
         class RenderStageControl;
+        class Reslicer;
+        class ShaderCache;
         class SpatialListModel;
+        class TiledRenderer;
         class VolumeRenderingControl;
+        class VolumeUploadScheduler;
         class WideColorPicker;
         class WindowingControl;
     }
@@ -13,6 +13,7 @@
 #define DISPLAY_H_0874895466
 
 #include <Carna/qt/CarnaQt.h>
+#include <Carna/qt/InteractionTrace.h>
 #include <Carna/base/noncopyable.h>
 #include <Carna/base/Association.h>
 #include <QGLWidget>
@@ -20,6 +21,7 @@
 
 class QMouseEvent;
 class QWheelEvent;
+class QPoint;
 
 /** \file   Display.h
   * \brief  Defines \ref Carna::qt::Display.
@@ -51,7 +53,29 @@ namespace qt
   *
   * This class also implements drag-&-drop behaviour for mesh-typed geometry. This
   * functionality is enabled if an instance of `presets::MeshColorCodingStage` is
-  * found within the rendering stages sequence.
+  * found within the rendering stages sequence. If a \ref PickingStage is found,
+  * it is used instead, and the display also tells which geometry object is
+  * \ref hovered "hovered" by the mouse. If a \ref setPicker "picker" is
+  * supplied, it is preferred over both and no picking render pass is required.
+  *
+  * Resizing the display does not reallocate the render targets of the renderer each
+  * time. Instead, the render targets are over-allocated to multiples of the
+  * \ref setResizeBucket "resize bucket" and the frame is rendered into a
+  * \ref viewport "viewport" of the widget's size. The render targets are only
+  * reallocated when the size class changes or when the resizing is finished.
+  *
+  * Changes within the scene graph only cause a repaint if they can affect the
+  * rendered frame, i.e. if the camera is moved or if geometry of a type is
+  * changed that any of the rendering stages consumes. This filtering is disabled
+  * if any rendering stage of unknown kind is found, unless it implements
+  * \ref GeometryConsumer. The number of
+  * \ref skippedRepaints "skipped repaints" is counted.
+  *
+  * If \ref setRefinementFrames "idle refinement" is enabled, the display renders
+  * additional frames after each update, as long as nothing changes. Each of these
+  * frames is rendered with a slightly jittered projection and they are averaged,
+  * s.t. the image quality converges while the display is at rest. Any
+  * \ref invalidate "invalidation" stops the refinement and starts it over.
   *
   * \note
   * You cannot put a frame renderer from one display to another. The reason for this
@@ -66,6 +90,7 @@ namespace qt
 class CARNAQT_LIB Display : public QGLWidget
 {
 
+    Q_OBJECT
     NON_COPYABLE
     
     struct Details;
@@ -90,6 +115,24 @@ public:
       */
     const static float DEFAULT_LATERAL_MOVEMENT_SPEED;
     
+    /** \brief
+      * Holds the default edge length in pixels that the render targets are
+      * over-allocated to.
+      */
+    const static unsigned int DEFAULT_RESIZE_BUCKET;
+    
+    /** \brief
+      * Holds the time in milliseconds that must pass without any resize event
+      * before the resizing is considered finished.
+      */
+    const static int RESIZE_SETTLE_DELAY;
+    
+    /** \brief
+      * Holds the default number of frames that are accumulated while the display
+      * is at rest, i.e. idle refinement is disabled by default.
+      */
+    const static unsigned int DEFAULT_REFINEMENT_FRAMES;
+    
     /** \brief
       * Defines how the root viewport is embedded into the rendered frame.
       *
@@ -120,7 +163,9 @@ public:
     /** \brief
       * Denotes that this display should update its rendering.
       *
-      * An appropriate event is posted to the Qt message queue.
+      * An appropriate event is posted to the Qt message queue, or the display is
+      * \ref RenderOrchestrator::schedule "scheduled" if it is attached to a
+      * \ref RenderOrchestrator.
       */
     void invalidate();
     
@@ -128,6 +173,70 @@ public:
       */
     void setViewportMode( ViewportMode );
     
+    /** \brief
+      * Sets the edge length in pixels that the render targets are over-allocated to
+      * while the display is being resized. Set to \f$1\f$ to reallocate the render
+      * targets on each resize event.
+      */
+    void setResizeBucket( unsigned int resizeBucket );
+    
+    /** \brief
+      * Tells the edge length in pixels that the render targets are over-allocated
+      * to while the display is being resized.
+      */
+    unsigned int resizeBucket() const;
+    
+    /** \brief
+      * Tells how often the render targets have been reallocated since the
+      * renderer was created.
+      */
+    std::size_t renderTargetReallocations() const;
+    
+    /** \brief
+      * Tells how many changes within the scene graph did not cause a repaint
+      * because they could not affect the rendered frame.
+      */
+    std::size_t skippedRepaints() const;
+    
+    /** \brief
+      * Tells the number of camera operations, that were gathered from the user
+      * input and are applied before the next frame. Consecutive operations of
+      * the same kind are merged, as well as movements, that are only separated by
+      * other movements.
+      */
+    std::size_t pendingInputOperations() const;
+    
+    /** \brief
+      * References the viewport the frame is rendered to. Its margins are w.r.t. the
+      * render targets, that might be larger than this widget.
+      * \pre `hasRenderer() == true`
+      */
+    const base::Viewport& viewport() const;
+    
+    /** \brief
+      * Maps \a widgetCoordinates to the coordinates of the render targets, that the
+      * margins of the \ref viewport refer to.
+      */
+    QPoint frameCoordinates( const QPoint& widgetCoordinates ) const;
+    
+    /** \brief
+      * Sets the number of frames that are accumulated while the display is at
+      * rest. Set to \f$0\f$ to disable idle refinement.
+      */
+    void setRefinementFrames( unsigned int refinementFrames );
+    
+    /** \brief
+      * Tells the number of frames that are accumulated while the display is at
+      * rest.
+      */
+    unsigned int refinementFrames() const;
+    
+    /** \brief
+      * Tells the number of frames that have been accumulated since the last
+      * update. This is \f$0\f$ if no refinement has taken place yet.
+      */
+    unsigned int refinementSamples() const;
+    
     /** \brief
       * Sets the radians per pixel ratio used for camera rotation.
       */
@@ -221,6 +330,110 @@ public:
       */
     void updateProjection();
     
+    /** \brief
+      * Sets the object that streams the volume textures of the scene to video
+      * memory. The display drives the streaming by invoking
+      * \ref VolumeUploadScheduler::process before each frame and keeps on
+      * invalidating itself until the scheduler is done.
+      *
+      * \param uploadScheduler might be `nullptr`.
+      */
+    void setUploadScheduler( base::Association< VolumeUploadScheduler >* uploadScheduler );
+    
+    /** \brief
+      * Tells whether an \ref setUploadScheduler "upload scheduler" is set.
+      */
+    bool hasUploadScheduler() const;
+    
+    /** \brief
+      * References the \ref setUploadScheduler "upload scheduler".
+      * \pre `hasUploadScheduler() == true`
+      */
+    VolumeUploadScheduler& uploadScheduler();
+    
+    /** \overload
+      */
+    const VolumeUploadScheduler& uploadScheduler() const;
+    
+    /** \brief
+      * Sets the object that picks geometry on the CPU for drag-&-drop behaviour
+      * and hover feedback. It is preferred over any picking rendering stage.
+      *
+      * \param picker might be `nullptr`.
+      */
+    void setPicker( base::Association< BVHPicker >* picker );
+    
+    /** \brief
+      * Tells whether a \ref setPicker "picker" is set.
+      */
+    bool hasPicker() const;
+    
+    /** \brief
+      * References the \ref setPicker "picker".
+      * \pre `hasPicker() == true`
+      */
+    BVHPicker& picker();
+    
+    /** \overload
+      */
+    const BVHPicker& picker() const;
+    
+    /** \brief
+      * Sets the trace that the applied camera control and spatial movement
+      * operations are recorded to, together with the rendered frames. The trace
+      * is \ref InteractionTrace::start "restarted".
+      *
+      * \param recorder might be `nullptr`.
+      */
+    void setInteractionRecorder( base::Association< InteractionTrace >* recorder );
+    
+    /** \brief
+      * Tells whether an \ref setInteractionRecorder "interaction recorder" is set.
+      */
+    bool hasInteractionRecorder() const;
+    
+    /** \brief
+      * References the \ref setInteractionRecorder "interaction recorder".
+      * \pre `hasInteractionRecorder() == true`
+      */
+    InteractionTrace& interactionRecorder();
+    
+    /** \brief
+      * Attaches this `%Display` to \a orchestrator. This is equivalent to
+      * \ref RenderOrchestrator::addDisplay.
+      *
+      * The display does not render on its own afterwards when it is
+      * \ref invalidate "invalidated", but is rendered by the next pass of the
+      * \a orchestrator, together with the other displays that are due.
+      */
+    void setRenderOrchestrator( RenderOrchestrator& orchestrator );
+    
+    /** \brief
+      * Detaches this `%Display` from its \ref RenderOrchestrator. This is
+      * equivalent to \ref RenderOrchestrator::removeDisplay.
+      *
+      * Nothing happens if this `%Display` is not attached to any orchestrator.
+      */
+    void removeFromRenderOrchestrator();
+    
+    /** \brief
+      * Tells whether this `%Display` is attached to a \ref RenderOrchestrator.
+      */
+    bool hasRenderOrchestrator() const;
+    
+    /** \brief
+      * References the \ref RenderOrchestrator this `%Display` is attached to.
+      * \pre `hasRenderOrchestrator() == true`
+      */
+    RenderOrchestrator& renderOrchestrator() const;
+    
+    /** \brief
+      * Applies the recorded \a event as if it was caused by user input. Events of
+      * kind \ref InteractionTrace::Event::frame "frame" are ignored, the caller is
+      * responsible for rendering. Used by \ref InteractionReplay.
+      */
+    void replay( const InteractionTrace::Event& event );
+    
     /** \brief
       * Tells whether the frame renderer already has been loaded.
       *
@@ -257,6 +470,33 @@ public:
       */
     static base::Aggregation< Display > byRenderer( const base::FrameRenderer& renderer );
     
+    /** \brief
+      * Makes the displays, that are created from now on, share their OpenGL
+      * context with \a sharingWidget instead of each other. Pass `nullptr` to
+      * restore the default behaviour. This is used by
+      * \ref Application::warmUpShaders.
+      *
+      * \pre `sharingWidget == nullptr` or no `%Display` instance exists.
+      */
+    static void setSharingWidget( const QGLWidget* sharingWidget );
+    
+    /** \brief
+      * References the geometry object that the mouse currently hovers, or is
+      * `nullptr` if there is none. This is only available if a \ref picker is
+      * set or a \ref PickingStage is found within the rendering stages sequence.
+      */
+    const base::Geometry* hoveredGeometry() const;
+    
+signals:
+
+    /** \brief
+      * Emitted when the mouse starts hovering \a geometry, that is `nullptr` if
+      * the mouse has left the previously hovered geometry object. This is only
+      * available if a \ref picker is set or a \ref PickingStage is found within
+      * the rendering stages sequence.
+      */
+    void hovered( const Carna::base::Geometry* geometry );
+    
 protected:
     
     /** \brief
@@ -274,6 +514,14 @@ protected:
       */
     virtual void paintGL() override;
     
+    /** \brief
+      * Renders the scene from \a cam into \a vp, that is the viewport of the
+      * frame. Invoked by \ref paintGL and by the idle refinement. The default
+      * implementation renders the scene once. Override this to render multiple
+      * views within the same frame.
+      */
+    virtual void renderFrame( base::FrameRenderer& renderer, base::Camera& cam, base::Node& root, const base::Viewport& vp );
+    
     /** \brief
       * Starts mouse interaction.
       */
@@ -293,6 +541,18 @@ protected:
       * Processes mouse interaction.
       */
     virtual void wheelEvent( QWheelEvent* ev ) override;
+    
+private slots:
+
+    /** \brief
+      * Fits the render targets to the widget's size once resizing is finished.
+      */
+    void finishResize();
+    
+    /** \brief
+      * Renders and accumulates the next refinement frame.
+      */
+    void refine();
 
 }; // Display
 
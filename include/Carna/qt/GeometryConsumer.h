@@ -0,0 +1,81 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#ifndef GEOMETRYCONSUMER_H_0874895466
+#define GEOMETRYCONSUMER_H_0874895466
+
+#include <Carna/qt/CarnaQt.h>
+#include <set>
+
+/** \file   GeometryConsumer.h
+  * \brief  Defines \ref Carna::qt::GeometryConsumer.
+  */
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// GeometryConsumer
+// ----------------------------------------------------------------------------------
+
+/** \brief
+  * Tells the geometry types that a rendering stage consumes.
+  *
+  * The \ref Display skips repaints for changes of the scene, that only affect
+  * geometry of types that none of its rendering stages consumes. Rendering stages
+  * are considered to consume any geometry, unless they either are of a kind the
+  * display knows, like `base::GeometryStage`, or they implement this interface:
+  *
+  * \code
+  * class MyStage : public Carna::base::RenderStage, public Carna::qt::GeometryConsumer
+  * {
+  *     // ...
+  *     virtual void addConsumedGeometryTypes( std::set< unsigned int >& types ) const override
+  *     {
+  *         types.insert( geometryType );
+  *     }
+  * };
+  * \endcode
+  *
+  * \author Leonid Kostrykin
+  * \date   19.10.26
+  */
+class CARNAQT_LIB GeometryConsumer
+{
+
+public:
+
+    /** \brief
+      * Does nothing.
+      */
+    virtual ~GeometryConsumer()
+    {
+    }
+
+    /** \brief
+      * Adds the geometry types that are consumed to \a types.
+      */
+    virtual void addConsumedGeometryTypes( std::set< unsigned int >& types ) const = 0;
+
+}; // GeometryConsumer
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
+
+#endif // GEOMETRYCONSUMER_H_0874895466
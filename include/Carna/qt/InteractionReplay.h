@@ -0,0 +1,138 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#ifndef INTERACTIONREPLAY_H_0874895466
+#define INTERACTIONREPLAY_H_0874895466
+
+#include <Carna/qt/CarnaQt.h>
+#include <Carna/base/noncopyable.h>
+#include <memory>
+#include <vector>
+
+/** \file   InteractionReplay.h
+  * \brief  Defines \ref Carna::qt::InteractionReplay.
+  */
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// InteractionReplay
+// ----------------------------------------------------------------------------------
+
+/** \brief
+  * Drives a \ref Display by the operations of an \ref InteractionTrace and
+  * measures the frame times.
+  *
+  * The operations are applied frame by frame, exactly as they were applied when
+  * the trace was recorded. Each frame is rendered synchronously and the time is
+  * measured until the GPU has finished it. This makes the frame times of
+  * different builds and drivers comparable on the same trace:
+  *
+  * \code
+  * Carna::qt::InteractionTrace trace;
+  * trace.load( "rotate.trace" );
+  * Carna::qt::InteractionReplay replay( display, trace );
+  * const auto stats = replay.run( Carna::qt::InteractionReplay::fullSpeed );
+  * \endcode
+  *
+  * \author Leonid Kostrykin
+  * \date   19.10.26
+  */
+class CARNAQT_LIB InteractionReplay
+{
+
+    NON_COPYABLE
+
+    struct Details;
+    const std::unique_ptr< Details > pimpl;
+
+public:
+
+    /** \brief
+      * Defines how fast the trace is replayed.
+      */
+    enum Mode
+    {
+        fullSpeed,  ///< Renders the frames back-to-back.
+        realTime    ///< Renders each frame not before the time it was recorded at.
+    };
+
+    // ------------------------------------------------------------------------------
+    // InteractionReplay :: Statistics
+    // ------------------------------------------------------------------------------
+
+    /** \brief
+      * Summarizes the frame times of a replay in milliseconds.
+      *
+      * \author Leonid Kostrykin
+      * \date   19.10.26
+      */
+    struct CARNAQT_LIB Statistics
+    {
+        /** \brief
+          * Computes the statistics of \a frameTimes.
+          */
+        explicit Statistics( const std::vector< double >& frameTimes );
+
+        std::size_t frames; ///< Holds the number of rendered frames.
+        double mean;        ///< Holds the mean frame time.
+        double median;      ///< Holds the 50th percentile.
+        double p90;         ///< Holds the 90th percentile.
+        double p95;         ///< Holds the 95th percentile.
+        double p99;         ///< Holds the 99th percentile.
+        double max;         ///< Holds the longest frame time.
+
+        /** \brief
+          * Computes the \a p -th percentile of the ascendingly \a sorted values
+          * using the nearest-rank method. Yields \f$0\f$ if \a sorted is empty.
+          */
+        static double percentile( const std::vector< double >& sorted, double p );
+    };
+
+    // ------------------------------------------------------------------------------
+
+    /** \brief
+      * Instantiates.
+      */
+    InteractionReplay( Display& display, const InteractionTrace& trace );
+
+    /** \brief
+      * Deletes.
+      */
+    ~InteractionReplay();
+
+    /** \brief
+      * Replays the trace and returns the statistics of the frame times.
+      *
+      * \pre `Display::hasRenderer() == true` and `Display::hasCamera() == true`
+      */
+    Statistics run( Mode mode );
+
+    /** \brief
+      * References the frame times in milliseconds measured by the last \ref run.
+      */
+    const std::vector< double >& frameTimes() const;
+
+}; // InteractionReplay
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
+
+#endif // INTERACTIONREPLAY_H_0874895466
@@ -0,0 +1,149 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#ifndef INTERACTIONTRACE_H_0874895466
+#define INTERACTIONTRACE_H_0874895466
+
+#include <Carna/qt/CarnaQt.h>
+#include <Carna/base/noncopyable.h>
+#include <QString>
+#include <memory>
+#include <vector>
+
+/** \file   InteractionTrace.h
+  * \brief  Defines \ref Carna::qt::InteractionTrace.
+  */
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// InteractionTrace
+// ----------------------------------------------------------------------------------
+
+/** \brief
+  * Holds the camera control and spatial movement operations that were applied to
+  * a \ref Display, together with the times when they were applied.
+  *
+  * A trace is recorded by \ref Display::setInteractionRecorder "attaching" it to a
+  * display. Besides the operations, the trace also records when the frames were
+  * rendered, s.t. it can be replayed frame by frame by an
+  * \ref InteractionReplay. Traces are stored in a compact binary format.
+  *
+  * \author Leonid Kostrykin
+  * \date   19.10.26
+  */
+class CARNAQT_LIB InteractionTrace
+{
+
+    NON_COPYABLE
+
+    struct Details;
+    const std::unique_ptr< Details > pimpl;
+
+public:
+
+    // ------------------------------------------------------------------------------
+    // InteractionTrace :: Event
+    // ------------------------------------------------------------------------------
+
+    /** \brief
+      * Describes a single recorded operation.
+      *
+      * \author Leonid Kostrykin
+      * \date   19.10.26
+      */
+    struct CARNAQT_LIB Event
+    {
+        /** \brief
+          * Enumerates the kinds of recorded operations.
+          */
+        enum Kind
+        {
+            rotateHorizontally,     ///< `base::CameraControl::rotateHorizontally` with radians `x`.
+            rotateVertically,       ///< `base::CameraControl::rotateVertically` with radians `x`.
+            moveLaterally,          ///< `base::CameraControl::moveLaterally` with `x` and `y`.
+            moveAxially,            ///< `base::CameraControl::moveAxially` with `x`.
+            spatialMovementBegin,   ///< Spatial movement of the geometry at frame coordinates `x` and `y`.
+            spatialMovementUpdate,  ///< Spatial movement update to frame coordinates `x` and `y`.
+            spatialMovementEnd,     ///< End of the spatial movement.
+            frame                   ///< A frame was rendered.
+        };
+
+        /** \brief
+          * Instantiates.
+          */
+        Event( Kind kind, unsigned int time, float x, float y );
+
+        Kind kind;          ///< Holds the kind of the operation.
+        unsigned int time;  ///< Holds the milliseconds since the recording started.
+        float x;            ///< Holds the first argument of the operation.
+        float y;            ///< Holds the second argument of the operation.
+    };
+
+    // ------------------------------------------------------------------------------
+
+    /** \brief
+      * Instantiates an empty trace.
+      */
+    InteractionTrace();
+
+    /** \brief
+      * Deletes.
+      */
+    ~InteractionTrace();
+
+    /** \brief
+      * Clears the trace and restarts the clock that the event times refer to.
+      */
+    void start();
+
+    /** \brief
+      * Appends an event of \a kind with arguments \a x and \a y, whose time is
+      * read from the clock.
+      */
+    void record( Event::Kind kind, float x = 0, float y = 0 );
+
+    /** \brief
+      * References the recorded events.
+      */
+    const std::vector< Event >& events() const;
+
+    /** \brief
+      * Tells the number of recorded frames.
+      */
+    std::size_t frames() const;
+
+    /** \brief
+      * Writes the trace to \a fileName. Returns `false` if writing fails.
+      */
+    bool save( const QString& fileName ) const;
+
+    /** \brief
+      * Replaces the trace by the one read from \a fileName. Returns `false` and
+      * leaves the trace empty if reading fails.
+      */
+    bool load( const QString& fileName );
+
+}; // InteractionTrace
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
+
+#endif // INTERACTIONTRACE_H_0874895466
@@ -0,0 +1,246 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#ifndef LIGHTBOXDISPLAY_H_0874895466
+#define LIGHTBOXDISPLAY_H_0874895466
+
+#include <Carna/qt/CarnaQt.h>
+#include <Carna/qt/MPRDisplay.h>
+#include <Carna/base/noncopyable.h>
+#include <Carna/base/math.h>
+#include <QWidget>
+#include <memory>
+#include <vector>
+
+/** \file   LightboxDisplay.h
+  * \brief  Defines \ref Carna::qt::LightboxDisplay.
+  */
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// LightboxDisplay
+// ----------------------------------------------------------------------------------
+
+/** \brief
+  * Shows multiple parallel slices of a volume side by side, each within a tile of
+  * a grid.
+  *
+  * All slices are rendered by a single `base::FrameRenderer` within the same
+  * frame, where each slice is rendered into its own viewport. This is much cheaper
+  * than using one \ref MPRDisplay per slice, because the rendering stages, the
+  * camera and the render targets exist only once.
+  *
+  * The slices are specified by their offsets along the viewing direction, either
+  * \ref setSlices "one by one" or \ref setEvenlySpacedSlices "evenly spaced".
+  * The offsets are given in millimeters w.r.t. the coordinate system of the
+  * \ref setVolume "volume's" parent node, that is \ref setRotation "rotated"
+  * additionally. Scrolling the mouse wheel shifts all offsets by the
+  * \ref setScrollStep "scroll step". Scrolling the mouse wheel while holding
+  * the control key zooms.
+  *
+  * The cutting planes of this display are of geometry type
+  * `MPRDisplay::Parameters::geometryTypePlanes`. Use a geometry type that no
+  * \ref MPRDisplay uses within the same scene, s.t. their planes do not show up
+  * within the tiles.
+  *
+  * \author Leonid Kostrykin
+  * \date   19.10.26
+  */
+class CARNAQT_LIB LightboxDisplay : public QWidget
+{
+
+    NON_COPYABLE
+    
+    struct Details;
+    const std::unique_ptr< Details > pimpl;
+
+public:
+
+    /** \brief
+      * Holds the default number of tile columns.
+      */
+    const static unsigned int DEFAULT_COLUMNS;
+
+    /** \brief
+      * Holds the default edge length in millimeters of the region that each tile
+      * shows.
+      */
+    const static float DEFAULT_FIELD_OF_VIEW;
+
+    /** \brief
+      * Instantiates. \ref setRotation "Sets rotation" to
+      * \ref MPRDisplay::ROTATION_FRONT initially.
+      */
+    explicit LightboxDisplay( const MPRDisplay::Parameters& params, QWidget* parent = nullptr );
+
+    /** \brief
+      * Detaches from the volume and deletes.
+      */
+    virtual ~LightboxDisplay();
+
+    /** \brief
+      * Holds the configuration of this `%LightboxDisplay`.
+      */
+    const MPRDisplay::Parameters parameters;
+
+    /** \brief
+      * Recommends the minimum size of this widget.
+      */
+    virtual QSize minimumSizeHint() const override;
+
+    /** \brief
+      * Shows slices of \a volume. The display attaches a dedicated node to the
+      * root of the scene, that \a volume belongs to.
+      *
+      * \pre `volume.hasParent() == true`
+      */
+    void setVolume( base::Spatial& volume );
+
+    /** \brief
+      * Detaches from the volume \ref setVolume "set previously". Nothing happens
+      * if no volume is set.
+      */
+    void removeVolume();
+
+    /** \brief
+      * Tells whether a volume is \ref setVolume "set".
+      */
+    bool hasVolume() const;
+
+    /** \brief
+      * Sets the rotation of the slices w.r.t. the volume's parent. The slices are
+      * perpendicular to the z-axis of the rotated coordinate system.
+      */
+    void setRotation( const base::math::Matrix3f& rotation );
+
+    /** \brief
+      * Shows the slices at the \a offsets given in millimeters.
+      */
+    void setSlices( const std::vector< float >& offsets );
+
+    /** \brief
+      * Shows \a count slices, that are evenly spaced between the offsets \a first
+      * and \a last. Also sets the \ref setScrollStep "scroll step" to the spacing
+      * of the slices.
+      *
+      * \pre `count > 0`
+      */
+    void setEvenlySpacedSlices( float first, float last, unsigned int count );
+
+    /** \brief
+      * Tells the number of slices.
+      */
+    std::size_t slices() const;
+
+    /** \brief
+      * Tells the offset of the slice with \a sliceIndex in millimeters, including
+      * the \ref scroll "scroll offset".
+      */
+    float sliceOffset( std::size_t sliceIndex ) const;
+
+    /** \brief
+      * Shifts all slices by \a steps times the \ref setScrollStep "scroll step".
+      */
+    void scroll( int steps );
+
+    /** \brief
+      * Tells how far the slices are shifted by \ref scroll in millimeters.
+      */
+    float scrollOffset() const;
+
+    /** \brief
+      * Sets the distance in millimeters that the slices are shifted by per
+      * \ref scroll "scroll step".
+      */
+    void setScrollStep( float millimeters );
+
+    /** \brief
+      * Tells the distance in millimeters that the slices are shifted by per
+      * \ref scroll "scroll step".
+      */
+    float scrollStep() const;
+
+    /** \brief
+      * Sets the number of tile columns. The number of rows follows from the
+      * number of slices.
+      *
+      * \pre `columns > 0`
+      */
+    void setColumns( unsigned int columns );
+
+    /** \brief
+      * Tells the number of tile columns.
+      */
+    unsigned int columns() const;
+
+    /** \brief
+      * Sets the edge length in millimeters of the region that each tile shows.
+      */
+    void setFieldOfView( float millimeters );
+
+    /** \brief
+      * Tells the edge length in millimeters of the region that each tile shows.
+      */
+    float fieldOfView() const;
+
+    /** \brief
+      * Sets windowing level to \a windowingLevel.
+      */
+    void setWindowingLevel( base::HUV windowingLevel );
+    
+    /** \brief
+      * Sets windowing level to \a windowingWidth.
+      */
+    void setWindowingWidth( unsigned int windowingWidth );
+
+    /** \brief
+      * Tells the windowing level.
+      */
+    base::HUV windowingLevel() const;
+    
+    /** \brief
+      * Tells the windowing width.
+      */
+    unsigned int windowingWidth() const;
+
+    /** \brief
+      * Attaches the \ref Display of this `%LightboxDisplay` to \a orchestrator.
+      * This is equivalent to \ref Display::setRenderOrchestrator.
+      */
+    void setRenderOrchestrator( RenderOrchestrator& orchestrator );
+
+    /** \brief
+      * Tells the index of the slice shown at \a widgetCoordinates, or the number
+      * of \ref slices if there is no tile at \a widgetCoordinates.
+      */
+    std::size_t sliceAt( const QPoint& widgetCoordinates ) const;
+
+    /** \brief
+      * Issues a repaint.
+      */
+    void invalidate();
+
+}; // LightboxDisplay
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
+
+#endif // LIGHTBOXDISPLAY_H_0874895466
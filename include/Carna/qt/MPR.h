@@ -36,10 +36,11 @@ namespace qt
   * the scene.
   *
   * Use the \ref setRoot method to specify the scene to be rendered. The class looks
-  * automatically for the volumetric data beneath the root. The current
-  * implementation is restricted s.t. it supports one volumetric node/grid per
-  * instance. You should simply specify the root node of a subtree if your scene
-  * contains multiple volumetric grids. The lifetime of `%MPR` objects is independent
+  * automatically for the volumetric data beneath the root. Up to
+  * \ref MAX_VOLUMES volumetric grids are supported per instance, e.g. registered
+  * PET and CT studies. Each display samples all of them within a single pass and
+  * blends them according to their \ref setVolumeWindowingLevel "windowing" and
+  * \ref setVolumeWeight "weights". The lifetime of `%MPR` objects is independent
   * from that of the attached root node: The `%MPR` object resets its root reference
   * automatically when the root is destroyed. The lifetime is also independent from
   * that of the attached displays.
@@ -89,6 +90,16 @@ class CARNAQT_LIB MPR
 
 public:
 
+    /** \brief
+      * Holds the maximum number of volumetric grids beneath the root.
+      */
+    const static unsigned int MAX_VOLUMES = 4;
+
+    /** \brief
+      * Holds the default blend weight of a volumetric grid.
+      */
+    const static float DEFAULT_VOLUME_WEIGHT;
+
     /** \brief
       * Instantiates.
       *
@@ -114,7 +125,12 @@ public:
       * Use the \ref hasVolume and \ref volume methods to query the results of this
       * search.
       *
-      * \throws base::AssertionFailure if more than one volumetric grid is found.
+      * Later changes of the scene are tracked incrementally, i.e. only the
+      * subtrees that are attached or detached are searched. Subtrees, that are
+      * detached from the scene, are not tracked until they are attached again.
+      *
+      * If more than \ref MAX_VOLUMES volumetric grids are found, those found last
+      * are ignored and a warning is logged.
       */
     void setRoot( base::Node& root );
     
@@ -142,7 +158,9 @@ public:
     bool hasVolume() const;
     
     /** \brief
-      * References the volumetric grid found beneath the \ref setRoot "root".
+      * References the first volumetric grid found beneath the \ref setRoot "root".
+      * The displays are aligned to this grid.
+      *
       * \pre `hasVolume() == true`
       */
     base::Spatial& volume();
@@ -150,14 +168,70 @@ public:
     /** \overload
       */
     const base::Spatial& volume() const;
+    
+    /** \brief
+      * Tells the number of volumetric grids found beneath the \ref setRoot "root".
+      */
+    std::size_t volumes() const;
+    
+    /** \brief
+      * References the volumetric grid with \a volumeIdx. The grids keep their
+      * indices as long as they are part of the scene. Grids that are found later
+      * are appended.
+      *
+      * \pre `volumeIdx < volumes()`
+      */
+    base::Spatial& volumeAt( std::size_t volumeIdx );
+    
+    /** \overload
+      */
+    const base::Spatial& volumeAt( std::size_t volumeIdx ) const;
+    
+    /** \brief
+      * Sets the windowing level of \a volume, that is one of the
+      * \ref volumeAt "volumetric grids", to \a windowingLevel. The windowing of
+      * each grid is initialized with the \ref setWindowingLevel "common one".
+      */
+    void setVolumeWindowingLevel( const base::Spatial& volume, base::HUV windowingLevel );
+    
+    /** \brief
+      * Sets the windowing width of \a volume to \a windowingWidth.
+      */
+    void setVolumeWindowingWidth( const base::Spatial& volume, unsigned int windowingWidth );
+    
+    /** \brief
+      * Sets the blend weight of \a volume to \a weight. The intensities of the
+      * volumetric grids are averaged w.r.t. their weights, wherever they overlap.
+      * The default is \ref DEFAULT_VOLUME_WEIGHT.
+      *
+      * \pre `weight >= 0`
+      */
+    void setVolumeWeight( const base::Spatial& volume, float weight );
+    
+    /** \brief
+      * Tells the windowing level of \a volume.
+      */
+    base::HUV volumeWindowingLevel( const base::Spatial& volume ) const;
+    
+    /** \brief
+      * Tells the windowing width of \a volume.
+      */
+    unsigned int volumeWindowingWidth( const base::Spatial& volume ) const;
+    
+    /** \brief
+      * Tells the blend weight of \a volume.
+      */
+    float volumeWeight( const base::Spatial& volume ) const;
 
     /** \brief
-      * Sets windowing level to \a windowingLevel on all attached displays.
+      * Sets windowing level to \a windowingLevel on all attached displays and of
+      * all volumetric grids.
       */
     void setWindowingLevel( base::HUV windowingLevel );
     
     /** \brief
-      * Sets windowing level to \a windowingWidth on all attached displays.
+      * Sets windowing level to \a windowingWidth on all attached displays and of
+      * all volumetric grids.
       */
     void setWindowingWidth( unsigned int windowingWidth );
 
@@ -78,6 +78,33 @@ public:
       */
     const static base::Color DEFAULT_PLANE_COLOR;
     
+    /** \brief
+      * Holds the default distance between the samples of a slab in millimeters.
+      */
+    const static float DEFAULT_SLAB_STEP;
+
+    /** \brief
+      * Holds the default distance between the samples of a slab in millimeters,
+      * while a cutting plane is being dragged.
+      */
+    const static float DEFAULT_INTERACTIVE_SLAB_STEP;
+
+    /** \brief
+      * Holds the default number of slices that are prefetched ahead of the plane
+      * in cine mode.
+      */
+    const static unsigned int DEFAULT_CINE_PREFETCH;
+
+    /** \brief
+      * Enumerates the projections of the samples across a slab.
+      */
+    enum SlabMode
+    {
+        maximumIntensityProjection, ///< Shows the highest HUV across the slab.
+        minimumIntensityProjection, ///< Shows the lowest HUV across the slab.
+        averageIntensityProjection  ///< Shows the mean HUV across the slab.
+    };
+    
     const static base::math::Matrix3f ROTATION_FRONT; ///< Predefines \ref setRotation "rotation" for a "from front" view.
     const static base::math::Matrix3f ROTATION_LEFT;  ///< Predefines \ref setRotation "rotation" for a "from left" view.
     const static base::math::Matrix3f ROTATION_TOP;   ///< Predefines \ref setRotation "rotation" for a "from top" view.
@@ -97,6 +124,23 @@ public:
         float visibleDistance;           ///< Holds the distance between the far and near clipping planes.
     };
     
+    /** \brief
+      * Specifies how a volumetric grid is blended with the others, if the scene
+      * contains more than one. This is set up by the \ref MPR.
+      */
+    struct CARNAQT_LIB FusedVolume
+    {
+        /** \brief
+          * Instantiates.
+          */
+        FusedVolume( const base::Spatial& volume, base::HUV windowingLevel, unsigned int windowingWidth, float weight );
+        
+        const base::Spatial* volume; ///< References the node or geometry of the volumetric grid.
+        base::HUV windowingLevel;    ///< Holds the windowing level of the volumetric grid.
+        unsigned int windowingWidth; ///< Holds the windowing width of the volumetric grid.
+        float weight;                ///< Holds the blend weight of the volumetric grid.
+    };
+    
     /** \brief
       * Configures a \ref MPRDisplay actively by supplying additional rendering
       * stages.
@@ -158,6 +202,20 @@ public:
       */
     void invalidate();
     
+    /** \brief
+      * Discards the cached slices, s.t. the volume is sampled again when the next
+      * frame is rendered, and \ref invalidate "invalidates" this display. This is
+      * required if the volume data has changed in place. Replacing the textures
+      * of the volume geometries is detected automatically.
+      */
+    void invalidateSlices();
+    
+    /** \brief
+      * Tells how many times the volume was sampled, including the prefetched
+      * slices.
+      */
+    std::size_t slicesSampled() const;
+    
     /** \brief
       * Denotes that \a tag is to be used within logged messages to identify this
       * `%MPRDisplay` instance.
@@ -210,6 +268,19 @@ public:
       */
     void removeFromMPR();
     
+    /** \brief
+      * Attaches the \ref Display of this `%MPRDisplay` to \a orchestrator. This
+      * is equivalent to \ref Display::setRenderOrchestrator.
+      */
+    void setRenderOrchestrator( RenderOrchestrator& orchestrator );
+    
+    /** \brief
+      * Detaches the \ref Display of this `%MPRDisplay` from its
+      * \ref RenderOrchestrator. This is equivalent to
+      * \ref Display::removeFromRenderOrchestrator.
+      */
+    void removeFromRenderOrchestrator();
+    
     /** \brief
       * Sets the illustration color the cutting plane from this `%MPRDisplay` within
       * other displays.
@@ -224,6 +295,9 @@ public:
 
     /** \brief
       * Sets windowing level to \a windowingLevel.
+      *
+      * The HUV of the slice are cached, hence the volume is not sampled again
+      * when only the windowing changes.
       */
     void setWindowingLevel( base::HUV windowingLevel );
     
@@ -237,6 +311,15 @@ public:
       */
     base::HUV windowingLevel() const;
     
+    /** \brief
+      * Sets the volumetric grids to be blended, in the order of their
+      * \ref MPR::volumeAt "indices". This is done by the \ref MPR. The windowing
+      * of this display is used instead if the scene contains a single grid only.
+      *
+      * \pre `volumes.size() <= MPR::MAX_VOLUMES`
+      */
+    void setFusedVolumes( const std::vector< FusedVolume >& volumes );
+    
     /** \brief
       * Tells the windowing width.
       */
@@ -256,6 +339,115 @@ public:
       * Tells the current zoom factor.
       */
     float zoomFactor() const;
+    
+    /** \brief
+      * Sets the thickness of the slab around the cutting plane in millimeters. The
+      * slab is sampled along the plane normal and the samples are projected
+      * according to the \ref setSlabMode "slab mode". The default is \f$0\f$,
+      * i.e. an infinitely thin plane is shown.
+      *
+      * \pre `thickness >= 0`
+      */
+    void setSlabThickness( float thickness );
+    
+    /** \brief
+      * Tells the thickness of the slab around the cutting plane in millimeters.
+      */
+    float slabThickness() const;
+    
+    /** \brief
+      * Sets how the samples across the slab are projected. The default is
+      * \ref maximumIntensityProjection.
+      */
+    void setSlabMode( SlabMode mode );
+    
+    /** \brief
+      * Tells how the samples across the slab are projected.
+      */
+    SlabMode slabMode() const;
+    
+    /** \brief
+      * Sets the distance between the samples of the slab in millimeters. The
+      * default is \ref DEFAULT_SLAB_STEP.
+      *
+      * \pre `step > 0`
+      */
+    void setSlabStep( float step );
+    
+    /** \brief
+      * Tells the distance between the samples of the slab in millimeters.
+      */
+    float slabStep() const;
+    
+    /** \brief
+      * Sets the distance between the samples of the slab in millimeters, that is
+      * used instead of the \ref setSlabStep "regular one" while any cutting plane
+      * is being dragged. The default is \ref DEFAULT_INTERACTIVE_SLAB_STEP.
+      *
+      * \pre `step > 0`
+      */
+    void setInteractiveSlabStep( float step );
+    
+    /** \brief
+      * Tells the distance between the samples of the slab in millimeters, that is
+      * used while any cutting plane is being dragged.
+      */
+    float interactiveSlabStep() const;
+
+    /** \brief
+      * Starts advancing the plane by \a step millimeters along the viewing
+      * direction at \a framesPerSecond, until \ref stopCine is called.
+      *
+      * The \ref setCinePrefetch "next few slices" in the scrolling direction are
+      * rendered ahead into an offscreen ring buffer after each frame, s.t. the
+      * playback only needs to present them. If a frame is late, the plane skips
+      * the slices that were due meanwhile, so the playback keeps its speed. Such
+      * slices are counted as \ref cineFramesDropped "dropped".
+      *
+      * \pre `framesPerSecond > 0` and `step != 0`
+      */
+    void startCine( float framesPerSecond, float step );
+
+    /** \brief
+      * Stops the cine mode. The counters keep their values until it is started
+      * again.
+      */
+    void stopCine();
+
+    /** \brief
+      * Tells whether the cine mode is running.
+      */
+    bool isCineRunning() const;
+
+    /** \brief
+      * Sets the number of slices prefetched ahead of the plane in cine mode. The
+      * default is \ref DEFAULT_CINE_PREFETCH. Each slice occupies 8 bytes per
+      * pixel of video memory.
+      */
+    void setCinePrefetch( unsigned int count );
+
+    /** \brief
+      * Tells the number of slices prefetched ahead of the plane in cine mode.
+      */
+    unsigned int cinePrefetch() const;
+
+    /** \brief
+      * Tells by how many slices the plane was advanced since the cine mode was
+      * started.
+      */
+    std::size_t cineFramesAdvanced() const;
+
+    /** \brief
+      * Tells how many of the \ref cineFramesAdvanced "advanced slices" were
+      * skipped because the frames were late.
+      */
+    std::size_t cineFramesDropped() const;
+
+    /** \brief
+      * Tells how many slices were sampled when they were about to be presented,
+      * instead of being prefetched, since the cine mode was started.
+      */
+    std::size_t cinePrefetchMisses() const;
 
 }; // MPRDisplay
 
@@ -0,0 +1,138 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#ifndef MPRDISPLAYPOOL_H_0874895466
+#define MPRDISPLAYPOOL_H_0874895466
+
+#include <Carna/qt/CarnaQt.h>
+#include <Carna/qt/MPRDisplay.h>
+#include <Carna/base/noncopyable.h>
+#include <memory>
+
+class QWidget;
+
+/** \file   MPRDisplayPool.h
+  * \brief  Defines \ref Carna::qt::MPRDisplayPool.
+  */
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// MPRDisplayPool
+// ----------------------------------------------------------------------------------
+
+/** \brief
+  * Keeps \ref MPRDisplay instances ready for reuse, s.t. changing the layout of
+  * the views does not re-create their renderers and rendering stages.
+  *
+  * The extra rendering stages of the configurator are queried once, when the pool
+  * is created. Each display, that the pool creates, gets clones of these stages.
+  * Displays, that are \ref release "released" to the pool, keep their renderers
+  * and are handed out again by \ref acquire:
+  *
+  * \code
+  * Carna::qt::MPRDisplayPool pool( cfg );
+  * pool.reserveWidgets( 4 );
+  * Carna::qt::MPRDisplay& front = pool.acquire( layoutWidget );
+  * front.setMPR( mpr );
+  * // ...
+  * pool.release( front );
+  * \endcode
+  *
+  * The settings of released displays, like the rotation, the windowing and the
+  * slab, are reset to their defaults, s.t. reused displays do not differ from
+  * newly created ones.
+  *
+  * Acquired displays might also be deleted instead of being released, e.g. by
+  * deleting their parent widget. The pool forgets such displays.
+  *
+  * \author Leonid Kostrykin
+  * \date   19.10.26
+  */
+class CARNAQT_LIB MPRDisplayPool
+{
+
+    NON_COPYABLE
+
+    struct Details;
+    const std::unique_ptr< Details > pimpl;
+
+public:
+
+    /** \brief
+      * Instantiates an empty pool, that creates its displays according to \a cfg.
+      */
+    explicit MPRDisplayPool( const MPRDisplay::Configurator& cfg );
+
+    /** \brief
+      * Deletes the displays, that are not acquired currently.
+      */
+    ~MPRDisplayPool();
+
+    /** \brief
+      * Holds the configuration of the displays of this pool.
+      */
+    const MPRDisplay::Parameters parameters;
+
+    /** \brief
+      * Creates display widgets until at least \a count displays are ready for
+      * \ref acquire "acquisition".
+      *
+      * This does not initialize any OpenGL resources. The renderer and the
+      * rendering stages of each display are created when it is shown for the
+      * first time, since a display creates them when it is resized.
+      */
+    void reserveWidgets( std::size_t count );
+
+    /** \brief
+      * Hands out a display, that was released before, or creates a new one if
+      * there is none. The display is made a child of \a parent. The caller takes
+      * the ownership, until the display is \ref release "released". The caller
+      * might also delete the display instead of releasing it.
+      */
+    MPRDisplay& acquire( QWidget* parent = nullptr );
+
+    /** \brief
+      * Takes the ownership of \a display and keeps it for reuse. The display is
+      * removed from its \ref MPR and render orchestrator, its cine mode is
+      * stopped, its settings are reset to their defaults, and it is hidden and
+      * removed from its parent.
+      *
+      * \pre \a display was \ref acquire "acquired" from this pool.
+      */
+    void release( MPRDisplay& display );
+
+    /** \brief
+      * Tells the number of displays, that are ready for \ref acquire "acquisition".
+      */
+    std::size_t idle() const;
+
+    /** \brief
+      * Tells the number of displays, that were created by this pool and were not
+      * deleted yet.
+      */
+    std::size_t created() const;
+
+}; // MPRDisplayPool
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
+
+#endif // MPRDISPLAYPOOL_H_0874895466
@@ -0,0 +1,123 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#ifndef PICKINGSTAGE_H_0874895466
+#define PICKINGSTAGE_H_0874895466
+
+#include <Carna/qt/CarnaQt.h>
+#include <Carna/base/GeometryStage.h>
+#include <Carna/base/Aggregation.h>
+#include <memory>
+
+/** \file   PickingStage.h
+  * \brief  Defines \ref Carna::qt::PickingStage.
+  */
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// PickingStage
+// ----------------------------------------------------------------------------------
+
+/** \brief
+  * Renders mesh-typed geometry color-coded to an offscreen buffer and resolves
+  * pick queries without stalling the rendering pipeline.
+  *
+  * The color-coded buffer is copied asynchronously to one of two pixel buffer
+  * objects after each frame. Pick queries are resolved using the most recent
+  * buffer, whose copy has completed. Hence \ref pick never waits for the GPU, but
+  * it might answer w.r.t. a frame that is slightly outdated, or it might not
+  * answer at all until the first copy has completed. Changes of the scene's tree
+  * structure discard the buffered results, since the geometry objects they refer
+  * to might have been deleted.
+  *
+  * The \ref Display uses this stage instead of `presets::MeshColorCodingStage`
+  * for drag-&-drop behaviour if it is found within the rendering stages sequence.
+  * It also enables hover picking in that case, see \ref Display::hovered.
+  *
+  * \author Leonid Kostrykin
+  * \date   19.10.26
+  */
+class CARNAQT_LIB PickingStage : public base::GeometryStage< void >
+{
+
+    NON_COPYABLE
+
+    struct Details;
+    const std::unique_ptr< Details > pimpl;
+
+public:
+
+    /** \brief
+      * Instantiates.
+      *
+      * \param geometryType is the type of the mesh-typed geometry.
+      * \param meshRole is the role of the meshes.
+      */
+    PickingStage( unsigned int geometryType, unsigned int meshRole );
+
+    /** \brief
+      * Deletes.
+      */
+    virtual ~PickingStage();
+
+    /** \brief
+      * Holds the role of the meshes.
+      */
+    const unsigned int meshRole;
+
+    virtual PickingStage* clone() const override;
+
+    virtual void prepareFrame( base::Node& root ) override;
+
+    virtual void reshape( base::FrameRenderer& fr, unsigned int width, unsigned int height ) override;
+
+    virtual void renderPass
+        ( const base::math::Matrix4f& viewTransform
+        , base::RenderTask& rt
+        , const base::Viewport& vp ) override;
+
+    /** \brief
+      * Tells whether a completed buffer is available to resolve pick queries.
+      * Requires the OpenGL context to be current.
+      */
+    bool isReady() const;
+
+    /** \brief
+      * Picks the geometry object at \a x and \a y w.r.t. the most recent completed
+      * buffer. The coordinates refer to the upper left corner of the render
+      * targets. Requires the OpenGL context to be current.
+      *
+      * Returns `base::Aggregation<const base::Geometry>::%NULL_PTR` if there is no
+      * geometry object at the given location or if no completed buffer is
+      * available yet.
+      */
+    base::Aggregation< const base::Geometry > pick( unsigned int x, unsigned int y ) const;
+
+protected:
+
+    virtual void render( const base::Renderable& ) override;
+
+}; // PickingStage
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
+
+#endif // PICKINGSTAGE_H_0874895466
@@ -0,0 +1,193 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#ifndef RENDERORCHESTRATOR_H_0874895466
+#define RENDERORCHESTRATOR_H_0874895466
+
+#include <Carna/qt/CarnaQt.h>
+#include <Carna/base/noncopyable.h>
+#include <QObject>
+#include <QEvent>
+#include <memory>
+
+/** \file   RenderOrchestrator.h
+  * \brief  Defines \ref Carna::qt::RenderOrchestrator.
+  */
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// RenderOrchestrator
+// ----------------------------------------------------------------------------------
+
+/** \brief
+  * Renders all \ref Display instances that are due back-to-back within a single
+  * pass, instead of each display rendering on its own from the event loop.
+  *
+  * A display that is \ref addDisplay "added" to the orchestrator does not post its
+  * repaint to the Qt message queue when it is \ref Display::invalidate
+  * "invalidated", but tells the orchestrator instead. All displays that become due
+  * until the event loop runs next are rendered within the same pass.
+  *
+  * Each display still renders within its own OpenGL context. The pass starts with
+  * the display whose context already is current, s.t. no context switch is
+  * required for it.
+  *
+  * The duration of each pass is measured and is reported through the
+  * \ref passRendered signal. By default, this is the time the CPU took for
+  * rendering all views, while the GPU works asynchronously. For debugging, the
+  * pass can be \ref setGPUTimeIncluded "made wait for the GPU" to finish each
+  * display, s.t. the total frame time of all views is measured:
+  *
+  * \code
+  * Carna::qt::RenderOrchestrator orchestrator;
+  * orchestrator.addDisplay( display3d );
+  * front.setRenderOrchestrator( orchestrator );
+  * left .setRenderOrchestrator( orchestrator );
+  * top  .setRenderOrchestrator( orchestrator );
+  * \endcode
+  *
+  * Before each pass, an event of type \ref PRE_PASS_EVENT is sent to each attached
+  * display. Event filters, that are installed on the displays, can apply input
+  * that was gathered since the last pass, s.t. the resulting scene changes are
+  * rendered by that pass. Use \ref requestPass if such input is pending, but no
+  * display is due yet.
+  *
+  * The lifetime of the orchestrator is independent from that of the displays.
+  *
+  * \author Leonid Kostrykin
+  * \date   19.10.26
+  */
+class CARNAQT_LIB RenderOrchestrator : public QObject
+{
+
+    Q_OBJECT
+    NON_COPYABLE
+
+    struct Details;
+    const std::unique_ptr< Details > pimpl;
+
+public:
+
+    /** \brief
+      * Instantiates.
+      */
+    RenderOrchestrator();
+
+    /** \brief
+      * Removes all displays.
+      */
+    virtual ~RenderOrchestrator();
+
+    /** \brief
+      * Holds the type of the events, that are sent to each attached display at
+      * the beginning of each pass, before the due displays are determined.
+      */
+    const static QEvent::Type PRE_PASS_EVENT;
+
+    /** \brief
+      * Adds \a display to this `%RenderOrchestrator`. This is equivalent to
+      * \ref Display::setRenderOrchestrator.
+      *
+      * If the \a display is attached to a different `%RenderOrchestrator`, it is
+      * \ref removeDisplay "removed" from that first.
+      */
+    void addDisplay( Display& display );
+
+    /** \brief
+      * Removes \a display from this `%RenderOrchestrator`. This is equivalent to
+      * \ref Display::removeFromRenderOrchestrator. The display renders on its own
+      * again afterwards.
+      *
+      * Nothing happens if \a display is not attached to this `%RenderOrchestrator`.
+      */
+    void removeDisplay( Display& display );
+
+    /** \brief
+      * Tells the number of attached displays.
+      */
+    std::size_t displays() const;
+
+    /** \brief
+      * Marks \a display due for the next pass. Invoked by \ref Display::invalidate.
+      * \pre \a display is attached to this `%RenderOrchestrator`.
+      */
+    void schedule( Display& display );
+
+    /** \brief
+      * Requests a pass, even if no display is due. The displays are sent the
+      * \ref PRE_PASS_EVENT nevertheless, but nothing is rendered if this does not
+      * make any display due.
+      */
+    void requestPass();
+
+    /** \brief
+      * Tells the number of passes rendered so far.
+      */
+    std::size_t passes() const;
+
+    /** \brief
+      * Tells the number of displays rendered by the last pass.
+      */
+    std::size_t lastPassDisplays() const;
+
+    /** \brief
+      * Tells the time in milliseconds that the last pass took for rendering all
+      * of its displays. This includes the time of the buffer swaps. It also
+      * includes the time the GPU took to finish the rendering commands of each
+      * display, if \ref setGPUTimeIncluded "enabled".
+      */
+    double lastPassTime() const;
+
+    /** \brief
+      * Sets whether each pass waits for the GPU to finish each display, s.t. the
+      * \ref lastPassTime "measured time" includes the GPU's work. This is
+      * disabled by default, since it stalls the CPU and hence defeats the
+      * batching of the displays. Enable it for debugging only.
+      */
+    void setGPUTimeIncluded( bool gpuTimeIncluded );
+
+    /** \brief
+      * Tells whether each pass waits for the GPU to finish each display.
+      */
+    bool isGPUTimeIncluded() const;
+
+public slots:
+
+    /** \brief
+      * Renders all displays that are due. Invoked from the event loop after a
+      * display was \ref schedule "scheduled".
+      */
+    void renderPass();
+
+signals:
+
+    /** \brief
+      * Emitted after each pass with the time in \a milliseconds that it took for
+      * rendering \a displays displays.
+      */
+    void passRendered( double milliseconds, unsigned int displays );
+
+}; // RenderOrchestrator
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
+
+#endif // RENDERORCHESTRATOR_H_0874895466
@@ -0,0 +1,164 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#ifndef RESLICER_H_0874895466
+#define RESLICER_H_0874895466
+
+#include <Carna/qt/CarnaQt.h>
+#include <Carna/base/noncopyable.h>
+#include <Carna/base/math.h>
+#include <Carna/base/HUVolume.h>
+#include <memory>
+
+/** \file   Reslicer.h
+  * \brief  Defines \ref Carna::qt::Reslicer.
+  */
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// Reslicer
+// ----------------------------------------------------------------------------------
+
+/** \brief
+  * Computes planar slices through volume data on the CPU, without requiring an
+  * OpenGL context.
+  *
+  * The volume is sampled by trilinear interpolation, like the `base::HUVolume`
+  * texture is sampled by `presets::CuttingPlanesStage` on the GPU. The
+  * interpolation is vectorized with SSE2 if available and the rows of a slice are
+  * distributed to multiple threads.
+  *
+  * The slices are specified by a transform from the slice's pixel coordinates to
+  * the *model space* of the volume, that is the unit cube centered in the origin
+  * whose corners are the centers of the corner voxels. This is the same space that
+  * the volume geometry is rendered in. Use \ref computeSliceTransform to derive the
+  * transform from the world transforms of the volume and a cutting plane:
+  *
+  * \code
+  * Carna::qt::Reslicer reslicer( *volume );
+  * const Carna::base::math::Matrix4f sliceTransform = Carna::qt::Reslicer::computeSliceTransform
+  *     ( volumeGeometry.worldTransform(), plane.worldTransform(), 512, 512, 0.5f );
+  * std::vector< unsigned char > pixels( 512 * 512 );
+  * reslicer.reslice( sliceTransform, 512, 512, windowingLevel, windowingWidth, pixels.data() );
+  * \endcode
+  *
+  * Samples outside the volume yield \ref BACKGROUND_HUV.
+  *
+  * \author Leonid Kostrykin
+  * \date   19.10.26
+  */
+class CARNAQT_LIB Reslicer
+{
+
+    NON_COPYABLE
+
+    struct Details;
+    const std::unique_ptr< Details > pimpl;
+
+public:
+
+    /** \brief
+      * Holds the HUV that samples outside the volume yield.
+      */
+    const static signed short BACKGROUND_HUV;
+
+    /** \brief
+      * Instantiates. The voxels of \a volume are copied, s.t. \a volume is not
+      * referenced any longer afterwards.
+      *
+      * \pre The edge lengths of \a volume are at least \f$2\f$.
+      */
+    explicit Reslicer( const base::HUVolume& volume );
+
+    /** \brief
+      * Deletes.
+      */
+    ~Reslicer();
+
+    /** \brief
+      * Tells the resolution of the volume.
+      */
+    const base::math::Vector3ui& size() const;
+
+    /** \brief
+      * Sets the number of threads that a slice is computed with. The default is
+      * the number of logical processors.
+      *
+      * \pre `threads > 0`
+      */
+    void setThreads( unsigned int threads );
+
+    /** \brief
+      * Tells the number of threads that a slice is computed with.
+      */
+    unsigned int threads() const;
+
+    /** \brief
+      * Computes the transform from the pixel coordinates of a slice to the model
+      * space of the volume.
+      *
+      * The slice lies within the x/y-plane of \a planeWorldTransform and is
+      * centered in its origin. The x-axis points rightwards and the y-axis points
+      * upwards, as seen by a camera that looks along the negative z-axis. The
+      * image is \a width times \a height pixels large, where each pixel covers
+      * \a pixelSize millimeters. The pixels are sampled at their centers and the
+      * rows are ordered top-down.
+      */
+    static base::math::Matrix4f computeSliceTransform
+        ( const base::math::Matrix4f& volumeWorldTransform
+        , const base::math::Matrix4f& planeWorldTransform
+        , unsigned int width
+        , unsigned int height
+        , float pixelSize );
+
+    /** \brief
+      * Computes the slice given by \a sliceTransform and writes the raw HUV of
+      * each pixel to \a huvs, that must hold `width * height` values.
+      */
+    void reslice( const base::math::Matrix4f& sliceTransform, unsigned int width, unsigned int height, signed short* huvs ) const;
+
+    /** \brief
+      * Computes the slice given by \a sliceTransform and writes the intensity of
+      * each pixel to \a intensities, that must hold `width * height` values. The
+      * HUV are mapped to intensities like `presets::CuttingPlanesStage` does it,
+      * i.e. linearly from \f$0\f$ at `windowingLevel - windowingWidth / 2` to
+      * \f$255\f$ at `windowingLevel + windowingWidth / 2`.
+      */
+    void reslice
+        ( const base::math::Matrix4f& sliceTransform
+        , unsigned int width
+        , unsigned int height
+        , base::HUV windowingLevel
+        , unsigned int windowingWidth
+        , unsigned char* intensities ) const;
+
+    /** \brief
+      * Samples the volume at \a count arbitrary \a positions, given in the model
+      * space of the volume, and writes the interpolated HUV to \a huvs.
+      */
+    void sample( const base::math::Vector3f* positions, std::size_t count, float* huvs ) const;
+
+}; // Reslicer
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
+
+#endif // RESLICER_H_0874895466
@@ -0,0 +1,102 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#ifndef SHADERCACHE_H_0874895466
+#define SHADERCACHE_H_0874895466
+
+#include <Carna/qt/CarnaQt.h>
+#include <QString>
+#include <QByteArray>
+
+/** \file   ShaderCache.h
+  * \brief  Defines \ref Carna::qt::ShaderCache.
+  */
+
+namespace Carna
+{
+
+namespace qt
+{
+
+struct ShaderResources;
+
+
+
+// ----------------------------------------------------------------------------------
+// ShaderCache
+// ----------------------------------------------------------------------------------
+
+/** \brief
+  * Persists the linked shader programs of this library on disk, s.t. they need
+  * not to be compiled again when the application is started the next time.
+  *
+  * The binaries are stored per shader and are keyed by a hash of its sources and
+  * the vendor, renderer and version strings of the driver. A binary that is
+  * missing, outdated or rejected by the driver is replaced by compiling the
+  * shader from its sources. The shaders of the `presets` stages from base %Carna
+  * are not covered, because they are linked by base %Carna.
+  *
+  * The cache is disabled if the driver does not support program binaries or if
+  * the \ref setDirectory "directory" is empty.
+  *
+  * \author Leonid Kostrykin
+  * \date   19.10.26
+  */
+class CARNAQT_LIB ShaderCache
+{
+
+    friend struct ShaderResources;
+
+    struct Details;
+    ShaderCache();
+
+    static bool load( const QString& key, unsigned int& format, QByteArray& binary );
+    static void store( const QString& key, unsigned int format, const QByteArray& binary );
+    static void recordLink( bool fromCache );
+
+public:
+
+    /** \brief
+      * Sets the \a directory the binaries are stored in. The default is the
+      * `shaders` subdirectory of the application's cache location. An empty
+      * \a directory disables the cache.
+      */
+    static void setDirectory( const QString& directory );
+
+    /** \brief
+      * Tells the directory the binaries are stored in.
+      */
+    static const QString& directory();
+
+    /** \brief
+      * Removes all stored binaries.
+      */
+    static void clear();
+
+    /** \brief
+      * Tells how many shader programs were linked from stored binaries.
+      */
+    static std::size_t hits();
+
+    /** \brief
+      * Tells how many shader programs were compiled from their sources.
+      */
+    static std::size_t misses();
+
+}; // ShaderCache
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
+
+#endif // SHADERCACHE_H_0874895466
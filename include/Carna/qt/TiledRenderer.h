@@ -0,0 +1,199 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#ifndef TILEDRENDERER_H_0874895466
+#define TILEDRENDERER_H_0874895466
+
+#include <Carna/qt/CarnaQt.h>
+#include <Carna/base/noncopyable.h>
+#include <QString>
+#include <memory>
+
+class QImage;
+
+/** \file   TiledRenderer.h
+  * \brief  Defines \ref Carna::qt::TiledRenderer.
+  */
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// TiledRenderer
+// ----------------------------------------------------------------------------------
+
+/** \brief
+  * Renders images of arbitrary resolution with the frame renderer of a
+  * \ref Display by splitting them into tiles.
+  *
+  * Each tile is rendered through the same stages as the display, using a
+  * projection matrix that is restricted to the tile's sub-frustum. The tiles are
+  * passed to a \ref TileSink as soon as they are finished, s.t. neither the video
+  * memory nor the system memory must hold the whole image at once:
+  *
+  * \code
+  * Carna::qt::TiledRenderer tiledRenderer( display );
+  * Carna::qt::TiledRenderer::TileFileSink sink( "poster" );
+  * tiledRenderer.render( 16384, 16384, sink );
+  * \endcode
+  *
+  * If the display has a \ref Display::setProjectionControl "projection control",
+  * the projection is updated to the image's side lengths ratio temporarily.
+  * Otherwise the camera's projection is used as-is.
+  *
+  * \author Leonid Kostrykin
+  * \date   19.10.26
+  */
+class CARNAQT_LIB TiledRenderer
+{
+
+    NON_COPYABLE
+
+    struct Details;
+    const std::unique_ptr< Details > pimpl;
+
+public:
+
+    /** \brief
+      * Holds the default maximum edge length of the tiles in pixels.
+      */
+    const static unsigned int DEFAULT_TILE_SIZE;
+
+    // ------------------------------------------------------------------------------
+    // TiledRenderer :: TileSink
+    // ------------------------------------------------------------------------------
+
+    /** \brief
+      * Receives the tiles rendered by a \ref TiledRenderer.
+      *
+      * \author Leonid Kostrykin
+      * \date   19.10.26
+      */
+    class CARNAQT_LIB TileSink
+    {
+
+    public:
+
+        /** \brief
+          * Does nothing.
+          */
+        virtual ~TileSink();
+
+        /** \brief
+          * Notifies that an image of \a width and \a height is to be rendered, that
+          * is split into \a columns and \a rows tiles.
+          */
+        virtual void begin( unsigned int width, unsigned int height, unsigned int columns, unsigned int rows );
+
+        /** \brief
+          * Receives the \a tile at \a column and \a row, whose upper left corner is
+          * located at \a left and \a top within the image.
+          */
+        virtual void write
+            ( unsigned int column, unsigned int row
+            , unsigned int left, unsigned int top
+            , const QImage& tile ) = 0;
+
+        /** \brief
+          * Notifies that all tiles have been written.
+          */
+        virtual void finish();
+
+    }; // TiledRenderer :: TileSink
+
+    // ------------------------------------------------------------------------------
+    // TiledRenderer :: TileFileSink
+    // ------------------------------------------------------------------------------
+
+    /** \brief
+      * Writes each tile to an image file named `<prefix>_<row>_<column>.<format>`.
+      *
+      * \author Leonid Kostrykin
+      * \date   19.10.26
+      */
+    class CARNAQT_LIB TileFileSink : public TileSink
+    {
+
+    public:
+
+        /** \brief
+          * Instantiates.
+          *
+          * \param prefix is the path prefix of the written files.
+          * \param format is the image file format, that must be supported by `QImage`.
+          */
+        explicit TileFileSink( const QString& prefix, const QString& format = "png" );
+
+        /** \brief
+          * Holds the path prefix of the written files.
+          */
+        const QString prefix;
+
+        /** \brief
+          * Holds the image file format.
+          */
+        const QString format;
+
+        /** \brief
+          * Tells the path of the file that the tile at \a column and \a row is
+          * written to.
+          */
+        QString fileName( unsigned int column, unsigned int row ) const;
+
+        virtual void write
+            ( unsigned int column, unsigned int row
+            , unsigned int left, unsigned int top
+            , const QImage& tile ) override;
+
+    }; // TiledRenderer :: TileFileSink
+
+    // ------------------------------------------------------------------------------
+
+    /** \brief
+      * Instantiates.
+      *
+      * \param display is the display whose camera and frame renderer are used.
+      * \param tileSize is the maximum edge length of the tiles in pixels.
+      */
+    explicit TiledRenderer( Display& display, unsigned int tileSize = DEFAULT_TILE_SIZE );
+
+    /** \brief
+      * Deletes.
+      */
+    ~TiledRenderer();
+
+    /** \brief
+      * Tells the maximum edge length of the tiles in pixels.
+      */
+    unsigned int tileSize() const;
+
+    /** \brief
+      * Renders an image of \a width and \a height and passes its tiles to \a sink.
+      * The display is \ref Display::invalidate "invalidated" afterwards.
+      *
+      * \pre `Display::hasRenderer() == true` and `Display::hasCamera() == true`
+      */
+    void render( unsigned int width, unsigned int height, TileSink& sink );
+
+}; // TiledRenderer
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
+
+#endif // TILEDRENDERER_H_0874895466
@@ -0,0 +1,179 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#ifndef VOLUMEUPLOADSCHEDULER_H_0874895466
+#define VOLUMEUPLOADSCHEDULER_H_0874895466
+
+#include <Carna/qt/CarnaQt.h>
+#include <Carna/base/noncopyable.h>
+#include <QObject>
+#include <memory>
+
+/** \file   VolumeUploadScheduler.h
+  * \brief  Defines \ref Carna::qt::VolumeUploadScheduler.
+  */
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// VolumeUploadScheduler
+// ----------------------------------------------------------------------------------
+
+/** \brief
+  * Streams the volume textures of a scene to video memory over several frames
+  * instead of uploading them all at once when the first frame is rendered.
+  *
+  * Each \ref enqueue "enqueued" volume segment has its `base::ManagedTexture3D`
+  * feature replaced by a placeholder texture that holds a single voxel of zero
+  * intensity. The segment data is then copied through pixel buffer objects into a
+  * texture of the original size and format, where not more than
+  * \ref bytesPerFrame bytes are uploaded per frame. As soon as a segment is
+  * complete, the streamed texture is put in place of the placeholder.
+  *
+  * Streaming is driven by a \ref Display that the scheduler is
+  * \ref Display::setUploadScheduler "attached" to. The display invokes
+  * \ref process before it renders each frame and keeps on invalidating itself
+  * until the scheduler \ref isDone "is done".
+  *
+  * Segments, that are removed from their parents or deleted together with their
+  * parents before they are streamed completely, are dropped. Removed segments
+  * get their original textures back.
+  *
+  * \note
+  * The data referenced by the enqueued textures must remain valid until the
+  * scheduler is done. This is the same requirement that `base::ManagedTexture3D`
+  * already imposes.
+  *
+  * \author Leonid Kostrykin
+  * \date   19.10.26
+  */
+class CARNAQT_LIB VolumeUploadScheduler : public QObject
+{
+
+    Q_OBJECT
+    NON_COPYABLE
+
+    struct Details;
+    const std::unique_ptr< Details > pimpl;
+
+public:
+
+    /** \brief
+      * Holds the default number of bytes to be uploaded per frame.
+      */
+    const static std::size_t DEFAULT_BYTES_PER_FRAME;
+
+    /** \brief
+      * Instantiates.
+      *
+      * \param geometryTypeVolume is the geometry type of the volume segments.
+      * \param roleHUVolume is the role of the segment textures.
+      */
+    VolumeUploadScheduler( unsigned int geometryTypeVolume, unsigned int roleHUVolume );
+
+    /** \brief
+      * Puts the original textures back in place of the placeholders of the
+      * segments that are not streamed completely yet, and releases the streamed
+      * textures that are still held by this scheduler.
+      *
+      * The OpenGL context that \ref process was invoked with is made current for
+      * this purpose, hence it must still be alive.
+      */
+    virtual ~VolumeUploadScheduler();
+
+    /** \brief
+      * Holds the geometry type of the volume segments.
+      */
+    const unsigned int geometryTypeVolume;
+
+    /** \brief
+      * Holds the role of the segment textures.
+      */
+    const unsigned int roleHUVolume;
+
+    /** \brief
+      * Sets the number of bytes to be uploaded per frame. At least one slice of a
+      * segment is uploaded per frame, regardless of this limit.
+      */
+    void setBytesPerFrame( std::size_t bytesPerFrame );
+
+    /** \brief
+      * Tells the number of bytes to be uploaded per frame.
+      */
+    std::size_t bytesPerFrame() const;
+
+    /** \brief
+      * Enqueues all volume segments beneath \a root for streaming and replaces
+      * their textures by placeholders.
+      *
+      * Segments that are already enqueued or resident are skipped.
+      */
+    void enqueue( base::Node& root );
+
+    /** \brief
+      * Uploads the next chunk of data. Must be invoked with the OpenGL context
+      * current that the volume is rendered with.
+      */
+    void process();
+
+    /** \brief
+      * Tells whether all enqueued segments are resident.
+      */
+    bool isDone() const;
+
+    /** \brief
+      * Tells whether the texture of \a segment is resident or whether the
+      * placeholder is still shown.
+      */
+    bool isResident( const base::Geometry& segment ) const;
+
+    /** \brief
+      * Tells the number of enqueued segments, including those that are resident.
+      */
+    std::size_t segments() const;
+
+    /** \brief
+      * Tells the number of enqueued segments whose textures are resident.
+      */
+    std::size_t residentSegments() const;
+
+    /** \brief
+      * Tells the ratio of uploaded bytes to the total number of enqueued bytes.
+      */
+    float progress() const;
+
+signals:
+
+    /** \brief
+      * Emitted each time a chunk of data is uploaded.
+      */
+    void progressChanged( float progress );
+
+    /** \brief
+      * Emitted when the last enqueued segment becomes resident.
+      */
+    void finished();
+
+}; // VolumeUploadScheduler
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
+
+#endif // VOLUMEUPLOADSCHEDULER_H_0874895466
@@ -0,0 +1,101 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#ifndef FRAMEACCUMULATOR_H_0874895466
+#define FRAMEACCUMULATOR_H_0874895466
+
+#include <Carna/qt/CarnaQt.h>
+#include <Carna/base/noncopyable.h>
+#include <memory>
+
+/** \file   FrameAccumulator.h
+  * \brief  Defines \ref Carna::qt::FrameAccumulator.
+  */
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// FrameAccumulator
+// ----------------------------------------------------------------------------------
+
+/** \brief
+  * Averages multiple renderings of the same frame within a floating point buffer.
+  *
+  * Each sample is rendered to the \ref sampleFramebuffer and then added to the
+  * running average by \ref accumulate. Requires the OpenGL context to be current
+  * during all operations, including destruction.
+  */
+class FrameAccumulator
+{
+
+    NON_COPYABLE
+
+    struct Details;
+    const std::unique_ptr< Details > pimpl;
+
+public:
+
+    /** \brief
+      * Instantiates with buffers of \a width and \a height.
+      */
+    FrameAccumulator( unsigned int width, unsigned int height );
+
+    /** \brief
+      * Deletes.
+      */
+    ~FrameAccumulator();
+
+    /** \brief
+      * Resizes the buffers and \ref reset "resets".
+      */
+    void reshape( unsigned int width, unsigned int height );
+
+    /** \brief
+      * Discards all accumulated samples.
+      */
+    void reset();
+
+    /** \brief
+      * Tells the number of accumulated samples.
+      */
+    unsigned int samples() const;
+
+    /** \brief
+      * References the framebuffer the next sample is to be rendered to.
+      */
+    base::Framebuffer& sampleFramebuffer();
+
+    /** \brief
+      * Adds the contents of the \ref sampleFramebuffer to the running average.
+      */
+    void accumulate();
+
+    /** \brief
+      * Draws the running average to the currently bound framebuffer. The buffers
+      * are mapped one-to-one to \a rootViewport.
+      */
+    void present( const base::Viewport& rootViewport );
+
+}; // FrameAccumulator
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
+
+#endif // FRAMEACCUMULATOR_H_0874895466
@@ -43,6 +43,10 @@ public:
     
     base::Color color;
     
+    /* Tells whether the plane is being dragged currently.
+     */
+    bool isMoving;
+    
     virtual bool controlsSameVideoResource( const GeometryFeature& other ) const override;
     
     virtual ManagedInterface* acquireVideoResource() override;
@@ -0,0 +1,77 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#ifndef SHADERRESOURCES_H_0874895466
+#define SHADERRESOURCES_H_0874895466
+
+#include <Carna/qt/CarnaQt.h>
+#include <string>
+#include <vector>
+
+/** \file   ShaderResources.h
+  * \brief  Defines \ref Carna::qt::ShaderResources.
+  */
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// ShaderResources
+// ----------------------------------------------------------------------------------
+
+/** \brief
+  * Supplies the `base::ShaderManager` with the shader sources that are compiled
+  * into this library as Qt resources, and links them from the \ref ShaderCache
+  * if possible.
+  */
+struct ShaderResources
+{
+    /** \brief
+      * Reads the Qt resource \a name.
+      */
+    static std::string read( const std::string& name );
+    
+    /** \brief
+      * Lists the names of all shader programs, whose vertex shaders are compiled
+      * into this library.
+      */
+    static std::vector< std::string > names();
+    
+    /** \brief
+      * Acquires the shader program \a shaderName from the `base::ShaderManager`,
+      * whose vertex and fragment shaders are located at
+      * `:/shaders/<shaderName>.vert` and `:/shaders/<shaderName>.frag`
+      * respectively.
+      *
+      * When the program is created, it is linked from the binary stored by the
+      * \ref ShaderCache. If there is no valid binary, the program is compiled
+      * from the sources and its binary is stored.
+      */
+    static const base::ShaderProgram& acquire( const std::string& shaderName );
+    
+    /** \brief
+      * Releases \a shader, that was \ref acquire "acquired" before.
+      */
+    static void release( const base::ShaderProgram& shader );
+};
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
+
+#endif // SHADERRESOURCES_H_0874895466
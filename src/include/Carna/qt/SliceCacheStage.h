@@ -0,0 +1,228 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#ifndef SLICECACHESTAGE_H_0874895466
+#define SLICECACHESTAGE_H_0874895466
+
+#include <Carna/qt/CarnaQt.h>
+#include <Carna/qt/MPRDisplay.h>
+#include <Carna/qt/GeometryConsumer.h>
+#include <Carna/base/RenderStage.h>
+#include <memory>
+
+/** \file   SliceCacheStage.h
+  * \brief  Defines \ref Carna::qt::SliceCacheStage.
+  */
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// SliceCacheStage
+// ----------------------------------------------------------------------------------
+
+/** \brief
+  * Renders the cutting planes like `presets::CuttingPlanesStage`, but caches the
+  * sampled HUV, s.t. changing the windowing does not require the volume to be
+  * sampled again.
+  *
+  * The planes are rendered by an internal `presets::CuttingPlanesStage` to an
+  * offscreen floating point buffer, that holds the raw HUV and the depth of each
+  * pixel. The buffer is mapped to the frame by a windowing pass afterwards. The
+  * volume is sampled again only if the view, the projection, the viewport, the
+  * world transforms of the planes or the volume geometries, or the textures of
+  * the volume geometries have changed. Use \ref invalidate if the volume data has
+  * changed otherwise.
+  *
+  * If a \ref setSlabThickness "slab thickness" is set, the planes are rendered
+  * multiple times, displaced along their normals, and the samples are projected
+  * by blending, according to the \ref setSlabMode "slab mode". The samples are
+  * taken coarser while any plane, whose `MPRDataFeature` tells that it is moving,
+  * is part of the scene.
+  *
+  * The cache can hold multiple slices. If a plane is \ref setPrefetch "set for
+  * prefetching", the slices ahead of it are sampled speculatively after each
+  * frame, s.t. advancing the plane step by step only requires the windowing
+  * pass as long as it stays within the prefetched range. The prefetching does not
+  * delay the frame: It is done once the event loop is reached, i.e. after the
+  * frame was presented.
+  *
+  * If \ref setFusedVolumes "multiple volumes" are fused, each of them is sampled
+  * to a distinct channel of the buffer. A single pass samples up to eight volume
+  * segments. Volumes, that are split into more segments, are sampled by multiple
+  * passes, whose results are combined by blending. The windowing pass blends the
+  * channels then.
+  *
+  * The volume and the planes geometries are reported as consumed, s.t. the
+  * \ref Display skips repaints for changes of unrelated geometry.
+  */
+class SliceCacheStage : public base::RenderStage, public GeometryConsumer
+{
+
+    NON_COPYABLE
+
+    struct Details;
+    const std::unique_ptr< Details > pimpl;
+
+public:
+
+    /** \brief
+      * Instantiates.
+      */
+    SliceCacheStage( unsigned int geometryTypeVolume, unsigned int geometryTypePlanes );
+
+    /** \brief
+      * Deletes.
+      */
+    virtual ~SliceCacheStage();
+
+    /** \brief
+      * Holds the type of the volume geometries.
+      */
+    const unsigned int geometryTypeVolume;
+
+    /** \brief
+      * Holds the type of the planes geometries.
+      */
+    const unsigned int geometryTypePlanes;
+
+    virtual SliceCacheStage* clone() const override;
+
+    virtual void addConsumedGeometryTypes( std::set< unsigned int >& types ) const override;
+
+    virtual void reshape( base::FrameRenderer& fr, unsigned int width, unsigned int height ) override;
+
+    virtual bool isInitialized() const override;
+
+    virtual void prepareFrame( base::Node& root ) override;
+
+    virtual void renderPass
+        ( const base::math::Matrix4f& viewTransform
+        , base::RenderTask& rt
+        , const base::Viewport& vp ) override;
+
+    /** \brief
+      * Sets the HUV that is mapped to the mid-intensity.
+      */
+    void setWindowingLevel( base::HUV windowingLevel );
+
+    /** \brief
+      * Sets the width of the HUV range that is mapped to the intensities.
+      */
+    void setWindowingWidth( unsigned int windowingWidth );
+
+    /** \brief
+      * Tells the HUV that is mapped to the mid-intensity.
+      */
+    base::HUV windowingLevel() const;
+
+    /** \brief
+      * Tells the width of the HUV range that is mapped to the intensities.
+      */
+    unsigned int windowingWidth() const;
+
+    /** \brief
+      * Tells the HUV that is mapped to the lowest intensity.
+      */
+    base::HUV minimumHUV() const;
+
+    /** \brief
+      * Tells the HUV that is mapped to the highest intensity.
+      */
+    base::HUV maximumHUV() const;
+
+    /** \brief
+      * Sets the thickness of the slab around the planes in millimeters.
+      */
+    void setSlabThickness( float thickness );
+
+    /** \brief
+      * Tells the thickness of the slab around the planes in millimeters.
+      */
+    float slabThickness() const;
+
+    /** \brief
+      * Sets how the samples across the slab are projected.
+      */
+    void setSlabMode( MPRDisplay::SlabMode mode );
+
+    /** \brief
+      * Tells how the samples across the slab are projected.
+      */
+    MPRDisplay::SlabMode slabMode() const;
+
+    /** \brief
+      * Sets the distance between the samples of the slab in millimeters.
+      */
+    void setSlabStep( float step );
+
+    /** \brief
+      * Tells the distance between the samples of the slab in millimeters.
+      */
+    float slabStep() const;
+
+    /** \brief
+      * Sets the distance between the samples of the slab in millimeters while any
+      * plane is moving.
+      */
+    void setInteractiveSlabStep( float step );
+
+    /** \brief
+      * Tells the distance between the samples of the slab in millimeters while any
+      * plane is moving.
+      */
+    float interactiveSlabStep() const;
+
+    /** \brief
+      * Prefetches the next \a count slices, that \a plane reaches when its
+      * `base::Spatial::localTransform` is multiplied by a translation of \a step
+      * along its z-axis repeatedly. The cache holds `count + 1` slices then.
+      * Prefetching is disabled if \a plane is `nullptr`.
+      */
+    void setPrefetch( base::Geometry* plane, float step, unsigned int count );
+
+    /** \brief
+      * Tells how many slices were sampled speculatively.
+      */
+    std::size_t prefetches() const;
+
+    /** \brief
+      * Sets the volumes to be fused. The volumes are blended if there are more
+      * than one, otherwise the \ref setWindowingLevel "windowing" of this stage
+      * is used.
+      */
+    void setFusedVolumes( const std::vector< MPRDisplay::FusedVolume >& volumes );
+
+    /** \brief
+      * Discards the cached HUV, s.t. the volume is sampled again when the next
+      * frame is rendered.
+      */
+    void invalidate();
+
+    /** \brief
+      * Tells how many times the volume was sampled.
+      */
+    std::size_t samplings() const;
+
+}; // SliceCacheStage
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
+
+#endif // SLICECACHESTAGE_H_0874895466
@@ -10,10 +10,19 @@
  */
 
 #include <Carna/qt/Application.h>
+#include <Carna/qt/Display.h>
+#include <Carna/qt/ShaderResources.h>
 #include <Carna/base/CarnaException.h>
+#include <Carna/base/ShaderManager.h>
+#include <Carna/base/GLContext.h>
 #include <Carna/base/Log.h>
 #include <QMessageBox>
 #include <QPushButton>
+#include <QGLWidget>
+#include <QGLContext>
+#include <QGLFormat>
+#include <QElapsedTimer>
+#include <sstream>
 
 namespace Carna
 {
@@ -64,12 +73,63 @@ void QDebugLogWriter::writeLine( base::Log::Severity severity, const std::string
 
 
 
+// ----------------------------------------------------------------------------------
+// Application :: Details
+// ----------------------------------------------------------------------------------
+
+struct Application::Details
+{
+    Details();
+    
+    typedef base::QGLContextAdapter< QGLContext, QGLFormat > GLContext;
+    
+    std::unique_ptr< QGLWidget > warmUpWidget;
+    std::unique_ptr< GLContext > warmUpContext;
+    std::vector< const base::ShaderProgram* > shaders;
+    std::vector< const base::ShaderProgram* > presetShaders;
+    double warmUpTime;
+    
+    void releaseShaders();
+};
+
+
+Application::Details::Details()
+    : warmUpTime( -1 )
+{
+}
+
+
+void Application::Details::releaseShaders()
+{
+    if( warmUpWidget.get() == nullptr )
+    {
+        return;
+    }
+    warmUpWidget->makeCurrent();
+    for( auto shaderItr = shaders.begin(); shaderItr != shaders.end(); ++shaderItr )
+    {
+        ShaderResources::release( **shaderItr );
+    }
+    for( auto shaderItr = presetShaders.begin(); shaderItr != presetShaders.end(); ++shaderItr )
+    {
+        base::ShaderManager::instance().releaseShader( **shaderItr );
+    }
+    shaders.clear();
+    presetShaders.clear();
+    warmUpContext.reset();
+    Display::setSharingWidget( nullptr );
+    warmUpWidget.reset();
+}
+
+
+
 // ----------------------------------------------------------------------------------
 // Application
 // ----------------------------------------------------------------------------------
 
 Application::Application( int& argc, char** argv )
     : QApplication( argc, argv )
+    , pimpl( new Details() )
 {
     base::Log::instance().setWriter( new QDebugLogWriter() );
 }
@@ -77,6 +137,8 @@ Application::Application( int& argc, char** argv )
 
 Application::~Application()
 {
+    pimpl->releaseShaders();
+
     /* We need to do this as long as 'QApplication' is still alive, s.t. 'QDebug' is
      * also still available.
      */
@@ -153,6 +215,52 @@ bool Application::notify( QObject* receiver, QEvent* ev )
 }
 
 
+void Application::warmUpShaders( const std::vector< std::string >& presetShaders )
+{
+    CARNA_ASSERT( !hasWarmedUpShaders() );
+    QElapsedTimer clock;
+    clock.start();
+
+    /* The widget is never shown, it only provides the context that the displays
+     * share the programs with.
+     */
+    pimpl->warmUpWidget.reset( new QGLWidget( Details::GLContext::desiredFormat() ) );
+    CARNA_ASSERT_EX( pimpl->warmUpWidget->isValid(), "Failed to create OpenGL context for shader warm-up." );
+    Display::setSharingWidget( pimpl->warmUpWidget.get() );
+    pimpl->warmUpWidget->makeCurrent();
+    pimpl->warmUpContext.reset( new Details::GLContext() );
+
+    const std::vector< std::string > shaderNames = ShaderResources::names();
+    for( auto nameItr = shaderNames.begin(); nameItr != shaderNames.end(); ++nameItr )
+    {
+        pimpl->shaders.push_back( &ShaderResources::acquire( *nameItr ) );
+    }
+    for( auto nameItr = presetShaders.begin(); nameItr != presetShaders.end(); ++nameItr )
+    {
+        pimpl->presetShaders.push_back( &base::ShaderManager::instance().acquireShader( *nameItr ) );
+    }
+    pimpl->warmUpTime = clock.nsecsElapsed() / 1e6;
+
+    std::stringstream msg;
+    msg << "Warmed up " << ( pimpl->shaders.size() + pimpl->presetShaders.size() )
+        << " shader programs in " << pimpl->warmUpTime << " ms.";
+    base::Log::instance().record( base::Log::debug, msg.str() );
+}
+
+
+bool Application::hasWarmedUpShaders() const
+{
+    return pimpl->warmUpTime >= 0;
+}
+
+
+double Application::shaderWarmUpTime() const
+{
+    CARNA_ASSERT( hasWarmedUpShaders() );
+    return pimpl->warmUpTime;
+}
+
+
 
 }  // namespace Carna :: qt
 
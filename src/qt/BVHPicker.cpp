@@ -0,0 +1,532 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#include <Carna/qt/BVHPicker.h>
+#include <Carna/base/Node.h>
+#include <Carna/base/Geometry.h>
+#include <Carna/base/BoundingBox.h>
+#include <Carna/base/Camera.h>
+#include <Carna/base/Viewport.h>
+#include <vector>
+#include <map>
+#include <functional>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// BVHPicker :: Details
+// ----------------------------------------------------------------------------------
+
+struct BVHPicker::Details
+{
+    Details( BVHPicker& self, base::Node& root );
+    BVHPicker& self;
+
+    base::Node* root;
+    bool isRebuildRequired;
+    bool isRefitRequired;
+    std::size_t rebuilds;
+    std::size_t refits;
+    std::size_t lastRefitNodes;
+    
+    /* The subtrees, that were invalidated since the last update. Only the items
+     * beneath these, their leafs and the ancestors of the leafs are refitted.
+     */
+    std::vector< base::Node* > dirtySubtrees;
+
+    struct Item
+    {
+        const base::Geometry* geometry;
+        base::math::Matrix4f boxTransform;
+        base::math::Vector3f halfSize;
+        base::math::Vector3f min;
+        base::math::Vector3f max;
+        void update();
+    };
+
+    struct TreeNode
+    {
+        base::math::Vector3f min;
+        base::math::Vector3f max;
+        std::size_t left;   ///< Index of the left child or of the first item if leaf.
+        std::size_t right;  ///< Index of the right child or the number of items if leaf.
+        std::size_t parent; ///< Index of the parent or `NO_PARENT` if root.
+        bool isLeaf;
+        bool isDirty;
+    };
+
+    const static std::size_t NO_PARENT = static_cast< std::size_t >( -1 );
+
+    const static std::size_t MAX_LEAF_SIZE = 4;
+
+    std::vector< Item > items;
+    std::vector< std::size_t > order;
+    std::vector< TreeNode > nodes;
+    std::vector< std::size_t > stack;
+    std::map< const base::Geometry*, std::size_t > itemIndices;
+    std::vector< std::size_t > leafOf;
+    std::vector< std::size_t > dirtyNodes;
+
+    void update();
+    void rebuild();
+    void refit();
+    void markDirty( std::size_t itemIdx );
+    std::size_t build( std::size_t first, std::size_t count, std::size_t parent );
+    void fitLeaf( TreeNode& node ) const;
+
+    static bool intersectBox
+        ( const base::math::Vector3f& min
+        , const base::math::Vector3f& max
+        , const base::math::Vector3f& origin
+        , const base::math::Vector3f& direction
+        , float& tNear
+        , float tMax );
+};
+
+
+BVHPicker::Details::Details( BVHPicker& self, base::Node& root )
+    : self( self )
+    , root( &root )
+    , isRebuildRequired( true )
+    , isRefitRequired( false )
+    , rebuilds( 0 )
+    , refits( 0 )
+    , lastRefitNodes( 0 )
+{
+}
+
+
+void BVHPicker::Details::Item::update()
+{
+    const base::BoundingBox& box = static_cast< const base::BoundingBox& >( geometry->boundingVolume() );
+    boxTransform = geometry->worldTransform() * box.transform();
+    halfSize = box.size() / 2;
+
+    /* Compute the axis-aligned bounds of the oriented box.
+     */
+    const base::math::Vector3f center = boxTransform.block< 3, 1 >( 0, 3 );
+    for( unsigned int i = 0; i < 3; ++i )
+    {
+        float extent = 0;
+        for( unsigned int j = 0; j < 3; ++j )
+        {
+            extent += std::abs( boxTransform( i, j ) ) * halfSize[ j ];
+        }
+        min[ i ] = center[ i ] - extent;
+        max[ i ] = center[ i ] + extent;
+    }
+}
+
+
+void BVHPicker::Details::update()
+{
+    if( root == nullptr )
+    {
+        items.clear();
+        nodes.clear();
+        dirtySubtrees.clear();
+        return;
+    }
+    if( isRebuildRequired )
+    {
+        rebuild();
+    }
+    else
+    if( isRefitRequired )
+    {
+        refit();
+    }
+}
+
+
+void BVHPicker::Details::rebuild()
+{
+    root->updateWorldTransform();
+    items.clear();
+    const unsigned int geometryType = self.geometryType;
+    std::vector< Item >& items = this->items;
+    root->visitChildren( true, [geometryType, &items]( const base::Spatial& spatial )
+        {
+            const base::Geometry* const geom = dynamic_cast< const base::Geometry* >( &spatial );
+            if( geom != nullptr && geom->geometryType == geometryType && geom->hasBoundingVolume()
+                && dynamic_cast< const base::BoundingBox* >( &geom->boundingVolume() ) != nullptr )
+            {
+                Item item;
+                item.geometry = geom;
+                item.update();
+                items.push_back( item );
+            }
+        }
+    );
+
+    order.resize( items.size() );
+    leafOf.resize( items.size() );
+    itemIndices.clear();
+    for( std::size_t itemIdx = 0; itemIdx < items.size(); ++itemIdx )
+    {
+        order[ itemIdx ] = itemIdx;
+        itemIndices[ items[ itemIdx ].geometry ] = itemIdx;
+    }
+    nodes.clear();
+    if( !items.empty() )
+    {
+        build( 0, items.size(), NO_PARENT );
+    }
+
+    dirtySubtrees.clear();
+    isRebuildRequired = false;
+    isRefitRequired   = false;
+    ++rebuilds;
+}
+
+
+void BVHPicker::Details::refit()
+{
+    /* Update the items beneath the invalidated subtrees and mark their leafs.
+     */
+    dirtyNodes.clear();
+    for( auto subtreeItr = dirtySubtrees.begin(); subtreeItr != dirtySubtrees.end(); ++subtreeItr )
+    {
+        base::Node& subtree = **subtreeItr;
+        subtree.updateWorldTransform();
+        subtree.visitChildren( true, [this]( const base::Spatial& spatial )
+            {
+                const base::Geometry* const geom = dynamic_cast< const base::Geometry* >( &spatial );
+                const auto itemItr = geom == nullptr ? itemIndices.end() : itemIndices.find( geom );
+                if( itemItr != itemIndices.end() )
+                {
+                    items[ itemItr->second ].update();
+                    markDirty( itemItr->second );
+                }
+            }
+        );
+    }
+    dirtySubtrees.clear();
+
+    /* Children are always stored after their parents, hence processing the dirty
+     * nodes by descending indices refits the children first.
+     */
+    std::sort( dirtyNodes.begin(), dirtyNodes.end(), std::greater< std::size_t >() );
+    for( auto nodeIdxItr = dirtyNodes.begin(); nodeIdxItr != dirtyNodes.end(); ++nodeIdxItr )
+    {
+        TreeNode& node = nodes[ *nodeIdxItr ];
+        if( node.isLeaf )
+        {
+            fitLeaf( node );
+        }
+        else
+        {
+            node.min = nodes[ node.left ].min.cwiseMin( nodes[ node.right ].min );
+            node.max = nodes[ node.left ].max.cwiseMax( nodes[ node.right ].max );
+        }
+        node.isDirty = false;
+    }
+    lastRefitNodes = dirtyNodes.size();
+
+    isRefitRequired = false;
+    ++refits;
+}
+
+
+void BVHPicker::Details::markDirty( std::size_t itemIdx )
+{
+    /* Stop at the first ancestor, that is marked already, since so are all of its
+     * ancestors.
+     */
+    for( std::size_t nodeIdx = leafOf[ itemIdx ]; nodeIdx != NO_PARENT && !nodes[ nodeIdx ].isDirty; nodeIdx = nodes[ nodeIdx ].parent )
+    {
+        nodes[ nodeIdx ].isDirty = true;
+        dirtyNodes.push_back( nodeIdx );
+    }
+}
+
+
+void BVHPicker::Details::fitLeaf( TreeNode& node ) const
+{
+    node.min = items[ order[ node.left ] ].min;
+    node.max = items[ order[ node.left ] ].max;
+    for( std::size_t i = 1; i < node.right; ++i )
+    {
+        const Item& item = items[ order[ node.left + i ] ];
+        node.min = node.min.cwiseMin( item.min );
+        node.max = node.max.cwiseMax( item.max );
+    }
+}
+
+
+std::size_t BVHPicker::Details::build( std::size_t first, std::size_t count, std::size_t parent )
+{
+    const std::size_t nodeIdx = nodes.size();
+    nodes.push_back( TreeNode() );
+    nodes[ nodeIdx ].parent  = parent;
+    nodes[ nodeIdx ].isDirty = false;
+    if( count <= MAX_LEAF_SIZE )
+    {
+        TreeNode& node = nodes[ nodeIdx ];
+        node.isLeaf = true;
+        node.left   = first;
+        node.right  = count;
+        fitLeaf( node );
+        for( std::size_t i = 0; i < count; ++i )
+        {
+            leafOf[ order[ first + i ] ] = nodeIdx;
+        }
+        return nodeIdx;
+    }
+
+    /* Split at the median along the axis where the centers spread most.
+     */
+    base::math::Vector3f centersMin = ( items[ order[ first ] ].min + items[ order[ first ] ].max ) / 2;
+    base::math::Vector3f centersMax = centersMin;
+    for( std::size_t i = 1; i < count; ++i )
+    {
+        const Item& item = items[ order[ first + i ] ];
+        const base::math::Vector3f center = ( item.min + item.max ) / 2;
+        centersMin = centersMin.cwiseMin( center );
+        centersMax = centersMax.cwiseMax( center );
+    }
+    unsigned int axis;
+    ( centersMax - centersMin ).maxCoeff( &axis );
+
+    const std::vector< Item >& items = this->items;
+    const std::size_t half = count / 2;
+    std::nth_element( order.begin() + first, order.begin() + first + half, order.begin() + first + count,
+        [&items, axis]( std::size_t a, std::size_t b )
+        {
+            return items[ a ].min[ axis ] + items[ a ].max[ axis ] < items[ b ].min[ axis ] + items[ b ].max[ axis ];
+        }
+    );
+
+    const std::size_t left  = build( first, half, nodeIdx );
+    const std::size_t right = build( first + half, count - half, nodeIdx );
+
+    /* Do not hold a reference across the recursion since 'nodes' might grow.
+     */
+    TreeNode& node = nodes[ nodeIdx ];
+    node.isLeaf = false;
+    node.left   = left;
+    node.right  = right;
+    node.min = nodes[ left ].min.cwiseMin( nodes[ right ].min );
+    node.max = nodes[ left ].max.cwiseMax( nodes[ right ].max );
+    return nodeIdx;
+}
+
+
+bool BVHPicker::Details::intersectBox
+    ( const base::math::Vector3f& min
+    , const base::math::Vector3f& max
+    , const base::math::Vector3f& origin
+    , const base::math::Vector3f& direction
+    , float& tNear
+    , float tMax )
+{
+    float t0 = 0;
+    float t1 = tMax;
+    for( unsigned int i = 0; i < 3; ++i )
+    {
+        if( std::abs( direction[ i ] ) < std::numeric_limits< float >::epsilon() )
+        {
+            if( origin[ i ] < min[ i ] || origin[ i ] > max[ i ] )
+            {
+                return false;
+            }
+        }
+        else
+        {
+            float tA = ( min[ i ] - origin[ i ] ) / direction[ i ];
+            float tB = ( max[ i ] - origin[ i ] ) / direction[ i ];
+            if( tA > tB )
+            {
+                std::swap( tA, tB );
+            }
+            t0 = std::max( t0, tA );
+            t1 = std::min( t1, tB );
+            if( t0 > t1 )
+            {
+                return false;
+            }
+        }
+    }
+    tNear = t0;
+    return true;
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// BVHPicker
+// ----------------------------------------------------------------------------------
+
+BVHPicker::BVHPicker( base::Node& root, unsigned int geometryType )
+    : pimpl( new Details( *this, root ) )
+    , geometryType( geometryType )
+{
+    root.addNodeListener( *this );
+}
+
+
+BVHPicker::~BVHPicker()
+{
+    if( pimpl->root != nullptr )
+    {
+        pimpl->root->removeNodeListener( *this );
+    }
+}
+
+
+base::Aggregation< const base::Geometry > BVHPicker::pick
+    ( const base::math::Vector3f& origin
+    , const base::math::Vector3f& direction )
+{
+    pimpl->update();
+    const base::Geometry* result = nullptr;
+    if( !pimpl->nodes.empty() )
+    {
+        float tBest = std::numeric_limits< float >::max();
+        pimpl->stack.clear();
+        pimpl->stack.push_back( 0 );
+        while( !pimpl->stack.empty() )
+        {
+            const Details::TreeNode& node = pimpl->nodes[ pimpl->stack.back() ];
+            pimpl->stack.pop_back();
+
+            float t;
+            if( !Details::intersectBox( node.min, node.max, origin, direction, t, tBest ) )
+            {
+                continue;
+            }
+            if( node.isLeaf )
+            {
+                /* Test the ray against the oriented boxes within their local
+                 * coordinates. The ray parameter is invariant under the affine map.
+                 */
+                for( std::size_t i = 0; i < node.right; ++i )
+                {
+                    const Details::Item& item = pimpl->items[ pimpl->order[ node.left + i ] ];
+                    const base::math::Matrix4f toLocal = item.boxTransform.inverse();
+                    const base::math::Vector3f localOrigin    = ( toLocal * base::math::Vector4f( origin.x(), origin.y(), origin.z(), 1 ) ).head< 3 >();
+                    const base::math::Vector3f localDirection = ( toLocal * base::math::Vector4f( direction.x(), direction.y(), direction.z(), 0 ) ).head< 3 >();
+                    if( Details::intersectBox( -item.halfSize, item.halfSize, localOrigin, localDirection, t, tBest ) && t < tBest )
+                    {
+                        tBest  = t;
+                        result = item.geometry;
+                    }
+                }
+            }
+            else
+            {
+                pimpl->stack.push_back( node.right );
+                pimpl->stack.push_back( node.left  );
+            }
+        }
+    }
+
+    if( result == nullptr )
+    {
+        return base::Aggregation< const base::Geometry >::NULL_PTR;
+    }
+    else
+    {
+        return base::Aggregation< const base::Geometry >( *result );
+    }
+}
+
+
+base::Aggregation< const base::Geometry > BVHPicker::pick
+    ( const base::Camera& cam
+    , const base::Viewport& vp
+    , unsigned int x, unsigned int y )
+{
+    /* The camera's world transform must be up-to-date.
+     */
+    pimpl->update();
+
+    /* Compute the normalized device coordinates of the pixel's center.
+     */
+    const float ndcX = 2 * ( x + 0.5f - vp.marginLeft() ) / vp.width () - 1;
+    const float ndcY = 1 - 2 * ( y + 0.5f - vp.marginTop () ) / vp.height();
+
+    /* Unproject the pixel on the near and far clipping planes.
+     */
+    const base::math::Matrix4f inverse = ( cam.projection() * cam.viewTransform() ).inverse();
+    const base::math::Vector4f nearPoint = inverse * base::math::Vector4f( ndcX, ndcY, -1, 1 );
+    const base::math::Vector4f  farPoint = inverse * base::math::Vector4f( ndcX, ndcY, +1, 1 );
+    const base::math::Vector3f origin = nearPoint.head< 3 >() / nearPoint.w();
+    const base::math::Vector3f target =  farPoint.head< 3 >() /  farPoint.w();
+    return pick( origin, target - origin );
+}
+
+
+std::size_t BVHPicker::size()
+{
+    pimpl->update();
+    return pimpl->items.size();
+}
+
+
+std::size_t BVHPicker::rebuilds() const
+{
+    return pimpl->rebuilds;
+}
+
+
+std::size_t BVHPicker::refits() const
+{
+    return pimpl->refits;
+}
+
+
+std::size_t BVHPicker::lastRefitNodes() const
+{
+    return pimpl->lastRefitNodes;
+}
+
+
+void BVHPicker::onNodeDelete( const base::Node& node )
+{
+    /* We are not allowed to remove the listener from the dying node.
+     */
+    pimpl->root = nullptr;
+    pimpl->items.clear();
+    pimpl->nodes.clear();
+    pimpl->dirtySubtrees.clear();
+}
+
+
+void BVHPicker::onTreeChange( base::Node& node, bool inThisSubtree )
+{
+    pimpl->isRebuildRequired = true;
+}
+
+
+void BVHPicker::onTreeInvalidated( base::Node& subtree )
+{
+    pimpl->isRefitRequired = true;
+    if( std::find( pimpl->dirtySubtrees.begin(), pimpl->dirtySubtrees.end(), &subtree ) == pimpl->dirtySubtrees.end() )
+    {
+        pimpl->dirtySubtrees.push_back( &subtree );
+    }
+}
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
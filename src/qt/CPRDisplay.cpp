@@ -0,0 +1,459 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#include <Carna/qt/CPRDisplay.h>
+#include <Carna/qt/Reslicer.h>
+#include <QPainter>
+#include <algorithm>
+#include <cmath>
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// CPRDisplay :: Details
+// ----------------------------------------------------------------------------------
+
+struct CPRDisplay::Details
+{
+    Details( const base::HUVolume& volume, const base::math::Vector3f& spacing );
+    Details( const Reslicer& reslicer, const base::math::Vector3f& spacing );
+
+    /* The reslicer is only owned if it was not supplied by the client.
+     */
+    const std::unique_ptr< Reslicer > ownReslicer;
+    const Reslicer& reslicer;
+
+    /* Maps millimeters w.r.t. the volume center to the model space of the volume.
+     */
+    base::math::Vector3f millimetersToModel;
+
+    std::vector< base::math::Vector3f > centerline;
+    Mode mode;
+    base::math::Vector3f upVector;
+    float pixelSize;
+    float fieldHeight;
+    base::HUV windowingLevel;
+    unsigned int windowingWidth;
+
+    /* Each segment of the centerline occupies a block of image columns. The
+     * positions and the HUV are stored column by column.
+     */
+    struct Block
+    {
+        Block();
+        bool isDirty;
+        unsigned int columns;
+        std::vector< base::math::Vector3f > positions;
+        std::vector< float > huvs;
+    };
+
+    std::vector< Block > blocks;
+    unsigned int rows;
+    std::size_t sampledColumns;
+
+    QImage image;
+    bool isImageDirty;
+
+    void computeMillimetersToModel( const base::math::Vector3f& spacing );
+    void invalidateAll();
+    void invalidateSegment( std::size_t segmentIdx );
+    void computePositions( std::size_t segmentIdx );
+    void update();
+    void updateImage();
+};
+
+
+CPRDisplay::Details::Block::Block()
+    : isDirty( true )
+    , columns( 0 )
+{
+}
+
+
+CPRDisplay::Details::Details( const base::HUVolume& volume, const base::math::Vector3f& spacing )
+    : ownReslicer( new Reslicer( volume ) )
+    , reslicer( *ownReslicer )
+    , mode( straightened )
+    , upVector( 0, 1, 0 )
+    , pixelSize( DEFAULT_PIXEL_SIZE )
+    , fieldHeight( DEFAULT_FIELD_HEIGHT )
+    , windowingLevel( 0 )
+    , windowingWidth( 400 )
+    , rows( 0 )
+    , sampledColumns( 0 )
+    , isImageDirty( true )
+{
+    computeMillimetersToModel( spacing );
+}
+
+
+CPRDisplay::Details::Details( const Reslicer& reslicer, const base::math::Vector3f& spacing )
+    : reslicer( reslicer )
+    , mode( straightened )
+    , upVector( 0, 1, 0 )
+    , pixelSize( DEFAULT_PIXEL_SIZE )
+    , fieldHeight( DEFAULT_FIELD_HEIGHT )
+    , windowingLevel( 0 )
+    , windowingWidth( 400 )
+    , rows( 0 )
+    , sampledColumns( 0 )
+    , isImageDirty( true )
+{
+    computeMillimetersToModel( spacing );
+}
+
+
+void CPRDisplay::Details::computeMillimetersToModel( const base::math::Vector3f& spacing )
+{
+    for( unsigned int axis = 0; axis < 3; ++axis )
+    {
+        millimetersToModel[ axis ] = 1 / ( ( reslicer.size()[ axis ] - 1 ) * spacing[ axis ] );
+    }
+}
+
+
+void CPRDisplay::Details::invalidateAll()
+{
+    blocks.resize( centerline.size() < 2 ? 0 : centerline.size() - 1 );
+    for( auto blockItr = blocks.begin(); blockItr != blocks.end(); ++blockItr )
+    {
+        blockItr->isDirty = true;
+    }
+    rows = std::max( 1, static_cast< int >( std::floor( fieldHeight / pixelSize + 0.5f ) ) );
+    isImageDirty = true;
+}
+
+
+void CPRDisplay::Details::invalidateSegment( std::size_t segmentIdx )
+{
+    if( segmentIdx < blocks.size() )
+    {
+        blocks[ segmentIdx ].isDirty = true;
+        isImageDirty = true;
+    }
+}
+
+
+void CPRDisplay::Details::computePositions( std::size_t segmentIdx )
+{
+    Block& block = blocks[ segmentIdx ];
+    const base::math::Vector3f& a = centerline[ segmentIdx     ];
+    const base::math::Vector3f& b = centerline[ segmentIdx + 1 ];
+    const base::math::Vector3f delta = b - a;
+
+    /* Determine the length of the block and the direction the rows are laid out
+     * along.
+     */
+    float length;
+    base::math::Vector3f lateral;
+    if( mode == straightened )
+    {
+        length = delta.norm();
+        const base::math::Vector3f tangent = length > 0 ? base::math::Vector3f( delta / length ) : base::math::Vector3f( 1, 0, 0 );
+        lateral = upVector - upVector.dot( tangent ) * tangent;
+        if( lateral.norm() < 1e-6f )
+        {
+            /* The segment is parallel to the up vector, hence any perpendicular
+             * direction is as good as any other.
+             */
+            lateral = tangent.cross( base::math::Vector3f( 1, 0, 0 ) );
+            if( lateral.norm() < 1e-6f )
+            {
+                lateral = tangent.cross( base::math::Vector3f( 0, 1, 0 ) );
+            }
+        }
+        lateral.normalize();
+    }
+    else
+    {
+        length = ( delta - delta.dot( upVector ) * upVector ).norm();
+        lateral = upVector;
+    }
+
+    block.columns = static_cast< unsigned int >( std::floor( length / pixelSize + 0.5f ) );
+    block.positions.resize( static_cast< std::size_t >( block.columns ) * rows );
+    for( unsigned int column = 0; column < block.columns; ++column )
+    {
+        /* The rows are centered on the centerline if it is straightened, and on the
+         * volume center otherwise, s.t. the centerline keeps its shape.
+         */
+        base::math::Vector3f center = a + delta * ( ( column + 0.5f ) / block.columns );
+        if( mode == stretched )
+        {
+            center -= center.dot( upVector ) * upVector;
+        }
+        for( unsigned int row = 0; row < rows; ++row )
+        {
+            const float offset = ( rows / 2.f - ( row + 0.5f ) ) * pixelSize;
+            const base::math::Vector3f position = center + offset * lateral;
+            block.positions[ static_cast< std::size_t >( column ) * rows + row ] = position.cwiseProduct( millimetersToModel );
+        }
+    }
+}
+
+
+void CPRDisplay::Details::update()
+{
+    for( std::size_t segmentIdx = 0; segmentIdx < blocks.size(); ++segmentIdx )
+    {
+        Block& block = blocks[ segmentIdx ];
+        if( block.isDirty )
+        {
+            computePositions( segmentIdx );
+            block.huvs.resize( block.positions.size() );
+            if( !block.positions.empty() )
+            {
+                reslicer.sample( &block.positions.front(), block.positions.size(), &block.huvs.front() );
+            }
+            sampledColumns += block.columns;
+            block.isDirty = false;
+        }
+    }
+}
+
+
+void CPRDisplay::Details::updateImage()
+{
+    update();
+
+    unsigned int columns = 0;
+    for( auto blockItr = blocks.begin(); blockItr != blocks.end(); ++blockItr )
+    {
+        columns += blockItr->columns;
+    }
+    if( image.width() != static_cast< int >( columns ) || image.height() != static_cast< int >( rows ) )
+    {
+        image = QImage( std::max( 1u, columns ), rows, QImage::Format_RGB32 );
+        image.fill( 0 );
+    }
+
+    /* Apply the windowing to the cached HUV.
+     */
+    const float minimumHUV = windowingLevel - windowingWidth / 2.f;
+    const float scale = 255.f / std::max( 1u, windowingWidth );
+    unsigned int firstColumn = 0;
+    for( auto blockItr = blocks.begin(); blockItr != blocks.end(); ++blockItr )
+    {
+        for( unsigned int column = 0; column < blockItr->columns; ++column )
+        {
+            const float* const huvs = &blockItr->huvs[ static_cast< std::size_t >( column ) * rows ];
+            for( unsigned int row = 0; row < rows; ++row )
+            {
+                const float intensity = std::min( 255.f, std::max( 0.f, ( huvs[ row ] - minimumHUV ) * scale ) );
+                const int gray = static_cast< int >( intensity + 0.5f );
+                image.setPixel( firstColumn + column, row, qRgb( gray, gray, gray ) );
+            }
+        }
+        firstColumn += blockItr->columns;
+    }
+    isImageDirty = false;
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// CPRDisplay
+// ----------------------------------------------------------------------------------
+
+const float CPRDisplay::DEFAULT_PIXEL_SIZE = 0.5f;
+const float CPRDisplay::DEFAULT_FIELD_HEIGHT = 100;
+
+
+CPRDisplay::CPRDisplay( const base::HUVolume& volume, const base::math::Vector3f& spacing, QWidget* parent )
+    : QWidget( parent )
+    , pimpl( new Details( volume, spacing ) )
+{
+}
+
+
+CPRDisplay::CPRDisplay( const Reslicer& reslicer, const base::math::Vector3f& spacing, QWidget* parent )
+    : QWidget( parent )
+    , pimpl( new Details( reslicer, spacing ) )
+{
+}
+
+
+CPRDisplay::~CPRDisplay()
+{
+}
+
+
+const Reslicer& CPRDisplay::reslicer() const
+{
+    return pimpl->reslicer;
+}
+
+
+void CPRDisplay::setCenterline( const std::vector< base::math::Vector3f >& controlPoints )
+{
+    pimpl->centerline = controlPoints;
+    pimpl->invalidateAll();
+    update();
+}
+
+
+const std::vector< base::math::Vector3f >& CPRDisplay::centerline() const
+{
+    return pimpl->centerline;
+}
+
+
+void CPRDisplay::setControlPoint( std::size_t index, const base::math::Vector3f& position )
+{
+    CARNA_ASSERT( index < pimpl->centerline.size() );
+    pimpl->centerline[ index ] = position;
+
+    /* The segments that start and end at the control point are affected.
+     */
+    if( index > 0 )
+    {
+        pimpl->invalidateSegment( index - 1 );
+    }
+    pimpl->invalidateSegment( index );
+    update();
+}
+
+
+void CPRDisplay::setMode( Mode mode )
+{
+    if( mode != pimpl->mode )
+    {
+        pimpl->mode = mode;
+        pimpl->invalidateAll();
+        update();
+    }
+}
+
+
+CPRDisplay::Mode CPRDisplay::mode() const
+{
+    return pimpl->mode;
+}
+
+
+void CPRDisplay::setUpVector( const base::math::Vector3f& upVector )
+{
+    CARNA_ASSERT( upVector.norm() > 0 );
+    pimpl->upVector = upVector.normalized();
+    pimpl->invalidateAll();
+    update();
+}
+
+
+const base::math::Vector3f& CPRDisplay::upVector() const
+{
+    return pimpl->upVector;
+}
+
+
+void CPRDisplay::setPixelSize( float pixelSize )
+{
+    CARNA_ASSERT( pixelSize > 0 );
+    pimpl->pixelSize = pixelSize;
+    pimpl->invalidateAll();
+    update();
+}
+
+
+float CPRDisplay::pixelSize() const
+{
+    return pimpl->pixelSize;
+}
+
+
+void CPRDisplay::setFieldHeight( float fieldHeight )
+{
+    CARNA_ASSERT( fieldHeight > 0 );
+    pimpl->fieldHeight = fieldHeight;
+    pimpl->invalidateAll();
+    update();
+}
+
+
+float CPRDisplay::fieldHeight() const
+{
+    return pimpl->fieldHeight;
+}
+
+
+void CPRDisplay::setWindowingLevel( base::HUV windowingLevel )
+{
+    pimpl->windowingLevel = windowingLevel;
+    pimpl->isImageDirty = true;
+    update();
+}
+
+
+void CPRDisplay::setWindowingWidth( unsigned int windowingWidth )
+{
+    pimpl->windowingWidth = windowingWidth;
+    pimpl->isImageDirty = true;
+    update();
+}
+
+
+base::HUV CPRDisplay::windowingLevel() const
+{
+    return pimpl->windowingLevel;
+}
+
+
+unsigned int CPRDisplay::windowingWidth() const
+{
+    return pimpl->windowingWidth;
+}
+
+
+const QImage& CPRDisplay::image() const
+{
+    if( pimpl->isImageDirty )
+    {
+        pimpl->updateImage();
+    }
+    return pimpl->image;
+}
+
+
+std::size_t CPRDisplay::sampledColumns() const
+{
+    return pimpl->sampledColumns;
+}
+
+
+void CPRDisplay::paintEvent( QPaintEvent* ev )
+{
+    QPainter painter( this );
+    painter.fillRect( rect(), Qt::black );
+    if( pimpl->blocks.empty() )
+    {
+        return;
+    }
+
+    /* Scale the image to fit the widget, preserving its aspect ratio.
+     */
+    const QImage& image = this->image();
+    const QSize size = image.size().scaled( this->size(), Qt::KeepAspectRatio );
+    const QRect target( ( width() - size.width() ) / 2, ( height() - size.height() ) / 2, size.width(), size.height() );
+    painter.setRenderHint( QPainter::SmoothPixmapTransform );
+    painter.drawImage( target, image );
+}
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
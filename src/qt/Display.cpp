@@ -11,21 +11,40 @@
 
 #include <Carna/qt/Display.h>
 #include <Carna/qt/FrameRendererFactory.h>
+#include <Carna/qt/VolumeUploadScheduler.h>
+#include <Carna/qt/FrameAccumulator.h>
+#include <Carna/qt/PickingStage.h>
+#include <Carna/qt/BVHPicker.h>
+#include <Carna/qt/RenderOrchestrator.h>
+#include <Carna/qt/GeometryConsumer.h>
 #include <Carna/base/NodeListener.h>
 #include <Carna/base/FrameRenderer.h>
 #include <Carna/base/SpatialMovement.h>
 #include <Carna/base/GLContext.h>
 #include <Carna/base/Camera.h>
+#include <Carna/base/Viewport.h>
 #include <Carna/base/Log.h>
+#include <Carna/base/Framebuffer.h>
+#include <Carna/base/math.h>
 #include <Carna/base/ProjectionControl.h>
 #include <Carna/base/CameraControl.h>
 #include <Carna/presets/MeshColorCodingStage.h>
+#include <Carna/presets/VolumeRenderingStage.h>
+#include <Carna/presets/OpaqueRenderingStage.h>
+#include <Carna/presets/TransparentRenderingStage.h>
+#include <Carna/presets/CuttingPlanesStage.h>
+#include <Carna/presets/OccludedRenderingStage.h>
+#include <Carna/presets/EdgeDetectionStage.h>
+#include <Carna/base/GeometryStage.h>
+#include <Carna/base/Geometry.h>
 #include <QGLContext>
 #include <QGLFormat>
 #include <QMouseEvent>
 #include <QWheelEvent>
 #include <QTimer>
 #include <set>
+#include <vector>
+#include <algorithm>
 #include <typeinfo>
 
 #ifndef _MSC_VER
@@ -77,7 +96,8 @@ struct Display::Details : public base::NodeListener
     std::string logTag;
 
     static std::set< const Display* > sharingDisplays;
-    static const Display* pickSharingDisplay();
+    static const QGLWidget* sharingWidget;
+    static const QGLWidget* pickSharingWidget();
     
     typedef base::QGLContextAdapter< QGLContext, QGLFormat > GLContext;
 
@@ -86,13 +106,41 @@ struct Display::Details : public base::NodeListener
     
     ViewportMode vpMode;
     
+    unsigned int resizeBucket;
+    unsigned int frameWidth;
+    unsigned int frameHeight;
+    unsigned int targetWidth;
+    unsigned int targetHeight;
+    std::size_t reallocations;
+    QTimer resizeTimer;
+    static unsigned int bucketed( unsigned int size, unsigned int bucket );
+    bool isReallocationRequired() const;
+    void reshape( unsigned int width, unsigned int height );
+    
+    std::unique_ptr< base::Viewport > rootViewport;
+    std::unique_ptr< base::Viewport > frameViewport;
+    void updateViewport();
+    
+    unsigned int refinementFrames;
+    std::unique_ptr< FrameAccumulator > accumulator;
+    QTimer refinementTimer;
+    bool isRefinementPossible() const;
+    static float halton( unsigned int index, unsigned int base );
+    
     base::Camera* cam;
     base::Node* root;
     std::unique_ptr< base::Association< base::CameraControl > > camControl;
     std::unique_ptr< base::Association< base::ProjectionControl > > projControl;
+    std::unique_ptr< base::Association< VolumeUploadScheduler > > uploadScheduler;
     bool isProjectionUpdateRequested;
     void validateRoot();
     void invalidateRoot();
+    
+    bool isRelevanceKnown;
+    std::set< unsigned int > relevantGeometryTypes;
+    std::size_t skippedRepaints;
+    void updateRelevance();
+    bool isRelevant( base::Node& subtree ) const;
 
     bool mouseInteraction;
     QPoint mousepos;
@@ -101,8 +149,42 @@ struct Display::Details : public base::NodeListener
     float lateralMovementSpeed;
     
     presets::MeshColorCodingStage* mccs;
+    PickingStage* pickingStage;
+    std::unique_ptr< base::Association< BVHPicker > > picker;
+    bool isHoverPickingEnabled() const;
+    const base::Geometry* hoveredGeometry;
+    const base::Geometry* pick( const QPoint& frameCoordinates );
     std::unique_ptr< base::SpatialMovement > spatialMovement;
     
+    struct InputOperation
+    {
+        enum Kind
+        {
+            rotateHorizontally,
+            rotateVertically,
+            moveLaterally,
+            moveAxially
+        };
+        
+        InputOperation( Kind kind, float x, float y );
+        Kind kind;
+        float x;
+        float y;
+        static bool commute( Kind kind1, Kind kind2 );
+    };
+    
+    std::vector< InputOperation > pendingInput;
+    bool isSpatialMovementPending;
+    QPoint pendingSpatialMovement;
+    void enqueueInput( InputOperation::Kind kind, float x, float y = 0 );
+    void flushInput();
+    bool beginSpatialMovement( const QPoint& frameCoordinates );
+    void endSpatialMovement();
+    
+    std::unique_ptr< base::Association< InteractionTrace > > recorder;
+    RenderOrchestrator* orchestrator;
+    void record( InteractionTrace::Event::Kind kind, float x = 0, float y = 0 );
+    
     void updateProjection( Display& );
     bool fitSquare() const;
     
@@ -114,6 +196,7 @@ struct Display::Details : public base::NodeListener
 
 std::map< const base::FrameRenderer*, Display* > Display::Details::displaysByRenderer = std::map< const base::FrameRenderer*, Display* >();
 std::set< const Display* > Display::Details::sharingDisplays = std::set< const Display* >();
+const QGLWidget* Display::Details::sharingWidget = nullptr;
 
 
 Display::Details::Details( Display& self, FrameRendererFactory* rendererFactory )
@@ -121,23 +204,51 @@ Display::Details::Details( Display& self, FrameRendererFactory* rendererFactory
     , invalidated( false )
     , rendererFactory( rendererFactory )
     , vpMode( fitAuto )
+    , resizeBucket( DEFAULT_RESIZE_BUCKET )
+    , frameWidth( 0 )
+    , frameHeight( 0 )
+    , targetWidth( 0 )
+    , targetHeight( 0 )
+    , reallocations( 0 )
+    , refinementFrames( DEFAULT_REFINEMENT_FRAMES )
     , cam( nullptr )
     , root( nullptr )
     , camControl( nullptr )
     , projControl( nullptr )
+    , uploadScheduler( nullptr )
     , isProjectionUpdateRequested( false )
+    , isRelevanceKnown( false )
+    , skippedRepaints( 0 )
     , mouseInteraction( false )
     , radiansPerPixel( DEFAULT_ROTATION_SPEED )
     , axialMovementSpeed( DEFAULT_AXIAL_MOVEMENT_SPEED )
     , lateralMovementSpeed( DEFAULT_LATERAL_MOVEMENT_SPEED )
     , mccs( nullptr )
+    , pickingStage( nullptr )
+    , hoveredGeometry( nullptr )
+    , isSpatialMovementPending( false )
+    , orchestrator( nullptr )
 {
     CARNA_ASSERT( rendererFactory != nullptr );
+    resizeTimer.setSingleShot( true );
+    resizeTimer.setInterval( RESIZE_SETTLE_DELAY );
+    refinementTimer.setSingleShot( true );
+    refinementTimer.setInterval( 0 );
+    
+    /* Reserve room for the input of a busy frame up front. The capacity is kept
+     * when the queue is flushed, hence the queue does not allocate per frame.
+     */
+    pendingInput.reserve( 16 );
 }
 
 
-const Display* Display::Details::pickSharingDisplay()
+const QGLWidget* Display::Details::pickSharingWidget()
 {
+    if( sharingWidget != nullptr )
+    {
+        return sharingWidget;
+    }
+    else
     if( sharingDisplays.empty() )
     {
         return nullptr;
@@ -182,6 +293,210 @@ void Display::Details::updateProjection( Display& display )
 }
 
 
+unsigned int Display::Details::bucketed( unsigned int size, unsigned int bucket )
+{
+    return std::max( 1u, ( ( size + bucket - 1 ) / bucket ) * bucket );
+}
+
+
+bool Display::Details::isReallocationRequired() const
+{
+    /* Reallocate if the render targets are too small or if the size class has
+     * changed, s.t. shrinking the display frees the memory eventually.
+     */
+    return targetWidth < frameWidth
+        || targetHeight < frameHeight
+        || bucketed( targetWidth , resizeBucket ) != bucketed( frameWidth , resizeBucket )
+        || bucketed( targetHeight, resizeBucket ) != bucketed( frameHeight, resizeBucket );
+}
+
+
+void Display::Details::reshape( unsigned int width, unsigned int height )
+{
+    renderer->reshape( width, height, false );
+    targetWidth  = width;
+    targetHeight = height;
+    ++reallocations;
+}
+
+
+void Display::Details::updateViewport()
+{
+    /* The frame is located at the upper left corner of the render targets. Since
+     * the margins refer to the upper edge, while OpenGL refers to the lower edge,
+     * the frame must be shifted by the excess height to appear inside the widget.
+     */
+    unsigned int left = 0;
+    unsigned int top  = targetHeight - frameHeight;
+    unsigned int width  = frameWidth;
+    unsigned int height = frameHeight;
+    if( fitSquare() )
+    {
+        const unsigned int size = std::min( frameWidth, frameHeight );
+        left  += ( frameWidth  - size ) / 2;
+        top   += ( frameHeight - size ) / 2;
+        width  = size;
+        height = size;
+    }
+    frameViewport.reset();
+    rootViewport.reset( new base::Viewport( *renderer, false ) );
+    frameViewport.reset( new base::Viewport( *rootViewport, left, top, width, height ) );
+}
+
+
+Display::Details::InputOperation::InputOperation( Kind kind, float x, float y )
+    : kind( kind )
+    , x( x )
+    , y( y )
+{
+}
+
+
+bool Display::Details::InputOperation::commute( Kind kind1, Kind kind2 )
+{
+    /* Operations of the same kind commute. The movements are translations within
+     * the camera's frame, hence they commute with each other, but not with the
+     * rotations, that change that frame.
+     */
+    const bool isMovement1 = kind1 == moveLaterally || kind1 == moveAxially;
+    const bool isMovement2 = kind2 == moveLaterally || kind2 == moveAxially;
+    return kind1 == kind2 || ( isMovement1 && isMovement2 );
+}
+
+
+void Display::Details::enqueueInput( InputOperation::Kind kind, float x, float y )
+{
+    /* Operations of the same kind are additive. An operation is merged into the
+     * latest pending operation of the same kind, as long as it commutes with all
+     * operations that are pending after that one, s.t. the result is the same as
+     * if the operations were applied one by one.
+     */
+    for( auto opItr = pendingInput.rbegin(); opItr != pendingInput.rend() && InputOperation::commute( opItr->kind, kind ); ++opItr )
+    {
+        if( opItr->kind == kind )
+        {
+            opItr->x += x;
+            opItr->y += y;
+            return;
+        }
+    }
+    pendingInput.push_back( InputOperation( kind, x, y ) );
+}
+
+
+void Display::Details::record( InteractionTrace::Event::Kind kind, float x, float y )
+{
+    if( recorder.get() != nullptr && recorder->get() != nullptr )
+    {
+        ( **recorder ).record( kind, x, y );
+    }
+}
+
+
+void Display::Details::flushInput()
+{
+    if( !pendingInput.empty() && camControl.get() != nullptr && camControl->get() != nullptr )
+    {
+        typedef InteractionTrace::Event Event;
+        base::CameraControl& cc = **camControl;
+        for( auto opItr = pendingInput.begin(); opItr != pendingInput.end(); ++opItr )
+        {
+            switch( opItr->kind )
+            {
+            
+            case InputOperation::rotateHorizontally:
+                cc.rotateHorizontally( opItr->x );
+                record( Event::rotateHorizontally, opItr->x );
+                break;
+                
+            case InputOperation::rotateVertically:
+                cc.rotateVertically( opItr->x );
+                record( Event::rotateVertically, opItr->x );
+                break;
+                
+            case InputOperation::moveLaterally:
+                cc.moveLaterally( opItr->x, opItr->y );
+                record( Event::moveLaterally, opItr->x, opItr->y );
+                break;
+                
+            case InputOperation::moveAxially:
+                cc.moveAxially( opItr->x );
+                record( Event::moveAxially, opItr->x );
+                break;
+                
+            default:
+                CARNA_FAIL( "Unknown InputOperation kind." );
+                
+            }
+        }
+    }
+    pendingInput.clear();
+    
+    /* The spatial movement is computed w.r.t. the position where it started, hence
+     * only the latest mouse position matters.
+     */
+    if( isSpatialMovementPending && spatialMovement.get() != nullptr )
+    {
+        spatialMovement->update( pendingSpatialMovement.x(), pendingSpatialMovement.y() );
+        record( InteractionTrace::Event::spatialMovementUpdate, pendingSpatialMovement.x(), pendingSpatialMovement.y() );
+    }
+    isSpatialMovementPending = false;
+}
+
+
+bool Display::Details::beginSpatialMovement( const QPoint& frameCoordinates )
+{
+    const base::Geometry* const picked = pick( frameCoordinates );
+    if( picked == nullptr || renderer.get() == nullptr || cam == nullptr || !self.hasCameraControl() )
+    {
+        return false;
+    }
+    else
+    {
+        base::Geometry& pickedGeometry = const_cast< base::Geometry& >( *picked );
+        spatialMovement.reset
+            ( new base::SpatialMovement( pickedGeometry, frameCoordinates.x(), frameCoordinates.y(), *frameViewport, *cam ) );
+        record( InteractionTrace::Event::spatialMovementBegin, frameCoordinates.x(), frameCoordinates.y() );
+        return true;
+    }
+}
+
+
+void Display::Details::endSpatialMovement()
+{
+    if( spatialMovement.get() != nullptr )
+    {
+        spatialMovement.reset();
+        record( InteractionTrace::Event::spatialMovementEnd );
+    }
+}
+
+
+bool Display::Details::isRefinementPossible() const
+{
+    return refinementFrames > 0
+        && !invalidated
+        && !mouseInteraction
+        && renderer.get() != nullptr
+        && cam != nullptr
+        && root != nullptr;
+}
+
+
+float Display::Details::halton( unsigned int index, unsigned int base )
+{
+    float result = 0;
+    float f = 1;
+    while( index > 0 )
+    {
+        f /= base;
+        result += f * ( index % base );
+        index /= base;
+    }
+    return result;
+}
+
+
 bool Display::Details::fitSquare() const
 {
     switch( vpMode )
@@ -229,6 +544,94 @@ void Display::Details::validateRoot()
 }
 
 
+void Display::Details::updateRelevance()
+{
+    /* Gather the geometry types that the rendering stages consume. Stages of
+     * unknown kind might consume anything, hence no filtering takes place if
+     * such is found. Stages that know their geometry types implement the
+     * 'GeometryConsumer' interface, the presets are recognized by their types.
+     */
+    relevantGeometryTypes.clear();
+    isRelevanceKnown = true;
+    for( std::size_t rsIdx = 0; rsIdx < renderer->stages(); ++rsIdx )
+    {
+        const base::RenderStage& rs = renderer->stageAt( rsIdx );
+        if( const auto* const gc = dynamic_cast< const GeometryConsumer* >( &rs ) )
+        {
+            gc->addConsumedGeometryTypes( relevantGeometryTypes );
+        }
+        else
+        if( const auto* const gs = dynamic_cast< const base::GeometryStage< void >* >( &rs ) )
+        {
+            relevantGeometryTypes.insert( gs->geometryType );
+        }
+        else
+        if( const auto* const vrs = dynamic_cast< const presets::VolumeRenderingStage* >( &rs ) )
+        {
+            relevantGeometryTypes.insert( vrs->geometryType );
+        }
+        else
+        if( const auto* const ors = dynamic_cast< const presets::OpaqueRenderingStage* >( &rs ) )
+        {
+            relevantGeometryTypes.insert( ors->geometryType );
+        }
+        else
+        if( const auto* const trs = dynamic_cast< const presets::TransparentRenderingStage* >( &rs ) )
+        {
+            relevantGeometryTypes.insert( trs->geometryType );
+        }
+        else
+        if( const auto* const cps = dynamic_cast< const presets::CuttingPlanesStage* >( &rs ) )
+        {
+            relevantGeometryTypes.insert( cps->volumeGeometryType );
+            relevantGeometryTypes.insert( cps->planeGeometryType );
+        }
+        else
+        if( dynamic_cast< const presets::OccludedRenderingStage* >( &rs ) == nullptr
+            && dynamic_cast< const presets::EdgeDetectionStage* >( &rs ) == nullptr )
+        {
+            isRelevanceKnown = false;
+            return;
+        }
+    }
+}
+
+
+bool Display::Details::isRelevant( base::Node& subtree ) const
+{
+    if( !isRelevanceKnown )
+    {
+        return true;
+    }
+    
+    /* Moving the camera or any of its ancestors affects the whole frame.
+     */
+    for( const base::Spatial* spatial = cam; spatial != nullptr; spatial = spatial->hasParent() ? &spatial->parent() : nullptr )
+    {
+        if( spatial == &subtree )
+        {
+            return true;
+        }
+    }
+    
+    /* Otherwise the change is only relevant if it affects geometry of a type that
+     * is consumed by the rendering stages.
+     */
+    bool relevant = false;
+    const std::set< unsigned int >& types = relevantGeometryTypes;
+    subtree.visitChildren( true, [&relevant, &types]( const base::Spatial& spatial )
+        {
+            if( !relevant )
+            {
+                const base::Geometry* const geom = dynamic_cast< const base::Geometry* >( &spatial );
+                relevant = geom != nullptr && types.find( geom->geometryType ) != types.end();
+            }
+        }
+    );
+    return relevant;
+}
+
+
 void Display::Details::onNodeDelete( const base::Node& node )
 {
     CARNA_ASSERT( &node == root );
@@ -241,8 +644,55 @@ void Display::Details::onNodeDelete( const base::Node& node )
 }
 
 
+bool Display::Details::isHoverPickingEnabled() const
+{
+    return pickingStage != nullptr || ( picker.get() != nullptr && picker->get() != nullptr );
+}
+
+
+const base::Geometry* Display::Details::pick( const QPoint& frameCoordinates )
+{
+    if( picker.get() != nullptr && picker->get() != nullptr )
+    {
+        if( renderer.get() == nullptr || cam == nullptr )
+        {
+            return nullptr;
+        }
+        else
+        {
+            return ( **picker ).pick( *cam, *frameViewport, frameCoordinates.x(), frameCoordinates.y() ).get();
+        }
+    }
+    else
+    if( pickingStage != nullptr )
+    {
+        /* This never stalls, but resolves the query w.r.t. the latest frame whose
+         * picking buffer has been copied completely.
+         */
+        glc->makeCurrent();
+        return pickingStage->pick( frameCoordinates.x(), frameCoordinates.y() ).get();
+    }
+    else
+    if( mccs != nullptr )
+    {
+        return mccs->pick( frameCoordinates.x(), frameCoordinates.y() ).get();
+    }
+    else
+    {
+        return nullptr;
+    }
+}
+
+
 void Display::Details::onTreeChange( base::Node& node, bool inThisSubtree )
 {
+    /* The hovered geometry might have been removed from the scene.
+     */
+    if( hoveredGeometry != nullptr )
+    {
+        hoveredGeometry = nullptr;
+        emit self.hovered( nullptr );
+    }
     invalidateRoot();
     self.invalidate();
 }
@@ -250,7 +700,19 @@ void Display::Details::onTreeChange( base::Node& node, bool inThisSubtree )
 
 void Display::Details::onTreeInvalidated( base::Node& subtree )
 {
-    self.invalidate();
+    if( invalidated )
+    {
+        return;
+    }
+    else
+    if( isRelevant( subtree ) )
+    {
+        self.invalidate();
+    }
+    else
+    {
+        ++skippedRepaints;
+    }
 }
 
 
@@ -262,18 +724,29 @@ void Display::Details::onTreeInvalidated( base::Node& subtree )
 const float Display::DEFAULT_ROTATION_SPEED         = -3e-3f;
 const float Display::DEFAULT_AXIAL_MOVEMENT_SPEED   = -1e-1f;
 const float Display::DEFAULT_LATERAL_MOVEMENT_SPEED = -5e-1f;
+const unsigned int Display::DEFAULT_RESIZE_BUCKET   = 128;
+const int Display::RESIZE_SETTLE_DELAY              = 250;
+const unsigned int Display::DEFAULT_REFINEMENT_FRAMES = 0;
 
 
 Display::Display( FrameRendererFactory* rendererFactory, QWidget* parent )
-    : QGLWidget( Details::GLContext::desiredFormat(), parent, Details::pickSharingDisplay() )
+    : QGLWidget( Details::GLContext::desiredFormat(), parent, Details::pickSharingWidget() )
     , pimpl( new Details( *this, rendererFactory ) )
 {
     Details::sharingDisplays.insert( this );
+    connect( &pimpl->resizeTimer, SIGNAL( timeout() ), this, SLOT( finishResize() ) );
+    connect( &pimpl->refinementTimer, SIGNAL( timeout() ), this, SLOT( refine() ) );
 }
 
 
 Display::~Display()
 {
+    removeFromRenderOrchestrator();
+    if( pimpl->accumulator.get() != nullptr )
+    {
+        pimpl->glc->makeCurrent();
+        pimpl->accumulator.reset();
+    }
     pimpl->invalidateRoot();
     Details::sharingDisplays.erase( this );
     if( pimpl->renderer.get() != nullptr )
@@ -351,11 +824,22 @@ void Display::resizeGL( int w, int h )
     CARNA_ASSERT( pimpl->glc.get() != nullptr );
     const unsigned int width  = static_cast< unsigned int >( w );
     const unsigned int height = static_cast< unsigned int >( h );
+    pimpl->frameWidth  = width;
+    pimpl->frameHeight = height;
     if( pimpl->renderer == nullptr )
     {
-        pimpl->renderer.reset( pimpl->rendererFactory->createRenderer( *pimpl->glc, width, height, pimpl->fitSquare() ) );
+        /* The square-shaped viewport is fitted by 'updateViewport', hence the root
+         * viewport always covers the whole render targets.
+         */
+        pimpl->targetWidth  = std::max( 1u, width  );
+        pimpl->targetHeight = std::max( 1u, height );
+        pimpl->renderer.reset( pimpl->rendererFactory->createRenderer( *pimpl->glc, pimpl->targetWidth, pimpl->targetHeight, false ) );
         pimpl->rendererFactory.reset();
+        pimpl->updateViewport();
         pimpl->mccs = pimpl->renderer->findStage< presets::MeshColorCodingStage >().get();
+        pimpl->updateRelevance();
+        pimpl->pickingStage = pimpl->renderer->findStage< PickingStage >().get();
+        setMouseTracking( pimpl->isHoverPickingEnabled() );
         pimpl->updateProjection( *this );
         Details::displaysByRenderer[ pimpl->renderer.get() ] = this;
         
@@ -371,9 +855,24 @@ void Display::resizeGL( int w, int h )
         }
         base::Log::instance().record( base::Log::debug, msg.str() );
         
+        /* Log debug message whether invalidations are filtered.
+         */
+        if( pimpl->isRelevanceKnown )
+        {
+            base::Log::instance().record
+                ( base::Log::debug
+                , "Scene-relevance filtering of invalidations ENABLED." );
+        }
+        else
+        {
+            base::Log::instance().record
+                ( base::Log::debug
+                , "Scene-relevance filtering of invalidations DISABLED." );
+        }
+        
         /* Log debug message whether drag-&-drop is enabled.
          */
-        if( pimpl->mccs != nullptr )
+        if( pimpl->mccs != nullptr || pimpl->isHoverPickingEnabled() )
         {
             base::Log::instance().record
                 ( base::Log::debug
@@ -388,24 +887,176 @@ void Display::resizeGL( int w, int h )
     }
     else
     {
-        pimpl->renderer->reshape( width, height, pimpl->fitSquare() );
+        /* Over-allocate the render targets while resizing is going on, and fit them
+         * to the widget's size once it is finished.
+         */
+        if( pimpl->isReallocationRequired() )
+        {
+            pimpl->reshape
+                ( Details::bucketed( width , pimpl->resizeBucket )
+                , Details::bucketed( height, pimpl->resizeBucket ) );
+        }
+        if( pimpl->targetWidth != width || pimpl->targetHeight != height )
+        {
+            pimpl->resizeTimer.start();
+        }
+        pimpl->updateViewport();
         pimpl->updateProjection( *this );
     }
 }
 
 
-void Display::paintGL()
+void Display::finishResize()
+{
+    if( pimpl->renderer.get() != nullptr && pimpl->frameWidth > 0 && pimpl->frameHeight > 0
+        && ( pimpl->targetWidth != pimpl->frameWidth || pimpl->targetHeight != pimpl->frameHeight ) )
+    {
+        CARNA_LOG_TAG_SCOPE( logTag() );
+        pimpl->glc->makeCurrent();
+        pimpl->reshape( pimpl->frameWidth, pimpl->frameHeight );
+        pimpl->updateViewport();
+        invalidate();
+    }
+}
+
+
+void Display::setResizeBucket( unsigned int resizeBucket )
+{
+    CARNA_ASSERT( resizeBucket > 0 );
+    pimpl->resizeBucket = resizeBucket;
+}
+
+
+unsigned int Display::resizeBucket() const
+{
+    return pimpl->resizeBucket;
+}
+
+
+std::size_t Display::renderTargetReallocations() const
+{
+    return pimpl->reallocations;
+}
+
+
+std::size_t Display::skippedRepaints() const
+{
+    return pimpl->skippedRepaints;
+}
+
+
+std::size_t Display::pendingInputOperations() const
+{
+    return pimpl->pendingInput.size();
+}
+
+
+const base::Viewport& Display::viewport() const
+{
+    CARNA_ASSERT( hasRenderer() );
+    return *pimpl->frameViewport;
+}
+
+
+QPoint Display::frameCoordinates( const QPoint& widgetCoordinates ) const
+{
+    const int excessHeight = static_cast< int >( pimpl->targetHeight ) - static_cast< int >( pimpl->frameHeight );
+    return QPoint( widgetCoordinates.x(), widgetCoordinates.y() + excessHeight );
+}
+
+
+void Display::setRefinementFrames( unsigned int refinementFrames )
+{
+    pimpl->refinementFrames = refinementFrames;
+    invalidate();
+}
+
+
+unsigned int Display::refinementFrames() const
+{
+    return pimpl->refinementFrames;
+}
+
+
+unsigned int Display::refinementSamples() const
 {
+    return pimpl->accumulator.get() == nullptr ? 0 : pimpl->accumulator->samples();
+}
+
+
+void Display::refine()
+{
+    if( !pimpl->isRefinementPossible() )
+    {
+        return;
+    }
+    
     CARNA_LOG_TAG_SCOPE( logTag() );
+    pimpl->glc->makeCurrent();
+    FrameAccumulator& accumulator = *pimpl->accumulator;
+    
+    /* The first sample is not jittered, the others are shifted by sub-pixel
+     * offsets from the Halton sequence, that covers the pixel area evenly.
+     */
+    const unsigned int sample = accumulator.samples();
+    float jitterX = 0;
+    float jitterY = 0;
+    if( sample > 0 )
+    {
+        jitterX = Details::halton( sample, 2 ) - 0.5f;
+        jitterY = Details::halton( sample, 3 ) - 0.5f;
+    }
+    
+    /* Shift the projection by the jitter, that is given in pixels, w.r.t. the
+     * normalized device coordinates.
+     */
+    const base::math::Matrix4f projection = pimpl->cam->projection();
+    const base::math::Matrix4f jitter = base::math::translation4f
+        ( 2 * jitterX / pimpl->frameViewport->width()
+        , 2 * jitterY / pimpl->frameViewport->height()
+        , 0 );
+    pimpl->cam->setProjection( jitter * projection );
+    CARNA_RENDER_TO_FRAMEBUFFER( accumulator.sampleFramebuffer(),
+        renderFrame( *pimpl->renderer, *pimpl->cam, *pimpl->root, *pimpl->frameViewport );
+    );
+    pimpl->cam->setProjection( projection );
+    accumulator.accumulate();
+    
+    /* Show the refined frame. We are outside of 'paintGL' here, hence the buffers
+     * must be swapped explicitly.
+     */
+    accumulator.present( *pimpl->rootViewport );
+    swapBuffers();
+    
+    if( accumulator.samples() < pimpl->refinementFrames )
+    {
+        pimpl->refinementTimer.start();
+    }
+}
+
+
+void Display::paintGL()
+{
     CARNA_ASSERT( pimpl->renderer.get() != nullptr );
     
+    /* The log tag is only set when this method logs itself. Setting it copies the
+     * tag, which would allocate memory with each frame.
+     */
     if( pimpl->cam == nullptr )
     {
+        CARNA_LOG_TAG_SCOPE( logTag() );
         base::Log::instance().record( base::Log::debug, "Display has no camera but should render." );
     }
     else
     {
         pimpl->glc->makeCurrent();
+        
+        /* Apply the input that was gathered since the last frame. The display is
+         * marked invalidated meanwhile, s.t. the resulting scene changes do not
+         * cause another frame.
+         */
+        pimpl->invalidated = true;
+        pimpl->flushInput();
         if( pimpl->isProjectionUpdateRequested )
         {
             pimpl->updateProjection( *this );
@@ -413,7 +1064,47 @@ void Display::paintGL()
         }
         pimpl->invalidated = false;
         pimpl->validateRoot();
-        pimpl->renderer->render( *pimpl->cam, *pimpl->root );
+        
+        /* Stream the next chunk of volume data before the stages acquire it.
+         */
+        const bool isUploading = hasUploadScheduler() && !uploadScheduler().isDone();
+        if( hasUploadScheduler() )
+        {
+            uploadScheduler().process();
+        }
+        
+        renderFrame( *pimpl->renderer, *pimpl->cam, *pimpl->root, *pimpl->frameViewport );
+        pimpl->record( InteractionTrace::Event::frame );
+        
+        /* Keep rendering as long as there is data left to stream. We process once
+         * more after the last chunk, s.t. the scheduler can release what it holds.
+         */
+        if( isUploading )
+        {
+            invalidate();
+        }
+        
+        /* Start refining the frame over again once the display is at rest. The
+         * refinement is driven by the event loop, s.t. any invalidation in between
+         * stops it.
+         */
+        if( pimpl->isRefinementPossible() )
+        {
+            if( pimpl->accumulator.get() == nullptr )
+            {
+                pimpl->accumulator.reset( new FrameAccumulator( pimpl->targetWidth, pimpl->targetHeight ) );
+            }
+            else
+            {
+                pimpl->accumulator->reshape( pimpl->targetWidth, pimpl->targetHeight );
+            }
+            pimpl->refinementTimer.start();
+        }
+        else
+        if( pimpl->accumulator.get() != nullptr )
+        {
+            pimpl->accumulator->reset();
+        }
     }
 }
 
@@ -440,39 +1131,33 @@ void Display::mousePressEvent( QMouseEvent* ev )
 {
     if( ev->buttons() & Qt::LeftButton )
     {
-        /* First, try to pick object at clicked location.
+        /* First, try to pick object at clicked location and initiate spatial
+         * movement. Initiate camera interaction if nothing was picked.
          */
-        const base::Geometry* picked = nullptr;
-        if( pimpl->mccs != nullptr )
-        {
-            picked = pimpl->mccs->pick( ev->x(), ev->y() ).get();
-        }
-        
-        /* Initiate camera interaction if nothing was picked.
-         */
-        if( picked == nullptr )
+        if( !pimpl->beginSpatialMovement( frameCoordinates( ev->pos() ) ) )
         {
             pimpl->mousepos = ev->pos();
-            pimpl->mouseInteraction = true;
-            ev->accept();
-        }
-        else
-        if( pimpl->renderer != nullptr && hasCamera() && hasCameraControl() )
-        {
-            /* Picking was successful! Initiate spatial movement.
-             */
-            base::Geometry& pickedGeometry = const_cast< base::Geometry& >( *picked );
-            pimpl->spatialMovement.reset
-                ( new base::SpatialMovement( pickedGeometry, ev->x(), ev->y(), pimpl->renderer->viewport(), *pimpl->cam ) );
-            pimpl->mouseInteraction = true;
-            ev->accept();
         }
+        pimpl->mouseInteraction = true;
+        ev->accept();
     }
 }
 
 
 void Display::mouseMoveEvent( QMouseEvent* ev )
 {
+    /* Mouse tracking is only enabled if hover picking is available.
+     */
+    if( !pimpl->mouseInteraction && pimpl->isHoverPickingEnabled() )
+    {
+        const base::Geometry* const picked = pimpl->pick( frameCoordinates( ev->pos() ) );
+        if( picked != pimpl->hoveredGeometry )
+        {
+            pimpl->hoveredGeometry = picked;
+            emit hovered( picked );
+        }
+    }
+    
     if( pimpl->mouseInteraction )
     {
         if( pimpl->spatialMovement.get() == nullptr && hasCamera() && hasCameraControl() )
@@ -483,18 +1168,21 @@ void Display::mouseMoveEvent( QMouseEvent* ev )
             const int dy = ( ev->y() - pimpl->mousepos.y() );
             pimpl->mousepos = ev->pos();
 
+            /* The input is applied once before the next frame is rendered.
+             */
             if( dx != 0 || dy != 0 )
             {
+                typedef Details::InputOperation Op;
                 if( ev->modifiers() & Qt::ShiftModifier )
                 {
-                    cameraControl().moveLaterally( dx * pimpl->lateralMovementSpeed, -dy * pimpl->lateralMovementSpeed );
+                    pimpl->enqueueInput( Op::moveLaterally, dx * pimpl->lateralMovementSpeed, -dy * pimpl->lateralMovementSpeed );
                 }
                 else
                 {
-                    cameraControl().rotateHorizontally( dx * pimpl->radiansPerPixel );
-                    cameraControl().rotateVertically  ( dy * pimpl->radiansPerPixel );
+                    pimpl->enqueueInput( Op::rotateHorizontally, dx * pimpl->radiansPerPixel );
+                    pimpl->enqueueInput( Op::rotateVertically  , dy * pimpl->radiansPerPixel );
                 }
-                updateGL();
+                invalidate();
                 ev->accept();
             }
         }
@@ -503,10 +1191,10 @@ void Display::mouseMoveEvent( QMouseEvent* ev )
         {
             /* Spatial movement is going on. Update it.
              */
-            if( pimpl->spatialMovement->update( ev->x(), ev->y() ) )
-            {
-                ev->accept();
-            }
+            pimpl->pendingSpatialMovement = frameCoordinates( ev->pos() );
+            pimpl->isSpatialMovementPending = true;
+            invalidate();
+            ev->accept();
         }
     }
 }
@@ -514,9 +1202,23 @@ void Display::mouseMoveEvent( QMouseEvent* ev )
 
 void Display::mouseReleaseEvent( QMouseEvent* ev )
 {
+    pimpl->flushInput();
     pimpl->mouseInteraction = false;
-    pimpl->spatialMovement.reset();
+    pimpl->endSpatialMovement();
     ev->accept();
+    
+    /* Refinement is suspended during mouse interaction.
+     */
+    if( pimpl->refinementFrames > 0 )
+    {
+        invalidate();
+    }
+}
+
+
+void Display::renderFrame( base::FrameRenderer& renderer, base::Camera& cam, base::Node& root, const base::Viewport& vp )
+{
+    renderer.render( cam, root, vp );
 }
 
 
@@ -524,8 +1226,8 @@ void Display::wheelEvent( QWheelEvent* ev )
 {
     if( hasCamera() && hasCameraControl() )
     {
-        cameraControl().moveAxially( ev->delta() * pimpl->axialMovementSpeed );
-        updateGL();
+        pimpl->enqueueInput( Details::InputOperation::moveAxially, ev->delta() * pimpl->axialMovementSpeed );
+        invalidate();
         ev->accept();
     }
 }
@@ -589,6 +1291,130 @@ const base::ProjectionControl& Display::projectionControl() const
 }
 
 
+void Display::setUploadScheduler( base::Association< VolumeUploadScheduler >* uploadScheduler )
+{
+    pimpl->uploadScheduler.reset( uploadScheduler );
+    invalidate();
+}
+
+
+bool Display::hasUploadScheduler() const
+{
+    return pimpl->uploadScheduler.get() != nullptr && pimpl->uploadScheduler->get() != nullptr;
+}
+
+
+VolumeUploadScheduler& Display::uploadScheduler()
+{
+    CARNA_ASSERT( hasUploadScheduler() );
+    return **pimpl->uploadScheduler;
+}
+
+
+const VolumeUploadScheduler& Display::uploadScheduler() const
+{
+    CARNA_ASSERT( hasUploadScheduler() );
+    return **pimpl->uploadScheduler;
+}
+
+
+void Display::setPicker( base::Association< BVHPicker >* picker )
+{
+    pimpl->picker.reset( picker );
+    setMouseTracking( pimpl->isHoverPickingEnabled() );
+}
+
+
+bool Display::hasPicker() const
+{
+    return pimpl->picker.get() != nullptr && pimpl->picker->get() != nullptr;
+}
+
+
+BVHPicker& Display::picker()
+{
+    CARNA_ASSERT( hasPicker() );
+    return **pimpl->picker;
+}
+
+
+const BVHPicker& Display::picker() const
+{
+    CARNA_ASSERT( hasPicker() );
+    return **pimpl->picker;
+}
+
+
+void Display::setInteractionRecorder( base::Association< InteractionTrace >* recorder )
+{
+    pimpl->recorder.reset( recorder );
+    if( hasInteractionRecorder() )
+    {
+        interactionRecorder().start();
+    }
+}
+
+
+bool Display::hasInteractionRecorder() const
+{
+    return pimpl->recorder.get() != nullptr && pimpl->recorder->get() != nullptr;
+}
+
+
+InteractionTrace& Display::interactionRecorder()
+{
+    CARNA_ASSERT( hasInteractionRecorder() );
+    return **pimpl->recorder;
+}
+
+
+void Display::replay( const InteractionTrace::Event& event )
+{
+    typedef Details::InputOperation Op;
+    switch( event.kind )
+    {
+    
+    case InteractionTrace::Event::rotateHorizontally:
+        pimpl->enqueueInput( Op::rotateHorizontally, event.x );
+        break;
+        
+    case InteractionTrace::Event::rotateVertically:
+        pimpl->enqueueInput( Op::rotateVertically, event.x );
+        break;
+        
+    case InteractionTrace::Event::moveLaterally:
+        pimpl->enqueueInput( Op::moveLaterally, event.x, event.y );
+        break;
+        
+    case InteractionTrace::Event::moveAxially:
+        pimpl->enqueueInput( Op::moveAxially, event.x );
+        break;
+        
+    case InteractionTrace::Event::spatialMovementBegin:
+        pimpl->flushInput();
+        pimpl->beginSpatialMovement( QPoint( static_cast< int >( event.x ), static_cast< int >( event.y ) ) );
+        break;
+        
+    case InteractionTrace::Event::spatialMovementUpdate:
+        pimpl->pendingSpatialMovement = QPoint( static_cast< int >( event.x ), static_cast< int >( event.y ) );
+        pimpl->isSpatialMovementPending = true;
+        break;
+        
+    case InteractionTrace::Event::spatialMovementEnd:
+        pimpl->flushInput();
+        pimpl->endSpatialMovement();
+        break;
+        
+    case InteractionTrace::Event::frame:
+        break;
+        
+    default:
+        CARNA_FAIL( "Unknown InteractionTrace::Event kind." );
+        
+    }
+}
+
+
 bool Display::hasRenderer() const
 {
     return pimpl->renderer.get() != nullptr;
@@ -621,6 +1447,19 @@ const std::string& Display::logTag() const
 }
 
 
+const base::Geometry* Display::hoveredGeometry() const
+{
+    return pimpl->hoveredGeometry;
+}
+
+
+void Display::setSharingWidget( const QGLWidget* sharingWidget )
+{
+    CARNA_ASSERT( sharingWidget == nullptr || Details::sharingDisplays.empty() );
+    Details::sharingWidget = sharingWidget;
+}
+
+
 base::Aggregation< Display > Display::byRenderer( const base::FrameRenderer& renderer )
 {
     const auto displayItr = Details::displaysByRenderer.find( &renderer );
@@ -635,12 +1474,63 @@ base::Aggregation< Display > Display::byRenderer( const base::FrameRenderer& ren
 }
 
 
+void Display::setRenderOrchestrator( RenderOrchestrator& orchestrator )
+{
+    if( pimpl->orchestrator != &orchestrator )
+    {
+        removeFromRenderOrchestrator();
+        pimpl->orchestrator = &orchestrator;
+        orchestrator.addDisplay( *this );
+    }
+}
+
+
+void Display::removeFromRenderOrchestrator()
+{
+    if( pimpl->orchestrator != nullptr )
+    {
+        RenderOrchestrator* const orchestrator = pimpl->orchestrator;
+        pimpl->orchestrator = nullptr;
+        orchestrator->removeDisplay( *this );
+        
+        /* The display might still wait for a pass of the orchestrator, that does
+         * not include it any longer. It is invalidated once more on its own then.
+         */
+        if( pimpl->invalidated )
+        {
+            pimpl->invalidated = false;
+            invalidate();
+        }
+    }
+}
+
+
+bool Display::hasRenderOrchestrator() const
+{
+    return pimpl->orchestrator != nullptr;
+}
+
+
+RenderOrchestrator& Display::renderOrchestrator() const
+{
+    CARNA_ASSERT( hasRenderOrchestrator() );
+    return *pimpl->orchestrator;
+}
+
+
 void Display::invalidate()
 {
     if( !pimpl->invalidated && isVisible() )
     {
-        QTimer::singleShot( 0, this, SLOT( updateGL() ) );
         pimpl->invalidated = true;
+        if( pimpl->orchestrator != nullptr )
+        {
+            pimpl->orchestrator->schedule( *this );
+        }
+        else
+        {
+            QTimer::singleShot( 0, this, SLOT( updateGL() ) );
+        }
     }
 }
 
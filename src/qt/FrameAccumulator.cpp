@@ -0,0 +1,237 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#include <Carna/base/glew.h>
+#include <Carna/qt/FrameAccumulator.h>
+#include <Carna/qt/ShaderResources.h>
+#include <Carna/base/Mesh.h>
+#include <Carna/base/Vertex.h>
+#include <Carna/base/Viewport.h>
+#include <Carna/base/Framebuffer.h>
+#include <Carna/base/RenderTexture.h>
+#include <Carna/base/ShaderUniform.h>
+#include <Carna/base/ShaderProgram.h>
+#include <Carna/base/Composition.h>
+#include <Carna/base/VertexBuffer.h>
+#include <Carna/base/IndexBuffer.h>
+#include <Carna/base/RenderState.h>
+#include <Carna/base/GLContext.h>
+#include <Carna/base/Texture.h>
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// FrameAccumulator :: Details
+// ----------------------------------------------------------------------------------
+
+struct FrameAccumulator::Details
+{
+    Details();
+    ~Details();
+
+    typedef base::Mesh< base::VertexBase, uint8_t > QuadMesh;
+    const std::unique_ptr< QuadMesh > quadMesh;
+    static QuadMesh* createQuadMesh();
+    const base::ShaderProgram& shader;
+    base::ShaderUniform< int > frameUniform;
+
+    std::unique_ptr< base::RenderTexture > sampleColorBuffer;
+    std::unique_ptr< base::Framebuffer   > sampleFramebuffer;
+
+    std::unique_ptr< base::RenderTexture > accumulationColorBuffer;
+    std::unique_ptr< base::Framebuffer   > accumulationFramebuffer;
+
+    unsigned int width;
+    unsigned int height;
+    unsigned int samples;
+
+    void drawTexture( const base::RenderTexture& texture );
+};
+
+
+FrameAccumulator::Details::Details()
+    : quadMesh( createQuadMesh() )
+    , shader( ShaderResources::acquire( "accumulate" ) )
+    , frameUniform( "frame", base::Texture< 0 >::SETUP_UNIT + 1 )
+    , width( 0 )
+    , height( 0 )
+    , samples( 0 )
+{
+}
+
+
+FrameAccumulator::Details::~Details()
+{
+    ShaderResources::release( shader );
+}
+
+
+FrameAccumulator::Details::QuadMesh* FrameAccumulator::Details::createQuadMesh()
+{
+    base::VertexBase vertices[ 4 ];
+    uint8_t indices[ 6 ];
+
+    vertices[ 0 ].x = -1;
+    vertices[ 0 ].y = -1;
+
+    vertices[ 1 ].x = +1;
+    vertices[ 1 ].y = -1;
+
+    vertices[ 2 ].x = +1;
+    vertices[ 2 ].y = +1;
+
+    vertices[ 3 ].x = -1;
+    vertices[ 3 ].y = +1;
+
+    indices[ 0 ] = 0;
+    indices[ 1 ] = 1;
+    indices[ 2 ] = 2;
+    indices[ 3 ] = 0;
+    indices[ 4 ] = 2;
+    indices[ 5 ] = 3;
+
+    /* Create vertex buffer.
+     */
+    typedef base::VertexBuffer< QuadMesh::Vertex > VBuffer;
+    VBuffer* const vertexBuffer = new VBuffer();
+    vertexBuffer->copy( vertices, 4 );
+
+    /* Create index buffer.
+     */
+    typedef base::IndexBuffer< QuadMesh::Index > IBuffer;
+    IBuffer* const indexBuffer = new IBuffer( base::IndexBufferBase::PRIMITIVE_TYPE_TRIANGLES );
+    indexBuffer->copy( indices, 6 );
+
+    /* Create the mesh.
+     */
+    return new QuadMesh
+        ( new base::Composition< base::VertexBufferBase >( vertexBuffer )
+        , new base::Composition< base:: IndexBufferBase >(  indexBuffer ) );
+}
+
+
+void FrameAccumulator::Details::drawTexture( const base::RenderTexture& texture )
+{
+    /* The uniform is created once, since its name would be copied each time.
+     */
+    const unsigned int unit = base::Texture< 0 >::SETUP_UNIT + 1;
+    texture.bind( unit );
+    base::GLContext::current().setShader( shader );
+    frameUniform.upload();
+    quadMesh->render();
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// FrameAccumulator
+// ----------------------------------------------------------------------------------
+
+FrameAccumulator::FrameAccumulator( unsigned int width, unsigned int height )
+    : pimpl( new Details() )
+{
+    reshape( width, height );
+}
+
+
+FrameAccumulator::~FrameAccumulator()
+{
+}
+
+
+void FrameAccumulator::reshape( unsigned int width, unsigned int height )
+{
+    if( width != pimpl->width || height != pimpl->height )
+    {
+        /* Release the framebuffers before the textures they are attached to.
+         */
+        pimpl->sampleFramebuffer.reset();
+        pimpl->accumulationFramebuffer.reset();
+
+        pimpl->sampleColorBuffer.reset( new base::RenderTexture( width, height ) );
+        pimpl->sampleFramebuffer.reset( new base::Framebuffer( width, height, *pimpl->sampleColorBuffer ) );
+
+        /* The running average is kept in floating point precision, otherwise the
+         * contributions of later samples would vanish within the rounding error.
+         */
+        pimpl->accumulationColorBuffer.reset( new base::RenderTexture( width, height, true ) );
+        pimpl->accumulationFramebuffer.reset( new base::Framebuffer( width, height, *pimpl->accumulationColorBuffer ) );
+
+        pimpl->width  = width;
+        pimpl->height = height;
+    }
+    reset();
+}
+
+
+void FrameAccumulator::reset()
+{
+    pimpl->samples = 0;
+}
+
+
+unsigned int FrameAccumulator::samples() const
+{
+    return pimpl->samples;
+}
+
+
+base::Framebuffer& FrameAccumulator::sampleFramebuffer()
+{
+    return *pimpl->sampleFramebuffer;
+}
+
+
+void FrameAccumulator::accumulate()
+{
+    ++pimpl->samples;
+    CARNA_RENDER_TO_FRAMEBUFFER( *pimpl->accumulationFramebuffer,
+
+        base::RenderState rs;
+        rs.setDepthTest( false );
+        rs.setDepthWrite( false );
+        rs.setBlend( true );
+
+        /* Compute the running average, i.e. the n-th sample contributes with a
+         * weight of 1/n, whereas the previous average is weighted by (n-1)/n.
+         */
+        glBlendColor( 0, 0, 0, 1.f / pimpl->samples );
+        rs.setBlendFunction( base::BlendFunction( GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA ) );
+
+        glViewport( 0, 0, pimpl->width, pimpl->height );
+        pimpl->drawTexture( *pimpl->sampleColorBuffer );
+
+    );
+}
+
+
+void FrameAccumulator::present( const base::Viewport& rootViewport )
+{
+    base::RenderState rs;
+    rs.setDepthTest( false );
+    rs.setDepthWrite( false );
+
+    rootViewport.makeActive();
+    pimpl->drawTexture( *pimpl->accumulationColorBuffer );
+    rootViewport.done();
+}
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
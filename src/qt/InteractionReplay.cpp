@@ -0,0 +1,161 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#include <Carna/base/glew.h>
+#include <Carna/qt/InteractionReplay.h>
+#include <Carna/qt/InteractionTrace.h>
+#include <Carna/qt/Display.h>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QWaitCondition>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// InteractionReplay :: Statistics
+// ----------------------------------------------------------------------------------
+
+InteractionReplay::Statistics::Statistics( const std::vector< double >& frameTimes )
+    : frames( frameTimes.size() )
+{
+    std::vector< double > sorted( frameTimes );
+    std::sort( sorted.begin(), sorted.end() );
+    mean   = sorted.empty() ? 0 : std::accumulate( sorted.begin(), sorted.end(), 0. ) / sorted.size();
+    median = percentile( sorted, 50 );
+    p90    = percentile( sorted, 90 );
+    p95    = percentile( sorted, 95 );
+    p99    = percentile( sorted, 99 );
+    max    = sorted.empty() ? 0 : sorted.back();
+}
+
+
+double InteractionReplay::Statistics::percentile( const std::vector< double >& sorted, double p )
+{
+    if( sorted.empty() )
+    {
+        return 0;
+    }
+    const std::size_t rank = static_cast< std::size_t >( std::ceil( p / 100 * sorted.size() ) );
+    return sorted[ std::min( std::max< std::size_t >( rank, 1 ), sorted.size() ) - 1 ];
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// InteractionReplay :: Details
+// ----------------------------------------------------------------------------------
+
+struct InteractionReplay::Details
+{
+    Details( Display& display, const InteractionTrace& trace );
+
+    Display& display;
+    const InteractionTrace& trace;
+    std::vector< double > frameTimes;
+};
+
+
+InteractionReplay::Details::Details( Display& display, const InteractionTrace& trace )
+    : display( display )
+    , trace( trace )
+{
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// InteractionReplay
+// ----------------------------------------------------------------------------------
+
+InteractionReplay::InteractionReplay( Display& display, const InteractionTrace& trace )
+    : pimpl( new Details( display, trace ) )
+{
+}
+
+
+InteractionReplay::~InteractionReplay()
+{
+}
+
+
+InteractionReplay::Statistics InteractionReplay::run( Mode mode )
+{
+    Display& display = pimpl->display;
+    CARNA_ASSERT( display.hasRenderer() );
+    CARNA_ASSERT( display.hasCamera() );
+
+    pimpl->frameTimes.clear();
+    pimpl->frameTimes.reserve( pimpl->trace.frames() );
+
+    QElapsedTimer clock;
+    QElapsedTimer frameClock;
+
+    /* The waits must not process any events, that might render the display in
+     * between. 'QThread::msleep' is not public with Qt 4, hence a wait condition,
+     * that is never woken, is used for the pacing.
+     */
+    QMutex pacingMutex;
+    QWaitCondition pacing;
+    clock.start();
+    const std::vector< InteractionTrace::Event >& events = pimpl->trace.events();
+    for( auto eventItr = events.begin(); eventItr != events.end(); ++eventItr )
+    {
+        if( eventItr->kind != InteractionTrace::Event::frame )
+        {
+            display.replay( *eventItr );
+            continue;
+        }
+
+        if( mode == realTime )
+        {
+            /* The wait might end spuriously, hence it is repeated.
+             */
+            pacingMutex.lock();
+            for( qint64 delay = static_cast< qint64 >( eventItr->time ) - clock.elapsed(); delay > 0; delay = static_cast< qint64 >( eventItr->time ) - clock.elapsed() )
+            {
+                pacing.wait( &pacingMutex, static_cast< unsigned long >( delay ) );
+            }
+            pacingMutex.unlock();
+        }
+
+        /* Render the frame synchronously and wait until the GPU has finished it,
+         * s.t. the measured time is not distorted by the command queue.
+         */
+        frameClock.start();
+        display.updateGL();
+        display.makeCurrent();
+        glFinish();
+        pimpl->frameTimes.push_back( frameClock.nsecsElapsed() / 1e6 );
+    }
+
+    return Statistics( pimpl->frameTimes );
+}
+
+
+const std::vector< double >& InteractionReplay::frameTimes() const
+{
+    return pimpl->frameTimes;
+}
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
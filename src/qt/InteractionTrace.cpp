@@ -0,0 +1,193 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#include <Carna/qt/InteractionTrace.h>
+#include <QElapsedTimer>
+#include <QDataStream>
+#include <QFile>
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// InteractionTrace :: Event
+// ----------------------------------------------------------------------------------
+
+InteractionTrace::Event::Event( Kind kind, unsigned int time, float x, float y )
+    : kind( kind )
+    , time( time )
+    , x( x )
+    , y( y )
+{
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// InteractionTrace :: Details
+// ----------------------------------------------------------------------------------
+
+struct InteractionTrace::Details
+{
+    Details();
+
+    const static quint32 MAGIC   = 0x43515452; // "CQTR"
+    const static quint32 VERSION = 1;
+
+    std::vector< Event > events;
+    std::size_t frames;
+    QElapsedTimer clock;
+};
+
+
+InteractionTrace::Details::Details()
+    : frames( 0 )
+{
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// InteractionTrace
+// ----------------------------------------------------------------------------------
+
+InteractionTrace::InteractionTrace()
+    : pimpl( new Details() )
+{
+}
+
+
+InteractionTrace::~InteractionTrace()
+{
+}
+
+
+void InteractionTrace::start()
+{
+    pimpl->events.clear();
+    pimpl->frames = 0;
+    pimpl->clock.start();
+}
+
+
+void InteractionTrace::record( Event::Kind kind, float x, float y )
+{
+    if( !pimpl->clock.isValid() )
+    {
+        pimpl->clock.start();
+    }
+    const unsigned int time = static_cast< unsigned int >( pimpl->clock.elapsed() );
+    pimpl->events.push_back( Event( kind, time, x, y ) );
+    if( kind == Event::frame )
+    {
+        ++pimpl->frames;
+    }
+}
+
+
+const std::vector< InteractionTrace::Event >& InteractionTrace::events() const
+{
+    return pimpl->events;
+}
+
+
+std::size_t InteractionTrace::frames() const
+{
+    return pimpl->frames;
+}
+
+
+bool InteractionTrace::save( const QString& fileName ) const
+{
+    QFile file( fileName );
+    if( !file.open( QIODevice::WriteOnly ) )
+    {
+        return false;
+    }
+
+    /* Each event takes 13 bytes: the kind, the time and both arguments.
+     */
+    QDataStream out( &file );
+    out.setVersion( QDataStream::Qt_4_6 );
+    out.setFloatingPointPrecision( QDataStream::SinglePrecision );
+    out << Details::MAGIC << Details::VERSION << static_cast< quint32 >( pimpl->events.size() );
+    for( auto eventItr = pimpl->events.begin(); eventItr != pimpl->events.end(); ++eventItr )
+    {
+        out << static_cast< quint8 >( eventItr->kind )
+            << static_cast< quint32 >( eventItr->time )
+            << eventItr->x
+            << eventItr->y;
+    }
+    return out.status() == QDataStream::Ok;
+}
+
+
+bool InteractionTrace::load( const QString& fileName )
+{
+    pimpl->events.clear();
+    pimpl->frames = 0;
+
+    QFile file( fileName );
+    if( !file.open( QIODevice::ReadOnly ) )
+    {
+        return false;
+    }
+
+    QDataStream in( &file );
+    in.setVersion( QDataStream::Qt_4_6 );
+    in.setFloatingPointPrecision( QDataStream::SinglePrecision );
+    quint32 magic, version, count;
+    in >> magic >> version >> count;
+    if( in.status() != QDataStream::Ok || magic != Details::MAGIC || version != Details::VERSION )
+    {
+        return false;
+    }
+
+    /* Each event takes 13 bytes, hence the count is checked against the size of
+     * the file before the events are reserved, s.t. a corrupted count does not
+     * cause a huge allocation.
+     */
+    if( static_cast< qint64 >( count ) * 13 > file.bytesAvailable() )
+    {
+        return false;
+    }
+    pimpl->events.reserve( count );
+    for( quint32 eventIdx = 0; eventIdx < count; ++eventIdx )
+    {
+        quint8 kind;
+        quint32 time;
+        float x, y;
+        in >> kind >> time >> x >> y;
+        if( in.status() != QDataStream::Ok || kind > Event::frame )
+        {
+            pimpl->events.clear();
+            pimpl->frames = 0;
+            return false;
+        }
+        pimpl->events.push_back( Event( static_cast< Event::Kind >( kind ), time, x, y ) );
+        if( kind == Event::frame )
+        {
+            ++pimpl->frames;
+        }
+    }
+    return true;
+}
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
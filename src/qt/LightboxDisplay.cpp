@@ -0,0 +1,550 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#include <Carna/base/glew.h>
+#include <Carna/qt/LightboxDisplay.h>
+#include <Carna/qt/Display.h>
+#include <Carna/qt/FrameRendererFactory.h>
+#include <Carna/presets/CuttingPlanesStage.h>
+#include <Carna/base/FrameRenderer.h>
+#include <Carna/base/NodeListener.h>
+#include <Carna/base/Node.h>
+#include <Carna/base/Geometry.h>
+#include <Carna/base/Camera.h>
+#include <Carna/base/Viewport.h>
+#include <QVBoxLayout>
+#include <QWheelEvent>
+#include <algorithm>
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// LightboxDisplay :: Details
+// ----------------------------------------------------------------------------------
+
+struct LightboxDisplay::Details : public QObject, public base::NodeListener
+{
+    Details( LightboxDisplay& self, const MPRDisplay::Parameters& params );
+    LightboxDisplay& self;
+    const MPRDisplay::Parameters params;
+    
+    struct TileDisplay;
+    presets::CuttingPlanesStage* const planes;
+    TileDisplay* const display;
+    static TileDisplay* createDisplay( Details& lightbox, presets::CuttingPlanesStage* planes );
+    
+    const std::unique_ptr< base::math::Matrix4f > pivotRotation;
+    base::Node pivot;
+    base::Geometry* const plane;
+    base::Camera* const cam;
+    base::Spatial* volume;
+    base::Node* root;
+    void updatePivot();
+    void detachPivot();
+    
+    std::vector< float > slices;
+    float scrollOffset;
+    float scrollStep;
+    unsigned int columns;
+    float fieldOfView;
+    
+    /* Tells the edge length of the tiles and the position of the upper left tile,
+     * if the slices are laid out within a viewport of the given size.
+     */
+    struct TileLayout
+    {
+        TileLayout( const Details& lightbox, unsigned int width, unsigned int height );
+        unsigned int size;
+        unsigned int left;
+        unsigned int top;
+        unsigned int columns;
+    };
+    
+    void renderTiles( base::FrameRenderer& renderer, base::Node& root, const base::Viewport& vp );
+    
+    virtual bool eventFilter( QObject* obj, QEvent* ev ) override;
+    
+    virtual void onNodeDelete( const base::Node& node ) override;
+    virtual void onTreeChange( base::Node& node, bool inThisSubtree ) override;
+    virtual void onTreeInvalidated( base::Node& subtree ) override;
+};
+
+
+
+// ----------------------------------------------------------------------------------
+// LightboxDisplay :: Details :: TileDisplay
+// ----------------------------------------------------------------------------------
+
+struct LightboxDisplay::Details::TileDisplay : public Display
+{
+    TileDisplay( Details& lightbox, FrameRendererFactory* rendererFactory );
+    Details& lightbox;
+    
+protected:
+
+    virtual void renderFrame( base::FrameRenderer& renderer, base::Camera& cam, base::Node& root, const base::Viewport& vp ) override;
+};
+
+
+LightboxDisplay::Details::TileDisplay::TileDisplay( Details& lightbox, FrameRendererFactory* rendererFactory )
+    : Display( rendererFactory )
+    , lightbox( lightbox )
+{
+}
+
+
+void LightboxDisplay::Details::TileDisplay::renderFrame( base::FrameRenderer& renderer, base::Camera& cam, base::Node& root, const base::Viewport& vp )
+{
+    if( lightbox.volume == nullptr || lightbox.slices.empty() )
+    {
+        Display::renderFrame( renderer, cam, root, vp );
+    }
+    else
+    {
+        lightbox.renderTiles( renderer, root, vp );
+    }
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// LightboxDisplay :: Details
+// ----------------------------------------------------------------------------------
+
+LightboxDisplay::Details::Details( LightboxDisplay& self, const MPRDisplay::Parameters& params )
+    : self( self )
+    , params( params )
+    , planes( new presets::CuttingPlanesStage( params.geometryTypeVolume, params.geometryTypePlanes ) )
+    , display( createDisplay( *this, planes ) )
+    , pivotRotation( new base::math::Matrix4f( base::math::identity4f() ) )
+    , plane( new base::Geometry( params.geometryTypePlanes ) )
+    , cam( new base::Camera() )
+    , volume( nullptr )
+    , root( nullptr )
+    , scrollOffset( 0 )
+    , scrollStep( 1 )
+    , columns( DEFAULT_COLUMNS )
+    , fieldOfView( DEFAULT_FIELD_OF_VIEW )
+{
+    /* Configure the 'pivot' node. The plane and the camera are moved to each
+     * slice while the frame is rendered.
+     */
+    pivot.attachChild( plane );
+    pivot.attachChild( cam );
+    
+    /* Configure the display. The projection is set for each tile, hence no
+     * projection control is required.
+     */
+    display->setCamera( *cam );
+    display->setViewportMode( Display::fitFrame );
+    display->installEventFilter( this );
+}
+
+
+LightboxDisplay::Details::TileDisplay* LightboxDisplay::Details::createDisplay( Details& lightbox, presets::CuttingPlanesStage* planes )
+{
+    FrameRendererFactory* const frFactory = new FrameRendererFactory();
+    frFactory->appendStage( planes );
+    return new TileDisplay( lightbox, frFactory );
+}
+
+
+LightboxDisplay::Details::TileLayout::TileLayout( const Details& lightbox, unsigned int width, unsigned int height )
+{
+    const unsigned int slices = static_cast< unsigned int >( lightbox.slices.size() );
+    columns = std::max( 1u, std::min( lightbox.columns, slices ) );
+    const unsigned int rows = std::max( 1u, ( slices + columns - 1 ) / columns );
+    size = std::min( width / columns, height / rows );
+    left = ( width  - size * columns ) / 2;
+    top  = ( height - size * rows    ) / 2;
+}
+
+
+void LightboxDisplay::Details::updatePivot()
+{
+    /* The pivot is attached to the root, but its local space matches that of the
+     * volume's parent, i.e. the volume is still scaled w.r.t. to the pivot.
+     */
+    base::math::Matrix4f baseTransform = base::math::identity4f();
+    for( base::Spatial* current = &volume->parent(); current != root; current = &current->parent() )
+    {
+        baseTransform = current->localTransform * baseTransform;
+    }
+    pivot.localTransform = baseTransform * ( *pivotRotation );
+}
+
+
+void LightboxDisplay::Details::detachPivot()
+{
+    if( root != nullptr )
+    {
+        root->removeNodeListener( *this );
+        pivot.detachFromParent();
+        root = nullptr;
+    }
+    volume = nullptr;
+}
+
+
+void LightboxDisplay::Details::renderTiles( base::FrameRenderer& renderer, base::Node& root, const base::Viewport& vp )
+{
+    updatePivot();
+    const TileLayout layout( *this, vp.width(), vp.height() );
+    if( layout.size == 0 )
+    {
+        return;
+    }
+    
+    /* The tiles are square-shaped, hence so is the projection.
+     */
+    const float halfFieldOfView = fieldOfView / 2;
+    cam->setProjection( base::math::ortho4f
+        ( -halfFieldOfView, +halfFieldOfView
+        , -halfFieldOfView, +halfFieldOfView
+        , 0, params.visibleDistance ) );
+    
+    /* Clear the gaps between the tiles. The renderer clears the whole frame each
+     * time it renders, hence the scissor test is used to restrict it to the tile.
+     */
+    glClearColor( 0, 0, 0, 1 );
+    glClear( GL_COLOR_BUFFER_BIT );
+    glEnable( GL_SCISSOR_TEST );
+    for( std::size_t sliceIdx = 0; sliceIdx < slices.size(); ++sliceIdx )
+    {
+        const unsigned int column = static_cast< unsigned int >( sliceIdx % layout.columns );
+        const unsigned int row    = static_cast< unsigned int >( sliceIdx / layout.columns );
+        const base::Viewport tileViewport
+            ( vp
+            , layout.left + column * layout.size
+            , layout.top  + row    * layout.size
+            , layout.size
+            , layout.size );
+        
+        /* Read back where the tile's viewport ends up within the framebuffer.
+         */
+        GLint tileRect[ 4 ];
+        tileViewport.makeActive();
+        glGetIntegerv( GL_VIEWPORT, tileRect );
+        tileViewport.done();
+        glScissor( tileRect[ 0 ], tileRect[ 1 ], tileRect[ 2 ], tileRect[ 3 ] );
+        
+        /* Move the plane and the camera to the slice. We do not invalidate the
+         * nodes, because the renderer updates the world transforms anyway.
+         */
+        const float offset = slices[ sliceIdx ] + scrollOffset;
+        plane->localTransform = base::math::translation4f( 0, 0, offset );
+        cam  ->localTransform = base::math::translation4f( 0, 0, offset + params.visibleDistance / 2 );
+        renderer.render( *cam, root, tileViewport );
+    }
+    glDisable( GL_SCISSOR_TEST );
+}
+
+
+bool LightboxDisplay::Details::eventFilter( QObject* obj, QEvent* ev )
+{
+    if( ev->type() == QEvent::Wheel )
+    {
+        QWheelEvent* const wheelEvent = static_cast< QWheelEvent* >( ev );
+        if( wheelEvent->modifiers() & Qt::ControlModifier )
+        {
+            self.setFieldOfView( fieldOfView * ( wheelEvent->delta() > 0 ? 1 / 1.1f : 1.1f ) );
+        }
+        else
+        {
+            self.scroll( wheelEvent->delta() > 0 ? +1 : -1 );
+        }
+        return true;
+    }
+    
+    /* Process the event in default way.
+     */
+    return QObject::eventFilter( obj, ev );
+}
+
+
+void LightboxDisplay::Details::onNodeDelete( const base::Node& node )
+{
+    CARNA_ASSERT( &node == root );
+    
+    /* We are not allowed to remove the listener from that dying node.
+     */
+    pivot.detachFromParent();
+    root = nullptr;
+    volume = nullptr;
+    display->invalidate();
+}
+
+
+void LightboxDisplay::Details::onTreeChange( base::Node& node, bool inThisSubtree )
+{
+    /* The volume might have been removed from the scene. We only compare the
+     * addresses here, since the volume object might have been deleted.
+     */
+    if( inThisSubtree && volume != nullptr )
+    {
+        bool isVolumeFound = false;
+        const base::Spatial* const volume = this->volume;
+        root->visitChildren( true, [volume, &isVolumeFound]( base::Spatial& spatial )
+            {
+                isVolumeFound |= &spatial == volume;
+            }
+        );
+        if( !isVolumeFound )
+        {
+            detachPivot();
+            display->invalidate();
+        }
+    }
+}
+
+
+void LightboxDisplay::Details::onTreeInvalidated( base::Node& subtree )
+{
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// LightboxDisplay
+// ----------------------------------------------------------------------------------
+
+const unsigned int LightboxDisplay::DEFAULT_COLUMNS = 4;
+const float LightboxDisplay::DEFAULT_FIELD_OF_VIEW  = 400;
+
+
+LightboxDisplay::LightboxDisplay( const MPRDisplay::Parameters& params, QWidget* parent )
+    : QWidget( parent )
+    , pimpl( new Details( *this, params ) )
+    , parameters( params )
+{
+    setLayout( new QVBoxLayout() );
+    this->layout()->addWidget( pimpl->display );
+    this->layout()->setContentsMargins( 0, 0, 0, 0 );
+    
+    /* Resize this widget to its recommended minimum size if it is a distinct window.
+     */
+    if( parent == nullptr )
+    {
+        this->resize( this->minimumSizeHint() );
+    }
+}
+
+
+LightboxDisplay::~LightboxDisplay()
+{
+    removeVolume();
+    pimpl->display->removeEventFilter( pimpl.get() );
+}
+
+
+QSize LightboxDisplay::minimumSizeHint() const
+{
+    return QSize( 800, 800 );
+}
+
+
+void LightboxDisplay::setVolume( base::Spatial& volume )
+{
+    CARNA_ASSERT( volume.hasParent() );
+    removeVolume();
+    pimpl->volume = &volume;
+    pimpl->root = &volume.findRoot();
+    pimpl->root->attachChild( &pimpl->pivot );
+    pimpl->root->addNodeListener( *pimpl );
+    invalidate();
+}
+
+
+void LightboxDisplay::removeVolume()
+{
+    if( hasVolume() )
+    {
+        pimpl->detachPivot();
+        invalidate();
+    }
+}
+
+
+bool LightboxDisplay::hasVolume() const
+{
+    return pimpl->volume != nullptr;
+}
+
+
+void LightboxDisplay::setRotation( const base::math::Matrix3f& rotation )
+{
+    pimpl->pivotRotation->topLeftCorner( 3, 3 ) = rotation;
+    invalidate();
+}
+
+
+void LightboxDisplay::setSlices( const std::vector< float >& offsets )
+{
+    pimpl->slices = offsets;
+    pimpl->scrollOffset = 0;
+    invalidate();
+}
+
+
+void LightboxDisplay::setEvenlySpacedSlices( float first, float last, unsigned int count )
+{
+    CARNA_ASSERT( count > 0 );
+    const float spacing = count > 1 ? ( last - first ) / ( count - 1 ) : 0;
+    pimpl->slices.resize( count );
+    for( unsigned int sliceIdx = 0; sliceIdx < count; ++sliceIdx )
+    {
+        pimpl->slices[ sliceIdx ] = first + sliceIdx * spacing;
+    }
+    pimpl->scrollOffset = 0;
+    if( count > 1 )
+    {
+        pimpl->scrollStep = spacing;
+    }
+    invalidate();
+}
+
+
+std::size_t LightboxDisplay::slices() const
+{
+    return pimpl->slices.size();
+}
+
+
+float LightboxDisplay::sliceOffset( std::size_t sliceIndex ) const
+{
+    CARNA_ASSERT( sliceIndex < pimpl->slices.size() );
+    return pimpl->slices[ sliceIndex ] + pimpl->scrollOffset;
+}
+
+
+void LightboxDisplay::scroll( int steps )
+{
+    pimpl->scrollOffset += steps * pimpl->scrollStep;
+    invalidate();
+}
+
+
+float LightboxDisplay::scrollOffset() const
+{
+    return pimpl->scrollOffset;
+}
+
+
+void LightboxDisplay::setScrollStep( float millimeters )
+{
+    pimpl->scrollStep = millimeters;
+}
+
+
+float LightboxDisplay::scrollStep() const
+{
+    return pimpl->scrollStep;
+}
+
+
+void LightboxDisplay::setColumns( unsigned int columns )
+{
+    CARNA_ASSERT( columns > 0 );
+    pimpl->columns = columns;
+    invalidate();
+}
+
+
+unsigned int LightboxDisplay::columns() const
+{
+    return pimpl->columns;
+}
+
+
+void LightboxDisplay::setFieldOfView( float millimeters )
+{
+    pimpl->fieldOfView = millimeters;
+    invalidate();
+}
+
+
+float LightboxDisplay::fieldOfView() const
+{
+    return pimpl->fieldOfView;
+}
+
+
+void LightboxDisplay::setWindowingLevel( base::HUV windowingLevel )
+{
+    pimpl->planes->setWindowingLevel( windowingLevel );
+    invalidate();
+}
+
+
+void LightboxDisplay::setWindowingWidth( unsigned int windowingWidth )
+{
+    pimpl->planes->setWindowingWidth( windowingWidth );
+    invalidate();
+}
+
+
+base::HUV LightboxDisplay::windowingLevel() const
+{
+    return pimpl->planes->windowingLevel();
+}
+
+
+unsigned int LightboxDisplay::windowingWidth() const
+{
+    return pimpl->planes->windowingWidth();
+}
+
+
+void LightboxDisplay::setRenderOrchestrator( RenderOrchestrator& orchestrator )
+{
+    pimpl->display->setRenderOrchestrator( orchestrator );
+}
+
+
+std::size_t LightboxDisplay::sliceAt( const QPoint& widgetCoordinates ) const
+{
+    const Display& display = *pimpl->display;
+    if( !display.hasRenderer() || pimpl->slices.empty() )
+    {
+        return pimpl->slices.size();
+    }
+    
+    const base::Viewport& vp = display.viewport();
+    const QPoint frame = display.frameCoordinates( display.mapFrom( this, widgetCoordinates ) );
+    const Details::TileLayout layout( *pimpl, vp.width(), vp.height() );
+    const int x = frame.x() - static_cast< int >( vp.marginLeft() + layout.left );
+    const int y = frame.y() - static_cast< int >( vp.marginTop () + layout.top  );
+    if( layout.size == 0 || x < 0 || y < 0 || static_cast< unsigned int >( x ) >= layout.size * layout.columns )
+    {
+        return pimpl->slices.size();
+    }
+    
+    const std::size_t sliceIdx = ( y / layout.size ) * layout.columns + x / layout.size;
+    return std::min( sliceIdx, pimpl->slices.size() );
+}
+
+
+void LightboxDisplay::invalidate()
+{
+    pimpl->display->invalidate();
+}
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
@@ -10,10 +10,18 @@
  */
 
 #include <Carna/qt/MPR.h>
+#include <Carna/qt/MPRDisplay.h>
 #include <Carna/base/Node.h>
 #include <Carna/base/NodeListener.h>
+#include <Carna/base/Geometry.h>
+#include <Carna/base/Log.h>
 #include <Carna/presets/CuttingPlanesStage.h>
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include <map>
 #include <set>
+#include <sstream>
 
 namespace Carna
 {
@@ -34,12 +42,51 @@ struct MPR::Details : public base::NodeListener
 
     base::Node* root;
     base::Spatial* volume;
+    std::vector< base::Spatial* > volumes;
     void findVolume();
     
+    /* The fusion parameters are kept for each volume node, even while it is not
+     * part of the scene, s.t. they survive detaching and re-attaching it. The node
+     * is watched, s.t. its parameters are dropped when it is deleted. Volumes,
+     * that are single geometry leafs, cannot be watched, hence their parameters
+     * are dropped as soon as they leave the scene.
+     */
+    struct VolumeWatch;
+    std::map< const base::Spatial*, MPRDisplay::FusedVolume > fusion;
+    std::map< const base::Spatial*, std::unique_ptr< VolumeWatch > > volumeWatches;
+    std::vector< MPRDisplay::FusedVolume > fusedVolumes;
+    MPRDisplay::FusedVolume& fusionOf( const base::Spatial& volume );
+    const MPRDisplay::FusedVolume* findFusion( const base::Spatial& volume ) const;
+    void forgetFusion( const base::Spatial* volume );
+    void updateFusion();
+    void updateFusion( MPRDisplay& display ) const;
+    
+    /* The geometries of the volume type are indexed incrementally: Each node of
+     * the scene is watched by a listener, that records its children. When the
+     * number of children changes, only the difference is (un)indexed. The
+     * children of the root are recorded by this listener itself. Each indexed
+     * spatial is mapped to the node it was found beneath, s.t. a spatial, that
+     * is moved to another parent, is not unindexed when its former parent is
+     * notified last.
+     */
+    struct NodeWatch;
+    std::map< const base::Spatial*, std::unique_ptr< NodeWatch > > watches;
+    std::map< const base::Spatial*, const base::Node* > volumeGeometries;
+    std::vector< base::Spatial* > rootChildren;
+    bool isIndexChanged;
+    static void recordChildren( base::Node& node, std::vector< base::Spatial* >& children );
+    void watch( base::Spatial& spatial, const base::Node& parent );
+    void unwatch( const base::Spatial* spatial, const base::Node& parent );
+    void updateChildren( base::Node& node, std::vector< base::Spatial* >& children );
+    void forget( NodeWatch& watch );
+    void releaseWatches();
+    
     void attachPivots();
     void detachPivots();
     void updatePivots();
     const std::unique_ptr< base::math::Matrix4f > basePivotTransform;
+    bool isBasePivotTransformValid;
+    bool isVolumeAncestor( const base::Node& node ) const;
     
     std::set< MPRDisplay* > displays;
     
@@ -56,71 +103,444 @@ MPR::Details::Details( MPR& self )
     : self( self )
     , root( nullptr )
     , volume( nullptr )
+    , isIndexChanged( false )
     , basePivotTransform( new base::math::Matrix4f() )
+    , isBasePivotTransformValid( false )
     , windowingLevel( presets::CuttingPlanesStage::DEFAULT_WINDOWING_LEVEL )
     , windowingWidth( presets::CuttingPlanesStage::DEFAULT_WINDOWING_WIDTH )
 {
 }
 
 
+// ----------------------------------------------------------------------------------
+// MPR :: Details :: NodeWatch
+// ----------------------------------------------------------------------------------
+
+struct MPR::Details::NodeWatch : public base::NodeListener
+{
+    NodeWatch( Details& mpr, base::Node& node, const base::Node& parent );
+    Details& mpr;
+    base::Node& node;
+    const base::Node* parent;
+    std::vector< base::Spatial* > children;
+    
+    virtual void onNodeDelete( const base::Node& node ) override;
+    virtual void onTreeChange( base::Node& node, bool inThisSubtree ) override;
+    virtual void onTreeInvalidated( base::Node& subtree ) override;
+};
+
+
+MPR::Details::NodeWatch::NodeWatch( Details& mpr, base::Node& node, const base::Node& parent )
+    : mpr( mpr )
+    , node( node )
+    , parent( &parent )
+{
+    node.addNodeListener( *this );
+}
+
+
+void MPR::Details::NodeWatch::onNodeDelete( const base::Node& node )
+{
+    /* This deletes the watch, hence nothing must be done afterwards.
+     */
+    mpr.forget( *this );
+}
+
+
+void MPR::Details::NodeWatch::onTreeChange( base::Node& node, bool inThisSubtree )
+{
+    /* The watches outside of the changed subtree return immediately.
+     */
+    if( inThisSubtree )
+    {
+        mpr.updateChildren( this->node, children );
+    }
+}
+
+
+void MPR::Details::NodeWatch::onTreeInvalidated( base::Node& subtree )
+{
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// MPR :: Details :: VolumeWatch
+// ----------------------------------------------------------------------------------
+
+struct MPR::Details::VolumeWatch : public base::NodeListener
+{
+    VolumeWatch( Details& mpr, base::Node& volume );
+    virtual ~VolumeWatch();
+    Details& mpr;
+    base::Node& volume;
+    bool isDeleted;
+    
+    virtual void onNodeDelete( const base::Node& node ) override;
+    virtual void onTreeChange( base::Node& node, bool inThisSubtree ) override;
+    virtual void onTreeInvalidated( base::Node& subtree ) override;
+};
+
+
+MPR::Details::VolumeWatch::VolumeWatch( Details& mpr, base::Node& volume )
+    : mpr( mpr )
+    , volume( volume )
+    , isDeleted( false )
+{
+    volume.addNodeListener( *this );
+}
+
+
+MPR::Details::VolumeWatch::~VolumeWatch()
+{
+    if( !isDeleted )
+    {
+        volume.removeNodeListener( *this );
+    }
+}
+
+
+void MPR::Details::VolumeWatch::onNodeDelete( const base::Node& node )
+{
+    /* We are not allowed to remove the listener from the dying node. This deletes
+     * the watch, hence nothing must be done afterwards.
+     */
+    isDeleted = true;
+    mpr.forgetFusion( &volume );
+}
+
+
+void MPR::Details::VolumeWatch::onTreeChange( base::Node& node, bool inThisSubtree )
+{
+}
+
+
+void MPR::Details::VolumeWatch::onTreeInvalidated( base::Node& subtree )
+{
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// MPR :: Details
+// ----------------------------------------------------------------------------------
+
 void MPR::Details::findVolume()
 {
-    /* Our goal is to find all volume nodes within the scene. We must report an error
-     * if there is more than one, because this is not supported for the moment. The
-     * ad-hoc solution is to use distinct 'MPR' instances for each volume. First we
-     * look for all 'Geometry' leafs that have proper 'geometryType'.
+    /* Our goal is to find all volume nodes within the scene. A volume might be
+     * split into multiple segments, that are not movable w.r.t. each other. Hence
+     * the segments are grouped by the first movable ancestor. The 'Geometry'
+     * leafs that have proper 'geometryType' are already indexed.
+     */
+    isIndexChanged = false;
+    std::map< base::Spatial*, std::vector< base::Spatial* > > groups;
+    for( auto geometryItr = volumeGeometries.begin(); geometryItr != volumeGeometries.end(); ++geometryItr )
+    {
+        base::Spatial* const geometry = const_cast< base::Spatial* >( geometryItr->first );
+        base::Spatial* group = geometry;
+        while( !group->isMovable() && group->hasParent() && &group->parent() != root )
+        {
+            group = &group->parent();
+        }
+        groups[ group ].push_back( geometry );
+    }
+    
+    /* Merge the segments of each group to their parent nodes successively, until
+     * only the volume node remains.
      */
-    const unsigned int volumetric = self.geometryTypeVolume;
-    std::vector< base::Spatial* > seeds;
-    root->visitChildren( true, [volumetric, &seeds]( base::Spatial& spatial )
+    std::vector< base::Spatial* > found;
+    for( auto groupItr = groups.begin(); groupItr != groups.end(); ++groupItr )
+    {
+        std::vector< base::Spatial* > seeds( groupItr->second );
+        while( seeds.size() > 1 )
         {
-            base::Geometry* const geometry = dynamic_cast< base::Geometry* >( &spatial );
-            if( geometry != nullptr && geometry->geometryType == volumetric )
+            std::set< base::Spatial* > parents;
+            for( auto seedItr = seeds.begin(); seedItr != seeds.end(); ++seedItr )
             {
-                seeds.push_back( geometry );
+                parents.insert( &( **seedItr ).parent() );
             }
+            seeds = std::vector< base::Spatial* >( parents.begin(), parents.end() );
         }
-    );
+        found.push_back( seeds[ 0 ] );
+    }
     
-    /* We are done here if no 'seeds' have been found.
+    /* The volumes keep their indices, the new ones are appended.
      */
-    if( seeds.empty() )
+    std::vector< base::Spatial* > previous;
+    previous.swap( volumes );
+    for( auto volumeItr = previous.begin(); volumeItr != previous.end(); ++volumeItr )
     {
-        volume = nullptr;
-        return;
+        if( std::find( found.begin(), found.end(), *volumeItr ) != found.end() )
+        {
+            volumes.push_back( *volumeItr );
+        }
+    }
+    for( auto volumeItr = found.begin(); volumeItr != found.end(); ++volumeItr )
+    {
+        if( std::find( volumes.begin(), volumes.end(), *volumeItr ) == volumes.end() )
+        {
+            volumes.push_back( *volumeItr );
+        }
     }
     
-    /* Merge the 'seeds' to their parent nodes successively.
+    /* Ignore the volumes, that were found last, if there are too many.
      */
-    while( seeds.size() > 1 )
+    if( volumes.size() > MAX_VOLUMES )
     {
-        /* Merge the 'seeds' to their parents. Verify that all remained seeds are not
-         * movable. If this is not true, than we have encountered a scene with more
-         * than one volume.
-         */
-        std::set< base::Spatial* > parents;
-        for( auto seedItr = seeds.begin(); seedItr != seeds.end(); ++seedItr )
+        std::stringstream msg;
+        msg << "MPR supports up to " << MAX_VOLUMES << " volumetric grids, ignoring " << ( volumes.size() - MAX_VOLUMES ) << " more.";
+        base::Log::instance().record( base::Log::warning, msg.str() );
+        volumes.resize( MAX_VOLUMES );
+    }
+    
+    /* Drop the parameters of the volumes, that left the scene and are not
+     * watched. These might have been deleted already, hence they are only
+     * compared, but never dereferenced.
+     */
+    for( auto volumeItr = previous.begin(); volumeItr != previous.end(); ++volumeItr )
+    {
+        if( volumeWatches.find( *volumeItr ) == volumeWatches.end()
+            && std::find( volumes.begin(), volumes.end(), *volumeItr ) == volumes.end() )
         {
-            base::Spatial& spatial = **seedItr;
-            CARNA_ASSERT_EX
-                ( !spatial.isMovable() || !spatial.hasParent()
-                , "MPR does not support scenes with more than one volume data nodes!" );
-                
-            parents.insert( &spatial.parent() );
+            fusion.erase( *volumeItr );
         }
-        
-        /* Use the 'parents' found as the new 'seeds'.
-         */
-        seeds = std::vector< base::Spatial* >( parents.begin(), parents.end() );
+    }
+    updateFusion();
+    
+    /* The slices must be sampled again, since the volumes have changed.
+     */
+    for( auto displayItr = displays.begin(); displayItr != displays.end(); ++displayItr )
+    {
+        ( **displayItr ).invalidateSlices();
     }
     
-    /* We have found the one volume node we have been looking for.
+    /* The displays are aligned to the first volume.
      */
-    volume = seeds[ 0 ];
-    updatePivots();
+    volume = volumes.empty() ? nullptr : volumes[ 0 ];
+    if( volume != nullptr )
+    {
+        isBasePivotTransformValid = false;
+        updatePivots();
+    }
+}
+
+
+MPRDisplay::FusedVolume& MPR::Details::fusionOf( const base::Spatial& volume )
+{
+    const auto fusionItr = fusion.find( &volume );
+    if( fusionItr == fusion.end() )
+    {
+        const base::Node* const node = dynamic_cast< const base::Node* >( &volume );
+        if( node != nullptr )
+        {
+            volumeWatches[ node ].reset( new VolumeWatch( *this, const_cast< base::Node& >( *node ) ) );
+        }
+        return fusion.insert( std::make_pair( &volume, MPRDisplay::FusedVolume( volume, windowingLevel, windowingWidth, DEFAULT_VOLUME_WEIGHT ) ) ).first->second;
+    }
+    else
+    {
+        return fusionItr->second;
+    }
 }
 
 
+const MPRDisplay::FusedVolume* MPR::Details::findFusion( const base::Spatial& volume ) const
+{
+    const auto fusionItr = fusion.find( &volume );
+    if( fusionItr == fusion.end() )
+    {
+        return nullptr;
+    }
+    else
+    {
+        return &fusionItr->second;
+    }
+}
+
+
+void MPR::Details::forgetFusion( const base::Spatial* volume )
+{
+    fusion.erase( volume );
+    volumeWatches.erase( volume );
+}
+
+
+void MPR::Details::updateFusion()
+{
+    fusedVolumes.clear();
+    for( auto volumeItr = volumes.begin(); volumeItr != volumes.end(); ++volumeItr )
+    {
+        fusedVolumes.push_back( fusionOf( **volumeItr ) );
+    }
+    for( auto displayItr = displays.begin(); displayItr != displays.end(); ++displayItr )
+    {
+        updateFusion( **displayItr );
+    }
+}
+
+
+void MPR::Details::updateFusion( MPRDisplay& display ) const
+{
+    /* A single volume is windowed by the display itself.
+     */
+    display.setFusedVolumes( fusedVolumes );
+    if( fusedVolumes.size() == 1 )
+    {
+        display.setWindowingLevel( fusedVolumes[ 0 ].windowingLevel );
+        display.setWindowingWidth( fusedVolumes[ 0 ].windowingWidth );
+    }
+}
+
+
+void MPR::Details::recordChildren( base::Node& node, std::vector< base::Spatial* >& children )
+{
+    children.clear();
+    node.visitChildren( false, [&children]( base::Spatial& child )
+        {
+            children.push_back( &child );
+        }
+    );
+}
+
+
+void MPR::Details::watch( base::Spatial& spatial, const base::Node& parent )
+{
+    base::Node* const node = dynamic_cast< base::Node* >( &spatial );
+    if( node == nullptr )
+    {
+        const base::Geometry* const geometry = dynamic_cast< const base::Geometry* >( &spatial );
+        if( geometry != nullptr && geometry->geometryType == self.geometryTypeVolume )
+        {
+            volumeGeometries[ geometry ] = &parent;
+            isIndexChanged = true;
+        }
+    }
+    else
+    {
+        std::unique_ptr< NodeWatch >& nodeWatch = watches[ node ];
+        if( nodeWatch.get() != nullptr )
+        {
+            /* The node was moved within the scene and its former parent was not
+             * notified yet. Its subtree is indexed already.
+             */
+            nodeWatch->parent = &parent;
+            return;
+        }
+        nodeWatch.reset( new NodeWatch( *this, *node, parent ) );
+        recordChildren( *node, nodeWatch->children );
+        const std::vector< base::Spatial* >& children = nodeWatch->children;
+        for( auto childItr = children.begin(); childItr != children.end(); ++childItr )
+        {
+            watch( **childItr, *node );
+        }
+    }
+}
+
+
+void MPR::Details::unwatch( const base::Spatial* spatial, const base::Node& parent )
+{
+    /* The spatial might have been deleted already, hence only the recorded
+     * children are used, but the spatial is never dereferenced. Watched nodes
+     * are alive, because the watches of deleted nodes are forgotten immediately.
+     */
+    const auto watchItr = watches.find( spatial );
+    if( watchItr == watches.end() )
+    {
+        const auto geometryItr = volumeGeometries.find( spatial );
+        if( geometryItr != volumeGeometries.end() && geometryItr->second == &parent )
+        {
+            volumeGeometries.erase( geometryItr );
+            isIndexChanged = true;
+        }
+    }
+    else
+    if( watchItr->second->parent == &parent )
+    {
+        NodeWatch& nodeWatch = *watchItr->second;
+        for( auto childItr = nodeWatch.children.begin(); childItr != nodeWatch.children.end(); ++childItr )
+        {
+            unwatch( *childItr, nodeWatch.node );
+        }
+        nodeWatch.node.removeNodeListener( nodeWatch );
+        watches.erase( watchItr );
+    }
+}
+
+
+void MPR::Details::updateChildren( base::Node& node, std::vector< base::Spatial* >& children )
+{
+    /* Attaching or detaching a child changes the number of children. This also
+     * notifies all ancestors, but their number of children stays the same.
+     */
+    if( node.children() == children.size() )
+    {
+        return;
+    }
+    
+    std::vector< base::Spatial* > previous;
+    previous.swap( children );
+    recordChildren( node, children );
+    
+    std::vector< base::Spatial* > current( children );
+    std::sort( previous.begin(), previous.end() );
+    std::sort( current .begin(), current .end() );
+    std::vector< base::Spatial* > difference;
+    
+    std::set_difference( previous.begin(), previous.end(), current.begin(), current.end(), std::back_inserter( difference ) );
+    for( auto childItr = difference.begin(); childItr != difference.end(); ++childItr )
+    {
+        unwatch( *childItr, node );
+    }
+    
+    difference.clear();
+    std::set_difference( current.begin(), current.end(), previous.begin(), previous.end(), std::back_inserter( difference ) );
+    for( auto childItr = difference.begin(); childItr != difference.end(); ++childItr )
+    {
+        watch( **childItr, node );
+    }
+    
+    if( isIndexChanged && root != nullptr )
+    {
+        findVolume();
+    }
+}
+
+
+void MPR::Details::forget( NodeWatch& watch )
+{
+    /* The node is being deleted, hence so are its children. The listener of the
+     * node itself is not removed, since it is being notified right now.
+     */
+    const base::Node& node = watch.node;
+    for( auto childItr = watch.children.begin(); childItr != watch.children.end(); ++childItr )
+    {
+        unwatch( *childItr, node );
+    }
+    watches.erase( &node );
+    if( isIndexChanged && root != nullptr )
+    {
+        findVolume();
+    }
+}
+
+
+void MPR::Details::releaseWatches()
+{
+    /* Each watched node is alive, because the watches of deleted nodes are
+     * forgotten immediately.
+     */
+    for( auto watchItr = watches.begin(); watchItr != watches.end(); ++watchItr )
+    {
+        watchItr->second->node.removeNodeListener( *watchItr->second );
+    }
+    watches.clear();
+    volumeGeometries.clear();
+    rootChildren.clear();
+    isIndexChanged = true;
+}
+
+
+
 void MPR::Details::attachPivots()
 {
     CARNA_ASSERT( root != nullptr );
@@ -152,11 +572,20 @@ void MPR::Details::updatePivots()
          * i.e. rotation and translation become the same, but the volume is still
          * scaled w.r.t. to the pivot.
          */
-        ( *basePivotTransform ) = base::math::identity4f();
+        base::math::Matrix4f transform = base::math::identity4f();
         for( base::Spatial* current = &volume->parent(); current != root; current = &current->parent() )
         {
-            ( *basePivotTransform ) = current->localTransform * ( *basePivotTransform );
+            transform = current->localTransform * transform;
+        }
+        
+        /* The displays need not to repaint if nothing has changed.
+         */
+        if( isBasePivotTransformValid && transform == *basePivotTransform )
+        {
+            return;
         }
+        *basePivotTransform = transform;
+        isBasePivotTransformValid = true;
         
         /* Notify all displays to update their pivots.
          */
@@ -173,6 +602,11 @@ void MPR::Details::onNodeDelete( const base::Node& node )
 {
     CARNA_ASSERT( &node == root );
     root = nullptr;
+    rootChildren.clear();
+    volume = nullptr;
+    volumes.clear();
+    updateFusion();
+    isBasePivotTransformValid = false;
     detachPivots();
 }
 
@@ -181,14 +615,37 @@ void MPR::Details::onTreeChange( base::Node& node, bool inThisSubtree )
 {
     if( inThisSubtree )
     {
-        findVolume();
+        updateChildren( *root, rootChildren );
+    }
+}
+
+
+bool MPR::Details::isVolumeAncestor( const base::Node& node ) const
+{
+    for( const base::Spatial* current = &volume->parent(); ; current = &current->parent() )
+    {
+        if( current == &node )
+        {
+            return true;
+        }
+        if( current == root || !current->hasParent() )
+        {
+            return false;
+        }
     }
 }
 
 
 void MPR::Details::onTreeInvalidated( base::Node& subtree )
 {
-    updatePivots();
+    /* The base pivot transform only depends on the ancestors of the volume,
+     * hence invalidations of other subtrees, like the cameras and planes of the
+     * displays, are irrelevant.
+     */
+    if( volume != nullptr && volume->hasParent() && isVolumeAncestor( subtree ) )
+    {
+        updatePivots();
+    }
 }
 
 
@@ -197,6 +654,9 @@ void MPR::Details::onTreeInvalidated( base::Node& subtree )
 // MPR
 // ----------------------------------------------------------------------------------
 
+const float MPR::DEFAULT_VOLUME_WEIGHT = 1;
+
+
 MPR::MPR( unsigned int geometryTypeVolume )
     : pimpl( new Details( *this ) )
     , geometryTypeVolume( geometryTypeVolume )
@@ -215,6 +675,7 @@ MPR::~MPR()
     {
         pimpl->root->removeNodeListener( *pimpl );
     }
+    pimpl->releaseWatches();
 }
 
 
@@ -227,6 +688,7 @@ void MPR::addDisplay( MPRDisplay& mprDisplay )
         mprDisplay.setMPR( *this );
         mprDisplay.setWindowingLevel( pimpl->windowingLevel );
         mprDisplay.setWindowingWidth( pimpl->windowingWidth );
+        pimpl->updateFusion( mprDisplay );
         if( pimpl->root != nullptr )
         {
             mprDisplay.attachPivot( *pimpl->root );
@@ -260,9 +722,15 @@ void MPR::setRoot( base::Node& root )
             pimpl->root->removeNodeListener( *pimpl );
             pimpl->detachPivots();
         }
+        pimpl->releaseWatches();
         pimpl->root = &root;
         pimpl->root->addNodeListener( *pimpl );
         pimpl->attachPivots();
+        Details::recordChildren( root, pimpl->rootChildren );
+        for( auto childItr = pimpl->rootChildren.begin(); childItr != pimpl->rootChildren.end(); ++childItr )
+        {
+            pimpl->watch( **childItr, root );
+        }
         pimpl->findVolume();
     }
 }
@@ -288,25 +756,98 @@ const base::Spatial& MPR::volume() const
 }
 
 
+std::size_t MPR::volumes() const
+{
+    return pimpl->volumes.size();
+}
+
+
+base::Spatial& MPR::volumeAt( std::size_t volumeIdx )
+{
+    CARNA_ASSERT( volumeIdx < pimpl->volumes.size() );
+    return *pimpl->volumes[ volumeIdx ];
+}
+
+
+const base::Spatial& MPR::volumeAt( std::size_t volumeIdx ) const
+{
+    CARNA_ASSERT( volumeIdx < pimpl->volumes.size() );
+    return *pimpl->volumes[ volumeIdx ];
+}
+
+
+void MPR::setVolumeWindowingLevel( const base::Spatial& volume, base::HUV windowingLevel )
+{
+    pimpl->fusionOf( volume ).windowingLevel = windowingLevel;
+    pimpl->updateFusion();
+}
+
+
+void MPR::setVolumeWindowingWidth( const base::Spatial& volume, unsigned int windowingWidth )
+{
+    pimpl->fusionOf( volume ).windowingWidth = windowingWidth;
+    pimpl->updateFusion();
+}
+
+
+void MPR::setVolumeWeight( const base::Spatial& volume, float weight )
+{
+    CARNA_ASSERT( weight >= 0 );
+    pimpl->fusionOf( volume ).weight = weight;
+    pimpl->updateFusion();
+}
+
+
+base::HUV MPR::volumeWindowingLevel( const base::Spatial& volume ) const
+{
+    const MPRDisplay::FusedVolume* const fusion = pimpl->findFusion( volume );
+    return fusion == nullptr ? pimpl->windowingLevel : fusion->windowingLevel;
+}
+
+
+unsigned int MPR::volumeWindowingWidth( const base::Spatial& volume ) const
+{
+    const MPRDisplay::FusedVolume* const fusion = pimpl->findFusion( volume );
+    return fusion == nullptr ? pimpl->windowingWidth : fusion->windowingWidth;
+}
+
+
+float MPR::volumeWeight( const base::Spatial& volume ) const
+{
+    const MPRDisplay::FusedVolume* const fusion = pimpl->findFusion( volume );
+    return fusion == nullptr ? DEFAULT_VOLUME_WEIGHT : fusion->weight;
+}
+
+
 void MPR::setWindowingLevel( base::HUV windowingLevel )
 {
     pimpl->windowingLevel = windowingLevel;
+    for( auto fusionItr = pimpl->fusion.begin(); fusionItr != pimpl->fusion.end(); ++fusionItr )
+    {
+        fusionItr->second.windowingLevel = windowingLevel;
+    }
     for( auto displayItr = pimpl->displays.begin(); displayItr != pimpl->displays.end(); ++displayItr )
     {
         MPRDisplay& display = **displayItr;
         display.setWindowingLevel( windowingLevel );
     }
+    pimpl->updateFusion();
 }
 
 
 void MPR::setWindowingWidth( unsigned int windowingWidth )
 {
     pimpl->windowingWidth = windowingWidth;
+    for( auto fusionItr = pimpl->fusion.begin(); fusionItr != pimpl->fusion.end(); ++fusionItr )
+    {
+        fusionItr->second.windowingWidth = windowingWidth;
+    }
     for( auto displayItr = pimpl->displays.begin(); displayItr != pimpl->displays.end(); ++displayItr )
     {
         MPRDisplay& display = **displayItr;
         display.setWindowingWidth( windowingWidth );
     }
+    pimpl->updateFusion();
 }
 
 
@@ -27,6 +27,7 @@ namespace qt
 // ----------------------------------------------------------------------------------
 
 MPRDataFeature::MPRDataFeature()
+    : isMoving( false )
 {
 }
 
@@ -12,8 +12,9 @@
 #include <Carna/qt/MPRDisplay.h>
 #include <Carna/qt/MPRStage.h>
 #include <Carna/qt/MPRDataFeature.h>
+#include <Carna/qt/SliceCacheStage.h>
 #include <Carna/qt/Display.h>
-#include <Carna/presets/CuttingPlanesStage.h>
+#include <Carna/qt/RenderOrchestrator.h>
 #include <Carna/presets/OrthogonalControl.h>
 #include <Carna/presets/CameraNavigationControl.h>
 #include <Carna/helpers/FrameRendererHelper.h>
@@ -25,6 +26,9 @@
 #include <Carna/base/Viewport.h>
 #include <QVBoxLayout>
 #include <QMouseEvent>
+#include <QBasicTimer>
+#include <QElapsedTimer>
+#include <QTimerEvent>
 
 namespace Carna
 {
@@ -45,10 +49,10 @@ struct MPRDisplay::Details : public QObject
     MPR* mpr;
     MPRDataFeature planeData;
     MPRStage* mprRenderStage;
-    presets::CuttingPlanesStage* planes;
+    SliceCacheStage* planes;
 
     Display* const display;
-    static Display* createDisplay( const Configurator& cfg, MPRStage* mprRenderStage, presets::CuttingPlanesStage* planes );
+    static Display* createDisplay( const Configurator& cfg, MPRStage* mprRenderStage, SliceCacheStage* planes );
     
     const std::unique_ptr< base::math::Matrix4f > pivotRotation;
     const std::unique_ptr< base::math::Matrix4f > pivotBaseTransform;
@@ -59,17 +63,69 @@ struct MPRDisplay::Details : public QObject
     void updatePivot();
     
     virtual bool eventFilter( QObject* obj, QEvent* ev ) override;
+    virtual void timerEvent( QTimerEvent* ev ) override;
     void mouseMoveEvent( QMouseEvent* ev );
     bool mousePressEvent( QMouseEvent* ev );
     void mouseReleaseEvent( QMouseEvent* ev );
     
     struct ExtraRenderStageSequence;
     
-    struct PlaneDragInfo;
-    std::unique_ptr< PlaneDragInfo > currentPlane;
+    /* The mouse handling is invoked for each mouse event, hence it holds its
+     * state by value to avoid heap allocations.
+     */
+    struct PlaneDragInfo
+    {
+        PlaneDragInfo();
+        void set( const base::Geometry& plane, bool horizontal, int direction );
+        void reset();
+        base::Geometry* plane;
+        bool horizontal;
+        int direction;
+    };
+    
+    /* The displacement of the dragged plane is accumulated over all mouse events
+     * that arrive until the next frame. It is then applied by a single scene
+     * update, s.t. the linked displays are invalidated only once. If the display
+     * is attached to a render orchestrator, the displacement is applied right
+     * before its next pass, s.t. the pass renders it. Otherwise it is applied once
+     * the event loop gets idle.
+     */
+    struct PlaneMovement
+    {
+        PlaneMovement();
+        bool active;
+        int previousFrameCoordinate;
+        float pendingDisplacement;
+        QBasicTimer applyTimer;
+    };
+    
+    /* The cine mode advances the plane by as many steps as frames are due since
+     * it was started. Frames that are due but could not be shown, because the
+     * previous one took too long, are counted as dropped.
+     */
+    struct Cine
+    {
+        Cine();
+        QBasicTimer timer;
+        QElapsedTimer clock;
+        float framesPerSecond;
+        float step;
+        unsigned int prefetch;
+        std::size_t framesAdvanced;
+        std::size_t framesDropped;
+        std::size_t samplingsAtStart;
+        std::size_t misses;
+    };
     
-    struct PlaneMovement;
-    std::unique_ptr< PlaneMovement > planeMovement;
+    PlaneDragInfo currentPlane;
+    PlaneMovement planeMovement;
+    Cine cine;
+    void advanceCine();
+    std::size_t onDemandSamplings() const;
+    Qt::CursorShape cursorShape;
+    void setCursorShape( Qt::CursorShape cursorShape );
+    void setPlaneMoving( bool moving );
+    void applyPlaneDisplacement();
 };
 
 
@@ -89,44 +145,64 @@ void MPRDisplay::Details::ExtraRenderStageSequence::moveStagesTo( base::RenderSt
 }
 
 
-struct MPRDisplay::Details::PlaneDragInfo
+MPRDisplay::Details::PlaneDragInfo::PlaneDragInfo()
+    : plane( nullptr )
+    , horizontal( false )
+    , direction( 0 )
 {
-    PlaneDragInfo( const base::Geometry& plane, bool horizontal, int direction );
-    base::Geometry& plane;
-    const bool horizontal;
-    const int direction;
-};
+}
 
 
-MPRDisplay::Details::PlaneDragInfo::PlaneDragInfo( const base::Geometry& plane, bool horizontal, int direction )
+void MPRDisplay::Details::PlaneDragInfo::set( const base::Geometry& plane, bool horizontal, int direction )
+{
     /* This 'const_cast' is okay because the plane belongs to another 'MPRDisplay'
      * that this one could just as well query from the common 'MPR', but this is
      * faster and easier.
      */
-    : plane( const_cast< base::Geometry& >( plane ) )
-    , horizontal( horizontal )
-    , direction( direction )
+    this->plane = const_cast< base::Geometry* >( &plane );
+    this->horizontal = horizontal;
+    this->direction  = direction;
+}
+
+
+void MPRDisplay::Details::PlaneDragInfo::reset()
 {
+    plane = nullptr;
 }
 
 
-struct MPRDisplay::Details::PlaneMovement
+MPRDisplay::Details::PlaneMovement::PlaneMovement()
+    : active( false )
+    , previousFrameCoordinate( 0 )
+    , pendingDisplacement( 0 )
 {
-    int previousFrameCoordinate;
-};
+}
+
+
+MPRDisplay::Details::Cine::Cine()
+    : framesPerSecond( 0 )
+    , step( 0 )
+    , prefetch( DEFAULT_CINE_PREFETCH )
+    , framesAdvanced( 0 )
+    , framesDropped( 0 )
+    , samplingsAtStart( 0 )
+    , misses( 0 )
+{
+}
 
 
 MPRDisplay::Details::Details( MPRDisplay& self, const Configurator& cfg )
     : self( self )
     , mpr( nullptr )
     , mprRenderStage( new MPRStage( cfg.parameters.geometryTypePlanes ) )
-    , planes( new presets::CuttingPlanesStage( cfg.parameters.geometryTypeVolume, cfg.parameters.geometryTypePlanes ) )
+    , planes( new SliceCacheStage( cfg.parameters.geometryTypeVolume, cfg.parameters.geometryTypePlanes ) )
     , display( createDisplay( cfg, mprRenderStage, planes ) )
     , pivotRotation( new base::math::Matrix4f( base::math::identity4f() ) )
     , pivotBaseTransform( new base::math::Matrix4f() )
     , plane( new base::Geometry( cfg.parameters.geometryTypePlanes ) )
     , cam( new base::Camera() )
     , projControl( new presets::OrthogonalControl( new presets::CameraNavigationControl() ) )
+    , cursorShape( Qt::ArrowCursor )
 {
     /* Configure the 'pivot' node.
      */
@@ -159,6 +235,11 @@ MPRDisplay::Details::Details( MPRDisplay& self, const Configurator& cfg )
 
 bool MPRDisplay::Details::eventFilter( QObject* obj, QEvent* ev )
 {
+    if( ev->type() == RenderOrchestrator::PRE_PASS_EVENT )
+    {
+        applyPlaneDisplacement();
+        return true;
+    }
     switch( ev->type() )
     {
         case QEvent::Wheel:
@@ -201,11 +282,12 @@ void MPRDisplay::Details::mouseMoveEvent( QMouseEvent* ev )
     {
         /* Map the frame coordinates to clipping coordinates.
          */
-        const base::Viewport& vp = display->renderer().viewport();
-        const float clippingX =  ( ( static_cast< float >( ev->x() - vp.marginLeft() ) / vp.width () ) * 2 - 1 );
-        const float clippingY = -( ( static_cast< float >( ev->y() - vp.marginTop () ) / vp.height() ) * 2 - 1 );
+        const base::Viewport& vp = display->viewport();
+        const QPoint frame = display->frameCoordinates( ev->pos() );
+        const float clippingX =  ( ( static_cast< float >( frame.x() - vp.marginLeft() ) / vp.width () ) * 2 - 1 );
+        const float clippingY = -( ( static_cast< float >( frame.y() - vp.marginTop () ) / vp.height() ) * 2 - 1 );
         
-        if( planeMovement.get() == nullptr )
+        if( !planeMovement.active )
         {
             const unsigned int planeMargin = 10; // pixels
             
@@ -219,32 +301,39 @@ void MPRDisplay::Details::mouseMoveEvent( QMouseEvent* ev )
             const float offsetH =   vertical.clippingCoordinate - clippingX;
             if( horizontal.plane != nullptr && std::abs( offsetV ) <= planeMarginV )
             {
-                display->setCursor( Qt::SizeVerCursor );
-                currentPlane.reset( new PlaneDragInfo( *horizontal.plane, true, horizontal.direction ) );
+                setCursorShape( Qt::SizeVerCursor );
+                currentPlane.set( *horizontal.plane, true, horizontal.direction );
             }
             else
             if( vertical.plane != nullptr && std::abs( offsetH ) <= planeMarginH )
             {
-                display->setCursor( Qt::SizeHorCursor );
-                currentPlane.reset( new PlaneDragInfo( *vertical.plane, false, vertical.direction ) );
+                setCursorShape( Qt::SizeHorCursor );
+                currentPlane.set( *vertical.plane, false, vertical.direction );
             }
             else
             {
-                display->setCursor( Qt::ArrowCursor );
+                setCursorShape( Qt::ArrowCursor );
                 currentPlane.reset();
             }
         }
         else
-        if( currentPlane.get() != nullptr )
+        if( currentPlane.plane != nullptr )
         {
-            const int currentFrameCoordinate = currentPlane->horizontal ? ev->y() : ev->x();
-            const int deltaFrameCoordinate = currentFrameCoordinate - planeMovement->previousFrameCoordinate;
-            planeMovement->previousFrameCoordinate = currentFrameCoordinate;
+            const int currentFrameCoordinate = currentPlane.horizontal ? ev->y() : ev->x();
+            const int deltaFrameCoordinate = currentFrameCoordinate - planeMovement.previousFrameCoordinate;
+            planeMovement.previousFrameCoordinate = currentFrameCoordinate;
             
-            const int direction = currentPlane->direction * ( currentPlane->horizontal ? +1 : -1 );
-            const float displacement = projControl->zoomFactor() * ( deltaFrameCoordinate * direction );
-            currentPlane->plane.localTransform *= base::math::translation4f( 0, 0, displacement );
-            currentPlane->plane.invalidate();
+            const int direction = currentPlane.direction * ( currentPlane.horizontal ? +1 : -1 );
+            planeMovement.pendingDisplacement += projControl->zoomFactor() * ( deltaFrameCoordinate * direction );
+            if( display->hasRenderOrchestrator() )
+            {
+                display->renderOrchestrator().requestPass();
+            }
+            else
+            if( !planeMovement.applyTimer.isActive() )
+            {
+                planeMovement.applyTimer.start( 0, this );
+            }
         }
     }
 }
@@ -252,10 +341,11 @@ void MPRDisplay::Details::mouseMoveEvent( QMouseEvent* ev )
 
 bool MPRDisplay::Details::mousePressEvent( QMouseEvent* ev )
 {
-    if( ev->button() == Qt::LeftButton && currentPlane.get() != nullptr )
+    if( ev->button() == Qt::LeftButton && currentPlane.plane != nullptr )
     {
-        planeMovement.reset( new PlaneMovement() );
-        planeMovement->previousFrameCoordinate = currentPlane->horizontal ? ev->y() : ev->x();
+        planeMovement.active = true;
+        planeMovement.previousFrameCoordinate = currentPlane.horizontal ? ev->y() : ev->x();
+        setPlaneMoving( true );
         return true;
     }
     else
@@ -267,11 +357,100 @@ bool MPRDisplay::Details::mousePressEvent( QMouseEvent* ev )
 
 void MPRDisplay::Details::mouseReleaseEvent( QMouseEvent* ev )
 {
-    planeMovement.reset();
+    if( planeMovement.active )
+    {
+        applyPlaneDisplacement();
+        planeMovement.active = false;
+        setPlaneMoving( false );
+    }
 }
 
 
-Display* MPRDisplay::Details::createDisplay( const Configurator& cfg, MPRStage* mprRenderStage, presets::CuttingPlanesStage* planes )
+void MPRDisplay::Details::timerEvent( QTimerEvent* ev )
+{
+    if( ev->timerId() == planeMovement.applyTimer.timerId() )
+    {
+        applyPlaneDisplacement();
+    }
+    else
+    if( ev->timerId() == cine.timer.timerId() )
+    {
+        advanceCine();
+    }
+    else
+    {
+        QObject::timerEvent( ev );
+    }
+}
+
+
+void MPRDisplay::Details::applyPlaneDisplacement()
+{
+    planeMovement.applyTimer.stop();
+    if( currentPlane.plane != nullptr && planeMovement.pendingDisplacement != 0 )
+    {
+        currentPlane.plane->localTransform *= base::math::translation4f( 0, 0, planeMovement.pendingDisplacement );
+        currentPlane.plane->invalidate();
+    }
+    planeMovement.pendingDisplacement = 0;
+}
+
+
+void MPRDisplay::Details::advanceCine()
+{
+    const std::size_t framesDue = static_cast< std::size_t >( cine.clock.elapsed() * cine.framesPerSecond / 1000 );
+    if( framesDue <= cine.framesAdvanced )
+    {
+        return;
+    }
+    
+    /* The plane is advanced by the same transform as the slices are prefetched,
+     * s.t. the cached slices are hit.
+     */
+    const std::size_t frames = framesDue - cine.framesAdvanced;
+    for( std::size_t frameIdx = 0; frameIdx < frames; ++frameIdx )
+    {
+        plane->localTransform *= base::math::translation4f( 0, 0, cine.step );
+    }
+    plane->invalidate();
+    cine.framesDropped  += frames - 1;
+    cine.framesAdvanced  = framesDue;
+}
+
+
+std::size_t MPRDisplay::Details::onDemandSamplings() const
+{
+    return planes->samplings() - planes->prefetches();
+}
+
+
+void MPRDisplay::Details::setPlaneMoving( bool moving )
+{
+    /* The displays sample their slabs coarsely while any plane is being moved.
+     * Invalidating the plane makes them render at full quality afterwards.
+     */
+    if( currentPlane.plane != nullptr && currentPlane.plane->hasFeature( MPRStage::ROLE_PLANE_DATA ) )
+    {
+        MPRDataFeature& feature = static_cast< MPRDataFeature& >( currentPlane.plane->feature( MPRStage::ROLE_PLANE_DATA ) );
+        feature.isMoving = moving;
+        currentPlane.plane->invalidate();
+    }
+}
+
+
+void MPRDisplay::Details::setCursorShape( Qt::CursorShape cursorShape )
+{
+    /* Setting the cursor allocates a new 'QCursor' each time.
+     */
+    if( cursorShape != this->cursorShape )
+    {
+        this->cursorShape = cursorShape;
+        display->setCursor( cursorShape );
+    }
+}
+
+
+Display* MPRDisplay::Details::createDisplay( const Configurator& cfg, MPRStage* mprRenderStage, SliceCacheStage* planes )
 {
     FrameRendererFactory* const frFactory = new FrameRendererFactory();
     const Parameters& params = cfg.parameters;
@@ -305,6 +484,20 @@ MPRDisplay::Parameters::Parameters( unsigned int geometryTypeVolume, unsigned in
 
 
 
+// ----------------------------------------------------------------------------------
+// MPRDisplay :: FusedVolume
+// ----------------------------------------------------------------------------------
+
+MPRDisplay::FusedVolume::FusedVolume( const base::Spatial& volume, base::HUV windowingLevel, unsigned int windowingWidth, float weight )
+    : volume( &volume )
+    , windowingLevel( windowingLevel )
+    , windowingWidth( windowingWidth )
+    , weight( weight )
+{
+}
+
+
+
 // ----------------------------------------------------------------------------------
 // MPRDisplay :: Configurator
 // ----------------------------------------------------------------------------------
@@ -332,6 +525,9 @@ void MPRDisplay::Configurator::addExtraStages( base::RenderStageSequence& to ) c
 
 const float MPRDisplay::DEFAULT_VISIBLE_DISTANCE = 2000;
 const base::Color MPRDisplay::DEFAULT_PLANE_COLOR( 255, 255, 255, 255 );
+const float MPRDisplay::DEFAULT_SLAB_STEP = 1;
+const float MPRDisplay::DEFAULT_INTERACTIVE_SLAB_STEP = 4;
+const unsigned int MPRDisplay::DEFAULT_CINE_PREFETCH = 4;
 const base::math::Matrix3f MPRDisplay::ROTATION_FRONT = base::math::identity3f();
 const base::math::Matrix3f MPRDisplay::ROTATION_LEFT  = base::math::rotation3f( 0, 1, 0, base::math::deg2rad( -90 ) );
 const base::math::Matrix3f MPRDisplay::ROTATION_TOP   = base::math::rotation3f( 1, 0, 0, base::math::deg2rad( -90 ) );
@@ -357,6 +553,7 @@ MPRDisplay::MPRDisplay( const Configurator& cfg, QWidget* parent )
 
 MPRDisplay::~MPRDisplay()
 {
+    stopCine();
     removeFromMPR();
     pimpl->display->removeEventFilter( pimpl.get() );
 }
@@ -382,6 +579,19 @@ void MPRDisplay::invalidate()
 }
 
 
+void MPRDisplay::invalidateSlices()
+{
+    pimpl->planes->invalidate();
+    invalidate();
+}
+
+
+std::size_t MPRDisplay::slicesSampled() const
+{
+    return pimpl->planes->samplings();
+}
+
+
 void MPRDisplay::setLogTag( const std::string& tag )
 {
     pimpl->display->setLogTag( tag );
@@ -438,6 +648,18 @@ void MPRDisplay::removeFromMPR()
 }
 
 
+void MPRDisplay::setRenderOrchestrator( RenderOrchestrator& orchestrator )
+{
+    pimpl->display->setRenderOrchestrator( orchestrator );
+}
+
+
+void MPRDisplay::removeFromRenderOrchestrator()
+{
+    pimpl->display->removeFromRenderOrchestrator();
+}
+
+
 void MPRDisplay::setPlaneColor( const base::Color& color )
 {
     pimpl->planeData.color = color;
@@ -470,6 +692,14 @@ base::HUV MPRDisplay::windowingLevel() const
 }
 
 
+void MPRDisplay::setFusedVolumes( const std::vector< FusedVolume >& volumes )
+{
+    CARNA_ASSERT( volumes.size() <= MPR::MAX_VOLUMES );
+    pimpl->planes->setFusedVolumes( volumes );
+    invalidate();
+}
+
+
 unsigned int MPRDisplay::windowingWidth() const
 {
     return pimpl->planes->windowingWidth();
@@ -494,6 +724,142 @@ float MPRDisplay::zoomFactor() const
 }
 
 
+void MPRDisplay::setSlabThickness( float thickness )
+{
+    CARNA_ASSERT( thickness >= 0 );
+    pimpl->planes->setSlabThickness( thickness );
+    invalidate();
+}
+
+
+float MPRDisplay::slabThickness() const
+{
+    return pimpl->planes->slabThickness();
+}
+
+
+void MPRDisplay::setSlabMode( SlabMode mode )
+{
+    pimpl->planes->setSlabMode( mode );
+    invalidate();
+}
+
+
+MPRDisplay::SlabMode MPRDisplay::slabMode() const
+{
+    return pimpl->planes->slabMode();
+}
+
+
+void MPRDisplay::setSlabStep( float step )
+{
+    CARNA_ASSERT( step > 0 );
+    pimpl->planes->setSlabStep( step );
+    invalidate();
+}
+
+
+float MPRDisplay::slabStep() const
+{
+    return pimpl->planes->slabStep();
+}
+
+
+void MPRDisplay::setInteractiveSlabStep( float step )
+{
+    CARNA_ASSERT( step > 0 );
+    pimpl->planes->setInteractiveSlabStep( step );
+    invalidate();
+}
+
+
+float MPRDisplay::interactiveSlabStep() const
+{
+    return pimpl->planes->interactiveSlabStep();
+}
+
+
+void MPRDisplay::startCine( float framesPerSecond, float step )
+{
+    CARNA_ASSERT( framesPerSecond > 0 );
+    CARNA_ASSERT( step != 0 );
+    Details::Cine& cine = pimpl->cine;
+    cine.framesPerSecond = framesPerSecond;
+    cine.step = step;
+    cine.framesAdvanced = 0;
+    cine.framesDropped  = 0;
+    cine.samplingsAtStart = pimpl->onDemandSamplings();
+    cine.misses = 0;
+    pimpl->planes->setPrefetch( pimpl->plane, step, cine.prefetch );
+    
+    /* The timer fires more often than the frame rate, s.t. the frames are due
+     * when it fires, not up to a whole period later.
+     */
+    const int interval = static_cast< int >( 500 / framesPerSecond );
+    cine.clock.start();
+    cine.timer.start( interval, pimpl.get() );
+    invalidate();
+}
+
+
+void MPRDisplay::stopCine()
+{
+    if( pimpl->cine.timer.isActive() )
+    {
+        pimpl->cine.timer.stop();
+        pimpl->cine.misses = pimpl->onDemandSamplings() - pimpl->cine.samplingsAtStart;
+        pimpl->planes->setPrefetch( nullptr, 0, 0 );
+    }
+}
+
+
+bool MPRDisplay::isCineRunning() const
+{
+    return pimpl->cine.timer.isActive();
+}
+
+
+void MPRDisplay::setCinePrefetch( unsigned int count )
+{
+    pimpl->cine.prefetch = count;
+    if( isCineRunning() )
+    {
+        pimpl->planes->setPrefetch( pimpl->plane, pimpl->cine.step, count );
+    }
+}
+
+
+unsigned int MPRDisplay::cinePrefetch() const
+{
+    return pimpl->cine.prefetch;
+}
+
+
+std::size_t MPRDisplay::cineFramesAdvanced() const
+{
+    return pimpl->cine.framesAdvanced;
+}
+
+
+std::size_t MPRDisplay::cineFramesDropped() const
+{
+    return pimpl->cine.framesDropped;
+}
+
+
+std::size_t MPRDisplay::cinePrefetchMisses() const
+{
+    if( isCineRunning() )
+    {
+        return pimpl->onDemandSamplings() - pimpl->cine.samplingsAtStart;
+    }
+    else
+    {
+        return pimpl->cine.misses;
+    }
+}
+
+
 
 }  // namespace Carna :: qt
 
@@ -0,0 +1,200 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#include <Carna/qt/MPRDisplayPool.h>
+#include <Carna/base/RenderStageSequence.h>
+#include <Carna/base/RenderStage.h>
+#include <Carna/base/CarnaException.h>
+#include <Carna/presets/CuttingPlanesStage.h>
+#include <QPointer>
+#include <algorithm>
+#include <vector>
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// MPRDisplayPool :: Details
+// ----------------------------------------------------------------------------------
+
+/* The pool configures its displays itself, s.t. the configurator, that was passed
+ * to the constructor, is not required to outlive the pool. The displays are
+ * referenced by guarded pointers, because acquired displays might be deleted by
+ * their owners or parents without being released.
+ */
+struct MPRDisplayPool::Details : public MPRDisplay::Configurator
+{
+    explicit Details( const MPRDisplay::Configurator& cfg );
+
+    base::RenderStageSequence extraStages;
+    std::vector< QPointer< MPRDisplay > > idle;
+    std::vector< QPointer< MPRDisplay > > displays;
+    void forgetDeleted();
+    static void resetSettings( MPRDisplay& display );
+    static bool contains( const std::vector< QPointer< MPRDisplay > >& among, const MPRDisplay& display );
+
+    virtual void addExtraStages( base::RenderStageSequence& toSequence ) const override;
+};
+
+
+MPRDisplayPool::Details::Details( const MPRDisplay::Configurator& cfg )
+    : MPRDisplay::Configurator( cfg.parameters )
+{
+    cfg.addExtraStages( extraStages );
+}
+
+
+void MPRDisplayPool::Details::forgetDeleted()
+{
+    const auto isDeleted = []( const QPointer< MPRDisplay >& display )
+        {
+            return display.isNull();
+        };
+    idle    .erase( std::remove_if( idle    .begin(), idle    .end(), isDeleted ), idle    .end() );
+    displays.erase( std::remove_if( displays.begin(), displays.end(), isDeleted ), displays.end() );
+}
+
+
+void MPRDisplayPool::Details::resetSettings( MPRDisplay& display )
+{
+    display.setRotation( MPRDisplay::ROTATION_FRONT );
+    display.setPlaneColor( MPRDisplay::DEFAULT_PLANE_COLOR );
+    display.setWindowingLevel( presets::CuttingPlanesStage::DEFAULT_WINDOWING_LEVEL );
+    display.setWindowingWidth( presets::CuttingPlanesStage::DEFAULT_WINDOWING_WIDTH );
+    display.setFusedVolumes( std::vector< MPRDisplay::FusedVolume >() );
+    display.setSlabThickness( 0 );
+    display.setSlabMode( MPRDisplay::maximumIntensityProjection );
+    display.setSlabStep( MPRDisplay::DEFAULT_SLAB_STEP );
+    display.setInteractiveSlabStep( MPRDisplay::DEFAULT_INTERACTIVE_SLAB_STEP );
+    display.setCinePrefetch( MPRDisplay::DEFAULT_CINE_PREFETCH );
+}
+
+
+bool MPRDisplayPool::Details::contains( const std::vector< QPointer< MPRDisplay > >& among, const MPRDisplay& display )
+{
+    for( auto displayItr = among.begin(); displayItr != among.end(); ++displayItr )
+    {
+        if( displayItr->data() == &display )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+void MPRDisplayPool::Details::addExtraStages( base::RenderStageSequence& toSequence ) const
+{
+    for( std::size_t rsIdx = 0; rsIdx < extraStages.stages(); ++rsIdx )
+    {
+        toSequence.appendStage( extraStages.stageAt( rsIdx ).clone() );
+    }
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// MPRDisplayPool
+// ----------------------------------------------------------------------------------
+
+MPRDisplayPool::MPRDisplayPool( const MPRDisplay::Configurator& cfg )
+    : pimpl( new Details( cfg ) )
+    , parameters( cfg.parameters )
+{
+}
+
+
+MPRDisplayPool::~MPRDisplayPool()
+{
+    pimpl->forgetDeleted();
+    for( auto displayItr = pimpl->idle.begin(); displayItr != pimpl->idle.end(); ++displayItr )
+    {
+        delete displayItr->data();
+    }
+}
+
+
+void MPRDisplayPool::reserveWidgets( std::size_t count )
+{
+    pimpl->forgetDeleted();
+    pimpl->idle.reserve( count );
+    while( pimpl->idle.size() < count )
+    {
+        MPRDisplay* const display = new MPRDisplay( *pimpl );
+        pimpl->displays.push_back( display );
+        pimpl->idle.push_back( display );
+    }
+}
+
+
+MPRDisplay& MPRDisplayPool::acquire( QWidget* parent )
+{
+    pimpl->forgetDeleted();
+    if( pimpl->idle.empty() )
+    {
+        MPRDisplay* const display = new MPRDisplay( *pimpl, parent );
+        pimpl->displays.push_back( display );
+        return *display;
+    }
+    else
+    {
+        MPRDisplay* const display = pimpl->idle.back().data();
+        pimpl->idle.pop_back();
+        display->setParent( parent );
+        if( parent != nullptr )
+        {
+            /* The display was hidden explicitly when it was released.
+             */
+            display->show();
+        }
+        return *display;
+    }
+}
+
+
+void MPRDisplayPool::release( MPRDisplay& display )
+{
+    pimpl->forgetDeleted();
+    CARNA_ASSERT(  Details::contains( pimpl->displays, display ) );
+    CARNA_ASSERT( !Details::contains( pimpl->idle    , display ) );
+    display.stopCine();
+    display.removeFromMPR();
+    display.removeFromRenderOrchestrator();
+    Details::resetSettings( display );
+    display.hide();
+    display.setParent( nullptr );
+    pimpl->idle.push_back( &display );
+}
+
+
+std::size_t MPRDisplayPool::idle() const
+{
+    pimpl->forgetDeleted();
+    return pimpl->idle.size();
+}
+
+
+std::size_t MPRDisplayPool::created() const
+{
+    pimpl->forgetDeleted();
+    return pimpl->displays.size();
+}
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
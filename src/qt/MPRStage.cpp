@@ -9,21 +9,15 @@
  *
  */
 
+#include <Carna/base/glew.h>
 #include <Carna/qt/MPRStage.h>
 #include <Carna/qt/MPRDisplay.h>
 #include <Carna/qt/MPRDataFeature.h>
-#include <Carna/base/Mesh.h>
-#include <Carna/base/Vertex.h>
-#include <Carna/base/ShaderManager.h>
-#include <Carna/base/ShaderUniform.h>
-#include <Carna/base/Composition.h>
-#include <Carna/base/VertexBuffer.h>
-#include <Carna/base/IndexBuffer.h>
+#include <Carna/qt/ShaderResources.h>
+#include <Carna/base/ShaderProgram.h>
 #include <Carna/base/RenderState.h>
 #include <Carna/base/RenderTask.h>
-#include <map>
-#include <QFile>
-#include <QTextStream>
+#include <vector>
 
 namespace Carna
 {
@@ -44,38 +38,33 @@ struct MPRStage::Details
     
     Details();
     const base::RenderTask* renderTask;
-    static bool shaderSourcedLoaded;
-    
-    static std::string readResource( const std::string& name );
     
     ProjectedPlane horizontal;
     ProjectedPlane vertical;
+    
+    /* The lines of a pass are collected and rendered by a single instanced draw
+     * call. Each instance holds the clipping coordinates of both ends and the
+     * color of the line.
+     */
+    const static std::size_t FLOATS_PER_LINE = 12;
+    std::vector< float > lines;
+    void appendLine( const base::math::Vector4f& start, const base::math::Vector4f& end, const base::Color& color );
 };
 
 
-bool MPRStage::Details::shaderSourcedLoaded = false;
-
-
 MPRStage::Details::Details()
 {
-    if( !shaderSourcedLoaded )
-    {
-        base::ShaderManager::instance().setSource( "mpr.vert", readResource( ":/shaders/mpr.vert" ) );
-        base::ShaderManager::instance().setSource( "mpr.frag", readResource( ":/shaders/mpr.frag" ) );
-        shaderSourcedLoaded = true;
-    }
 }
 
 
-std::string MPRStage::Details::readResource( const std::string& name )
+void MPRStage::Details::appendLine( const base::math::Vector4f& start, const base::math::Vector4f& end, const base::Color& color )
 {
-    QFile srcFile( QString::fromStdString( name ) );
-    const bool ok = srcFile.open( QFile::ReadOnly | QFile::Text );
-    CARNA_ASSERT_EX( ok, "Failed to open resource file: \"" << name + "\"" );
-    QTextStream in( &srcFile );
-    const QString text = in.readAll();
-    srcFile.close();
-    return text.toStdString();
+    lines.insert( lines.end(), start.data(), start.data() + 4 );
+    lines.insert( lines.end(), end.data(), end.data() + 4 );
+    lines.push_back( color.r / 255.f );
+    lines.push_back( color.g / 255.f );
+    lines.push_back( color.b / 255.f );
+    lines.push_back( color.a / 255.f );
 }
 
 
@@ -100,56 +89,75 @@ struct MPRStage::Details::VideoResources
     VideoResources();
     ~VideoResources();
     
-    typedef base::Mesh< base::VertexBase, uint8_t > LineMesh;
-    const std::unique_ptr< LineMesh > lineMesh;
-    static LineMesh* createLineMesh();
     const base::ShaderProgram& shader;
+    
+    /* The vertex buffer holds the two ends of the line, that is instanced. The
+     * instance buffer grows as needed, but is never shrunk.
+     */
+    GLuint vertexArray;
+    GLuint vertexBuffer;
+    GLuint instanceBuffer;
+    std::size_t instanceBufferSize;
+    void render( const std::vector< float >& lines );
 };
 
 
 MPRStage::Details::VideoResources::VideoResources()
-    : lineMesh( createLineMesh() )
-    , shader( base::ShaderManager::instance().acquireShader( "mpr" ) )
+    : shader( ShaderResources::acquire( "mpr" ) )
+    , instanceBufferSize( 0 )
 {
+    const float lineParameters[ 2 ] = { 0, 1 };
+    glGenVertexArrays( 1, &vertexArray );
+    glBindVertexArray( vertexArray );
+    
+    glGenBuffers( 1, &vertexBuffer );
+    glBindBuffer( GL_ARRAY_BUFFER, vertexBuffer );
+    glBufferData( GL_ARRAY_BUFFER, sizeof( lineParameters ), lineParameters, GL_STATIC_DRAW );
+    glEnableVertexAttribArray( 0 );
+    glVertexAttribPointer( 0, 1, GL_FLOAT, GL_FALSE, 0, nullptr );
+    
+    glGenBuffers( 1, &instanceBuffer );
+    glBindBuffer( GL_ARRAY_BUFFER, instanceBuffer );
+    const GLsizei stride = FLOATS_PER_LINE * sizeof( float );
+    for( GLuint attribute = 1; attribute <= 3; ++attribute )
+    {
+        glEnableVertexAttribArray( attribute );
+        glVertexAttribPointer( attribute, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast< const void* >( ( attribute - 1 ) * 4 * sizeof( float ) ) );
+        glVertexAttribDivisor( attribute, 1 );
+    }
+    
+    glBindVertexArray( 0 );
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
 }
 
 
 MPRStage::Details::VideoResources::~VideoResources()
 {
-    base::ShaderManager::instance().releaseShader( shader );
+    glDeleteBuffers( 1, &instanceBuffer );
+    glDeleteBuffers( 1, &vertexBuffer );
+    glDeleteVertexArrays( 1, &vertexArray );
+    ShaderResources::release( shader );
 }
 
 
-MPRStage::Details::VideoResources::LineMesh* MPRStage::Details::VideoResources::createLineMesh()
+void MPRStage::Details::VideoResources::render( const std::vector< float >& lines )
 {
-    base::VertexBase vertices[ 2 ];
-    uint8_t indices[ 2 ];
-
-    vertices[ 0 ].x = -1;
-    vertices[ 0 ].y = -1;
-    indices [ 0 ] = 0;
-
-    vertices[ 1 ].x = +1;
-    vertices[ 1 ].y = +1;
-    indices [ 1 ] = 1;
-    
-    /* Create vertex buffer.
-     */
-    typedef base::VertexBuffer< LineMesh::Vertex > VBuffer;
-    VBuffer* const vertexBuffer = new VBuffer();
-    vertexBuffer->copy( vertices, 2 );
+    const std::size_t size = lines.size() * sizeof( float );
+    glBindBuffer( GL_ARRAY_BUFFER, instanceBuffer );
+    if( size > instanceBufferSize )
+    {
+        glBufferData( GL_ARRAY_BUFFER, size, &lines.front(), GL_STREAM_DRAW );
+        instanceBufferSize = size;
+    }
+    else
+    {
+        glBufferSubData( GL_ARRAY_BUFFER, 0, size, &lines.front() );
+    }
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
     
-    /* Create index buffer.
-     */
-    typedef base::IndexBuffer< LineMesh::Index > IBuffer;
-    IBuffer* const indexBuffer = new IBuffer( base::IndexBufferBase::PRIMITIVE_TYPE_LINES );
-    indexBuffer->copy( indices, 2 );
-
-    /* Create the mesh.
-     */
-    return new LineMesh
-        ( new base::Composition< base::VertexBufferBase >( vertexBuffer )
-        , new base::Composition< base:: IndexBufferBase >(  indexBuffer ) );
+    glBindVertexArray( vertexArray );
+    glDrawArraysInstanced( GL_LINES, 0, 2, static_cast< GLsizei >( lines.size() / FLOATS_PER_LINE ) );
+    glBindVertexArray( 0 );
 }
 
 
@@ -172,7 +180,9 @@ MPRStage::~MPRStage()
 
 MPRStage* MPRStage::clone() const
 {
-    CARNA_FAIL( "MPRSTage::clone not implemented!" );
+    MPRStage* const result = new MPRStage( geometryType );
+    result->setEnabled( isEnabled() );
+    return result;
 }
 
 
@@ -204,21 +214,25 @@ void MPRStage::renderPass
     rs.setDepthTest( false );
     rs.setDepthWrite( false );
 
-    /* Configure shader.
-     */
-    rt.renderer.glContext().setShader( pimpl->vr->shader );
-    base::ShaderUniform< base::Color >( "color", base::Color::RED ).upload();
-    
     /* Reset the plane data.
      */
     pimpl->horizontal.plane = nullptr;
     pimpl->  vertical.plane = nullptr;
     
-    /* Do the rendering.
+    /* Collect the lines.
      */
+    pimpl->lines.clear();
     pimpl->renderTask = &rt;
     base::GeometryStage< void >::renderPass( vt, rt, vp );
     pimpl->renderTask = nullptr;
+    
+    /* Do the rendering.
+     */
+    if( !pimpl->lines.empty() )
+    {
+        rt.renderer.glContext().setShader( pimpl->vr->shader );
+        pimpl->vr->render( pimpl->lines );
+    }
 }
 
 
@@ -228,7 +242,6 @@ void MPRStage::render( const base::Renderable& renderable )
     const base::math::Vector4f a = modelViewProjection * base::math::Vector4f( -100, -100, 0, 1 );
     const base::math::Vector4f b = modelViewProjection * base::math::Vector4f( +100, +100, 0, 1 );
     
-    MPRDataFeature& feature = static_cast< MPRDataFeature& >( renderable.geometry().feature( ROLE_PLANE_DATA ) );
     if( !base::math::isEqual( a.z(), b.z() ) )
     {
         const base::math::Vector4f c = modelViewProjection * base::math::Vector4f( 0, 0, +100, 1 );
@@ -239,14 +252,17 @@ void MPRStage::render( const base::Renderable& renderable )
             color = &feature.color;
         }
     
-        base::ShaderUniform< base::math::Matrix4f >( "modelViewProjection", modelViewProjection ).upload();
-        base::ShaderUniform< base::Color >( "color", *color ).upload();
+        /* The line spans the whole viewport along the axis it is parallel to.
+         */
+        base::math::Vector4f start = modelViewProjection * base::math::Vector4f( -1, -1, 0, 1 );
+        base::math::Vector4f end   = modelViewProjection * base::math::Vector4f( +1, +1, 0, 1 );
         if( base::math::isEqual( a.x(), b.x() ) )
         {
             /* Rendering vertical line.
              */
-            base::ShaderUniform< unsigned int >( "isHorizontal", 0 ).upload();
-            pimpl->vr->lineMesh->render();
+            start.y() = -1;
+            end  .y() = +1;
+            pimpl->appendLine( start, end, *color );
             pimpl->vertical.plane = &renderable.geometry();
             pimpl->vertical.clippingCoordinate = a.x();
             pimpl->vertical.direction = ( a.x() - c.x() ) < 0 ? -1 : +1;
@@ -256,8 +272,9 @@ void MPRStage::render( const base::Renderable& renderable )
         {
             /* Rendering horizontal line.
              */
-            base::ShaderUniform< unsigned int >( "isHorizontal", 1 ).upload();
-            pimpl->vr->lineMesh->render();
+            start.x() = -1;
+            end  .x() = +1;
+            pimpl->appendLine( start, end, *color );
             pimpl->horizontal.plane = &renderable.geometry();
             pimpl->horizontal.clippingCoordinate = a.y();
             pimpl->horizontal.direction = ( a.y() - c.y() ) < 0 ? -1 : +1;
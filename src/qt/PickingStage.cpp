@@ -0,0 +1,419 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#include <Carna/base/glew.h>
+#include <Carna/qt/PickingStage.h>
+#include <Carna/qt/ShaderResources.h>
+#include <Carna/base/ManagedMesh.h>
+#include <Carna/base/Framebuffer.h>
+#include <Carna/base/RenderTexture.h>
+#include <Carna/base/ShaderProgram.h>
+#include <Carna/base/RenderState.h>
+#include <Carna/base/RenderTask.h>
+#include <Carna/base/Renderable.h>
+#include <Carna/base/Viewport.h>
+#include <Carna/base/Geometry.h>
+#include <Carna/base/GLContext.h>
+#include <Carna/base/Node.h>
+#include <Carna/base/NodeListener.h>
+#include <vector>
+#include <algorithm>
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// PickingStage :: Details
+// ----------------------------------------------------------------------------------
+
+struct PickingStage::Details : public base::NodeListener
+{
+    Details();
+    ~Details();
+
+    const base::RenderTask* renderTask;
+    base::Node* root;
+    void setRoot( base::Node& root );
+    std::vector< const base::Geometry* > geometries;
+
+    struct VideoResources;
+    std::unique_ptr< VideoResources > vr;
+    unsigned int width;
+    unsigned int height;
+
+    /* Each readback buffer remembers the geometry objects that the IDs it holds
+     * refer to, and the size of the frame it was read from.
+     */
+    struct ReadbackBuffer
+    {
+        ReadbackBuffer();
+        GLuint pbo;
+        GLsync fence;
+        unsigned int width;
+        unsigned int height;
+        std::vector< const base::Geometry* > geometries;
+    };
+
+    ReadbackBuffer buffers[ 2 ];
+    unsigned int nextBuffer;
+    void releaseBuffers();
+    void forgetGeometries();
+    const ReadbackBuffer* latestCompletedBuffer() const;
+    
+    /* The geometry objects, that the readback buffers refer to, might be detached
+     * and deleted when the scene changes. Hence the buffers forget them, until
+     * they are written by the next frame.
+     */
+    virtual void onNodeDelete( const base::Node& node ) override;
+    virtual void onTreeChange( base::Node& node, bool inThisSubtree ) override;
+    virtual void onTreeInvalidated( base::Node& subtree ) override;
+
+    static void uploadId( GLint location, std::size_t id );
+};
+
+
+struct PickingStage::Details::VideoResources
+{
+    VideoResources( unsigned int width, unsigned int height );
+    ~VideoResources();
+
+    base::RenderTexture colorBuffer;
+    base::Framebuffer fbo;
+    const base::ShaderProgram& shader;
+    const GLint modelViewProjectionLocation;
+    const GLint geometryIdLocation;
+};
+
+
+PickingStage::Details::VideoResources::VideoResources( unsigned int width, unsigned int height )
+    : colorBuffer( width, height )
+    , fbo( width, height, colorBuffer )
+    , shader( ShaderResources::acquire( "pick" ) )
+    , modelViewProjectionLocation( glGetUniformLocation( shader.id, "modelViewProjection" ) )
+    , geometryIdLocation( glGetUniformLocation( shader.id, "geometryId" ) )
+{
+}
+
+
+PickingStage::Details::VideoResources::~VideoResources()
+{
+    ShaderResources::release( shader );
+}
+
+
+PickingStage::Details::ReadbackBuffer::ReadbackBuffer()
+    : pbo( 0 )
+    , fence( 0 )
+    , width( 0 )
+    , height( 0 )
+{
+}
+
+
+PickingStage::Details::Details()
+    : renderTask( nullptr )
+    , root( nullptr )
+    , width( 0 )
+    , height( 0 )
+    , nextBuffer( 0 )
+{
+}
+
+
+PickingStage::Details::~Details()
+{
+    if( root != nullptr )
+    {
+        root->removeNodeListener( *this );
+    }
+    releaseBuffers();
+}
+
+
+void PickingStage::Details::setRoot( base::Node& root )
+{
+    if( this->root != &root )
+    {
+        if( this->root != nullptr )
+        {
+            this->root->removeNodeListener( *this );
+        }
+        this->root = &root;
+        root.addNodeListener( *this );
+        forgetGeometries();
+    }
+}
+
+
+void PickingStage::Details::releaseBuffers()
+{
+    for( unsigned int bufferIdx = 0; bufferIdx < 2; ++bufferIdx )
+    {
+        ReadbackBuffer& buffer = buffers[ bufferIdx ];
+        if( buffer.fence != 0 )
+        {
+            glDeleteSync( buffer.fence );
+            buffer.fence = 0;
+        }
+        if( buffer.pbo != 0 )
+        {
+            glDeleteBuffers( 1, &buffer.pbo );
+            buffer.pbo = 0;
+        }
+        buffer.geometries.clear();
+    }
+}
+
+
+void PickingStage::Details::forgetGeometries()
+{
+    for( unsigned int bufferIdx = 0; bufferIdx < 2; ++bufferIdx )
+    {
+        buffers[ bufferIdx ].geometries.clear();
+    }
+}
+
+
+void PickingStage::Details::onNodeDelete( const base::Node& node )
+{
+    /* We are not allowed to remove the listener from the dying node.
+     */
+    root = nullptr;
+    forgetGeometries();
+}
+
+
+void PickingStage::Details::onTreeChange( base::Node& node, bool inThisSubtree )
+{
+    forgetGeometries();
+}
+
+
+void PickingStage::Details::onTreeInvalidated( base::Node& subtree )
+{
+}
+
+
+const PickingStage::Details::ReadbackBuffer* PickingStage::Details::latestCompletedBuffer() const
+{
+    /* Query the more recent buffer first. Waiting with zero timeout only polls the
+     * state of the fence, hence this never stalls. The fence must be flushed, or
+     * it might never become signaled when polled this way.
+     */
+    for( unsigned int offset = 1; offset <= 2; ++offset )
+    {
+        const ReadbackBuffer& buffer = buffers[ ( nextBuffer + 2 - offset ) % 2 ];
+        if( buffer.fence != 0 )
+        {
+            const GLenum state = glClientWaitSync( buffer.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0 );
+            if( state == GL_ALREADY_SIGNALED || state == GL_CONDITION_SATISFIED )
+            {
+                return &buffer;
+            }
+        }
+    }
+    return nullptr;
+}
+
+
+void PickingStage::Details::uploadId( GLint location, std::size_t id )
+{
+    glUniform4f
+        ( location
+        , ( ( id >>  0 ) & 0xFF ) / 255.f
+        , ( ( id >>  8 ) & 0xFF ) / 255.f
+        , ( ( id >> 16 ) & 0xFF ) / 255.f
+        , 1 );
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// PickingStage
+// ----------------------------------------------------------------------------------
+
+PickingStage::PickingStage( unsigned int geometryType, unsigned int meshRole )
+    : base::GeometryStage< void >::GeometryStage( geometryType )
+    , meshRole( meshRole )
+    , pimpl( new Details() )
+{
+}
+
+
+PickingStage::~PickingStage()
+{
+    /* Release the video resources before the pixel buffer objects, s.t. the order
+     * is the reverse of their acquisition.
+     */
+    pimpl->vr.reset();
+    pimpl->releaseBuffers();
+}
+
+
+PickingStage* PickingStage::clone() const
+{
+    PickingStage* const result = new PickingStage( geometryType, meshRole );
+    result->setEnabled( isEnabled() );
+    return result;
+}
+
+
+void PickingStage::prepareFrame( base::Node& root )
+{
+    base::GeometryStage< void >::prepareFrame( root );
+    pimpl->setRoot( root );
+}
+
+
+void PickingStage::reshape( base::FrameRenderer& fr, unsigned int width, unsigned int height )
+{
+    base::GeometryStage< void >::reshape( fr, width, height );
+    pimpl->width  = width;
+    pimpl->height = height;
+    pimpl->vr.reset();
+    pimpl->releaseBuffers();
+}
+
+
+void PickingStage::renderPass
+    ( const base::math::Matrix4f& vt
+    , base::RenderTask& rt
+    , const base::Viewport& vp )
+{
+    if( pimpl->vr.get() == nullptr )
+    {
+        pimpl->vr.reset( new Details::VideoResources( pimpl->width, pimpl->height ) );
+    }
+
+    /* Fetch the buffer the IDs are to be written to. Its previous copy was
+     * issued two frames ago, hence it most likely has completed already.
+     */
+    Details::ReadbackBuffer& buffer = pimpl->buffers[ pimpl->nextBuffer ];
+    if( buffer.fence != 0 )
+    {
+        glDeleteSync( buffer.fence );
+        buffer.fence = 0;
+    }
+    if( buffer.pbo == 0 )
+    {
+        glGenBuffers( 1, &buffer.pbo );
+        glBindBuffer( GL_PIXEL_PACK_BUFFER, buffer.pbo );
+        glBufferData( GL_PIXEL_PACK_BUFFER, pimpl->width * pimpl->height * 4, nullptr, GL_STREAM_READ );
+        glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+    }
+    pimpl->geometries.clear();
+
+    CARNA_RENDER_TO_FRAMEBUFFER( pimpl->vr->fbo,
+
+        /* Configure proper GL state.
+         */
+        base::RenderState rs;
+        rs.setDepthTest( true );
+        rs.setDepthWrite( true );
+        rs.setBlend( false );
+
+        /* Clear the buffers, s.t. ID 0 denotes the background.
+         */
+        glClearColor( 0, 0, 0, 0 );
+        rt.renderer.glContext().clearBuffers( base::GLContext::COLOR_BUFFER_BIT | base::GLContext::DEPTH_BUFFER_BIT );
+
+        /* Render the color-coded geometry.
+         */
+        vp.makeActive();
+        rt.renderer.glContext().setShader( pimpl->vr->shader );
+        pimpl->renderTask = &rt;
+        base::GeometryStage< void >::renderPass( vt, rt, vp );
+        pimpl->renderTask = nullptr;
+        vp.done();
+
+        /* Issue the asynchronous copy to the pixel buffer object.
+         */
+        glBindBuffer( GL_PIXEL_PACK_BUFFER, buffer.pbo );
+        glPixelStorei( GL_PACK_ALIGNMENT, 4 );
+        glReadPixels( 0, 0, pimpl->width, pimpl->height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr );
+        glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+        buffer.fence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+
+    );
+
+    buffer.width  = pimpl->width;
+    buffer.height = pimpl->height;
+    buffer.geometries.swap( pimpl->geometries );
+    pimpl->nextBuffer = ( pimpl->nextBuffer + 1 ) % 2;
+}
+
+
+void PickingStage::render( const base::Renderable& renderable )
+{
+    /* IDs are one-based since zero denotes the background.
+     */
+    pimpl->geometries.push_back( &renderable.geometry() );
+    const std::size_t id = pimpl->geometries.size();
+
+    const base::math::Matrix4f modelViewProjection = pimpl->renderTask->projection * renderable.modelViewTransform();
+    glUniformMatrix4fv( pimpl->vr->modelViewProjectionLocation, 1, GL_FALSE, modelViewProjection.data() );
+    Details::uploadId( pimpl->vr->geometryIdLocation, id );
+
+    const base::ManagedMeshBase& mesh = static_cast< const base::ManagedMeshBase& >( renderable.geometry().feature( meshRole ) );
+    videoResource( mesh ).get().render();
+}
+
+
+bool PickingStage::isReady() const
+{
+    return pimpl->latestCompletedBuffer() != nullptr;
+}
+
+
+base::Aggregation< const base::Geometry > PickingStage::pick( unsigned int x, unsigned int y ) const
+{
+    const Details::ReadbackBuffer* const buffer = pimpl->latestCompletedBuffer();
+    if( buffer == nullptr || x >= buffer->width || y >= buffer->height )
+    {
+        return base::Aggregation< const base::Geometry >::NULL_PTR;
+    }
+
+    /* Map only the single pixel that is queried. OpenGL stores the rows
+     * bottom-up, whereas 'y' refers to the upper edge.
+     */
+    const std::size_t offset = ( ( buffer->height - 1 - y ) * buffer->width + x ) * 4;
+    unsigned char rgba[ 4 ] = { 0, 0, 0, 0 };
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, buffer->pbo );
+    const unsigned char* const mapped = static_cast< const unsigned char* >
+        ( glMapBufferRange( GL_PIXEL_PACK_BUFFER, offset, 4, GL_MAP_READ_BIT ) );
+    if( mapped != nullptr )
+    {
+        std::copy( mapped, mapped + 4, rgba );
+        glUnmapBuffer( GL_PIXEL_PACK_BUFFER );
+    }
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+
+    const std::size_t id = rgba[ 0 ] | ( rgba[ 1 ] << 8 ) | ( rgba[ 2 ] << 16 );
+    if( id == 0 || id > buffer->geometries.size() )
+    {
+        return base::Aggregation< const base::Geometry >::NULL_PTR;
+    }
+    else
+    {
+        return base::Aggregation< const base::Geometry >( *buffer->geometries[ id - 1 ] );
+    }
+}
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
@@ -0,0 +1,236 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#include <Carna/base/glew.h>
+#include <Carna/qt/RenderOrchestrator.h>
+#include <Carna/qt/Display.h>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QGLContext>
+#include <QTimer>
+#include <algorithm>
+#include <vector>
+#include <set>
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// RenderOrchestrator :: Details
+// ----------------------------------------------------------------------------------
+
+struct RenderOrchestrator::Details
+{
+    Details();
+
+    std::set< Display* > displays;
+    std::vector< Display* > due;
+    QTimer passTimer;
+
+    /* The vector is kept across passes, s.t. its capacity is reused.
+     */
+    std::vector< Display* > pass;
+
+    std::size_t passes;
+    std::size_t lastPassDisplays;
+    double lastPassTime;
+    bool isGPUTimeIncluded;
+};
+
+
+RenderOrchestrator::Details::Details()
+    : passes( 0 )
+    , lastPassDisplays( 0 )
+    , lastPassTime( 0 )
+    , isGPUTimeIncluded( false )
+{
+    passTimer.setSingleShot( true );
+    passTimer.setInterval( 0 );
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// RenderOrchestrator
+// ----------------------------------------------------------------------------------
+
+const QEvent::Type RenderOrchestrator::PRE_PASS_EVENT = static_cast< QEvent::Type >( QEvent::registerEventType() );
+
+
+RenderOrchestrator::RenderOrchestrator()
+    : pimpl( new Details() )
+{
+    connect( &pimpl->passTimer, SIGNAL( timeout() ), this, SLOT( renderPass() ) );
+}
+
+
+RenderOrchestrator::~RenderOrchestrator()
+{
+    const std::vector< Display* > displays( pimpl->displays.begin(), pimpl->displays.end() );
+    for( auto displayItr = displays.begin(); displayItr != displays.end(); ++displayItr )
+    {
+        removeDisplay( **displayItr );
+    }
+}
+
+
+void RenderOrchestrator::addDisplay( Display& display )
+{
+    const std::size_t originalDisplaysCount = pimpl->displays.size();
+    pimpl->displays.insert( &display );
+    if( originalDisplaysCount != pimpl->displays.size() )
+    {
+        pimpl->due .reserve( pimpl->displays.size() );
+        pimpl->pass.reserve( pimpl->displays.size() );
+        display.setRenderOrchestrator( *this );
+    }
+}
+
+
+void RenderOrchestrator::removeDisplay( Display& display )
+{
+    const std::size_t originalDisplaysCount = pimpl->displays.size();
+    pimpl->displays.erase( &display );
+    if( originalDisplaysCount != pimpl->displays.size() )
+    {
+        const auto dueItr = std::find( pimpl->due.begin(), pimpl->due.end(), &display );
+        if( dueItr != pimpl->due.end() )
+        {
+            pimpl->due.erase( dueItr );
+        }
+        display.removeFromRenderOrchestrator();
+    }
+}
+
+
+std::size_t RenderOrchestrator::displays() const
+{
+    return pimpl->displays.size();
+}
+
+
+void RenderOrchestrator::schedule( Display& display )
+{
+    CARNA_ASSERT( pimpl->displays.find( &display ) != pimpl->displays.end() );
+    if( std::find( pimpl->due.begin(), pimpl->due.end(), &display ) == pimpl->due.end() )
+    {
+        pimpl->due.push_back( &display );
+    }
+    requestPass();
+}
+
+
+void RenderOrchestrator::requestPass()
+{
+    if( !pimpl->passTimer.isActive() )
+    {
+        pimpl->passTimer.start();
+    }
+}
+
+
+void RenderOrchestrator::renderPass()
+{
+    /* Let the displays apply their pending input. This might make them due.
+     */
+    QEvent prePassEvent( PRE_PASS_EVENT );
+    for( auto displayItr = pimpl->displays.begin(); displayItr != pimpl->displays.end(); ++displayItr )
+    {
+        QCoreApplication::sendEvent( *displayItr, &prePassEvent );
+    }
+
+    if( pimpl->due.empty() )
+    {
+        return;
+    }
+
+    QElapsedTimer clock;
+    clock.start();
+
+    /* Displays that are invalidated while the pass is rendered are due for the
+     * next pass, hence the due displays are moved to the pass beforehand.
+     */
+    pimpl->pass.swap( pimpl->due );
+    pimpl->due.clear();
+
+    /* Each display renders within its own context. Start with the display whose
+     * context already is current, s.t. no context switch is required for it.
+     */
+    const QGLContext* const currentContext = QGLContext::currentContext();
+    const auto currentItr = std::find_if( pimpl->pass.begin(), pimpl->pass.end(), [currentContext]( const Display* display )
+        {
+            return currentContext != nullptr && display->context() == currentContext;
+        }
+    );
+    if( currentItr != pimpl->pass.end() )
+    {
+        std::iter_swap( pimpl->pass.begin(), currentItr );
+    }
+
+    /* The context of each display stays current after it was rendered. Waiting for
+     * its commands to finish makes the measured time include the GPU's work, but
+     * it also stalls the CPU, hence this is only done on demand.
+     */
+    for( auto displayItr = pimpl->pass.begin(); displayItr != pimpl->pass.end(); ++displayItr )
+    {
+        ( **displayItr ).updateGL();
+        if( pimpl->isGPUTimeIncluded )
+        {
+            glFinish();
+        }
+    }
+
+    ++pimpl->passes;
+    pimpl->lastPassDisplays = pimpl->pass.size();
+    pimpl->lastPassTime = clock.nsecsElapsed() / 1e6;
+    emit passRendered( pimpl->lastPassTime, static_cast< unsigned int >( pimpl->lastPassDisplays ) );
+}
+
+
+std::size_t RenderOrchestrator::passes() const
+{
+    return pimpl->passes;
+}
+
+
+std::size_t RenderOrchestrator::lastPassDisplays() const
+{
+    return pimpl->lastPassDisplays;
+}
+
+
+double RenderOrchestrator::lastPassTime() const
+{
+    return pimpl->lastPassTime;
+}
+
+
+void RenderOrchestrator::setGPUTimeIncluded( bool gpuTimeIncluded )
+{
+    pimpl->isGPUTimeIncluded = gpuTimeIncluded;
+}
+
+
+bool RenderOrchestrator::isGPUTimeIncluded() const
+{
+    return pimpl->isGPUTimeIncluded;
+}
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
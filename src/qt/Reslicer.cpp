@@ -0,0 +1,420 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#include <Carna/qt/Reslicer.h>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QThread>
+#include <algorithm>
+#include <vector>
+#include <cmath>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#   define CARNAQT_RESLICER_SSE2
+#   include <emmintrin.h>
+#endif
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// Reslicer :: Details
+// ----------------------------------------------------------------------------------
+
+struct Reslicer::Details
+{
+    explicit Details( const base::HUVolume& volume );
+
+    const base::math::Vector3ui size;
+    std::vector< signed short > voxels;
+    QThreadPool threadPool;
+
+    /* Maps the pixel coordinates of a slice to voxel coordinates, where each
+     * pixel row is sampled from 'origin' onwards in 'step' increments.
+     */
+    struct Sampling
+    {
+        Sampling( const base::math::Matrix4f& sliceTransform, const base::math::Vector3ui& size );
+        float origin[ 3 ];
+        float rowStep[ 3 ];
+        float step[ 3 ];
+    };
+
+    void sampleRow( const Sampling& sampling, unsigned int y, unsigned int width, float* huvs ) const;
+    float sample( float x, float y, float z ) const;
+
+    /* Computes the rows of a band and writes them by a 'RowWriter', that is
+     * invoked with the row's index and its HUV.
+     */
+    template< typename RowWriter >
+    void compute( const base::math::Matrix4f& sliceTransform, unsigned int width, unsigned int height, const RowWriter& writeRow );
+};
+
+
+Reslicer::Details::Details( const base::HUVolume& volume )
+    : size( volume.size )
+    , voxels( static_cast< std::size_t >( volume.size.x() ) * volume.size.y() * volume.size.z() )
+{
+    CARNA_ASSERT( size.x() >= 2 && size.y() >= 2 && size.z() >= 2 );
+    std::size_t voxelIdx = 0;
+    for( unsigned int z = 0; z < size.z(); ++z )
+    for( unsigned int y = 0; y < size.y(); ++y )
+    for( unsigned int x = 0; x < size.x(); ++x )
+    {
+        voxels[ voxelIdx++ ] = static_cast< signed short >( volume( x, y, z ) );
+    }
+}
+
+
+Reslicer::Details::Sampling::Sampling( const base::math::Matrix4f& sliceTransform, const base::math::Vector3ui& size )
+{
+    /* The model space is the unit cube, whose corners are the centers of the
+     * corner voxels.
+     */
+    base::math::Matrix4f modelToVoxels = base::math::identity4f();
+    for( unsigned int axis = 0; axis < 3; ++axis )
+    {
+        modelToVoxels( axis, axis ) = static_cast< float >( size[ axis ] - 1 );
+        modelToVoxels( axis, 3 ) = modelToVoxels( axis, axis ) / 2;
+    }
+    const base::math::Matrix4f sliceToVoxels = modelToVoxels * sliceTransform;
+    for( unsigned int axis = 0; axis < 3; ++axis )
+    {
+        origin [ axis ] = sliceToVoxels( axis, 3 );
+        step   [ axis ] = sliceToVoxels( axis, 0 );
+        rowStep[ axis ] = sliceToVoxels( axis, 1 );
+    }
+}
+
+
+float Reslicer::Details::sample( float x, float y, float z ) const
+{
+    const float maxX = static_cast< float >( size.x() - 1 );
+    const float maxY = static_cast< float >( size.y() - 1 );
+    const float maxZ = static_cast< float >( size.z() - 1 );
+    if( !( x >= 0 && y >= 0 && z >= 0 && x <= maxX && y <= maxY && z <= maxZ ) )
+    {
+        return BACKGROUND_HUV;
+    }
+
+    const unsigned int x0 = std::min( static_cast< unsigned int >( x ), size.x() - 2 );
+    const unsigned int y0 = std::min( static_cast< unsigned int >( y ), size.y() - 2 );
+    const unsigned int z0 = std::min( static_cast< unsigned int >( z ), size.z() - 2 );
+    const float fx = x - x0;
+    const float fy = y - y0;
+    const float fz = z - z0;
+
+    const std::size_t dy = size.x();
+    const std::size_t dz = static_cast< std::size_t >( size.x() ) * size.y();
+    const signed short* const v = &voxels[ z0 * dz + y0 * dy + x0 ];
+    const float c00 = v[          0 ] + fx * ( v[      1 ] - v[      0 ] );
+    const float c10 = v[ dy         ] + fx * ( v[ dy + 1 ] - v[ dy     ] );
+    const float c01 = v[ dz         ] + fx * ( v[ dz + 1 ] - v[ dz     ] );
+    const float c11 = v[ dz + dy    ] + fx * ( v[ dz + dy + 1 ] - v[ dz + dy ] );
+    const float c0  = c00 + fy * ( c10 - c00 );
+    const float c1  = c01 + fy * ( c11 - c01 );
+    return c0 + fz * ( c1 - c0 );
+}
+
+
+void Reslicer::Details::sampleRow( const Sampling& sampling, unsigned int y, unsigned int width, float* huvs ) const
+{
+    const float rowX = sampling.origin[ 0 ] + ( y + 0.5f ) * sampling.rowStep[ 0 ] + 0.5f * sampling.step[ 0 ];
+    const float rowY = sampling.origin[ 1 ] + ( y + 0.5f ) * sampling.rowStep[ 1 ] + 0.5f * sampling.step[ 1 ];
+    const float rowZ = sampling.origin[ 2 ] + ( y + 0.5f ) * sampling.rowStep[ 2 ] + 0.5f * sampling.step[ 2 ];
+    unsigned int x = 0;
+
+#ifdef CARNAQT_RESLICER_SSE2
+
+    /* Process four pixels at once. The corner voxels must be gathered one by one,
+     * but the bounds check and the interpolation are vectorized.
+     */
+    const __m128 lanes = _mm_setr_ps( 0, 1, 2, 3 );
+    const __m128 zero  = _mm_setzero_ps();
+    const __m128 maxX  = _mm_set1_ps( static_cast< float >( size.x() - 1 ) );
+    const __m128 maxY  = _mm_set1_ps( static_cast< float >( size.y() - 1 ) );
+    const __m128 maxZ  = _mm_set1_ps( static_cast< float >( size.z() - 1 ) );
+    const __m128i maxX0 = _mm_set1_epi32( static_cast< int >( size.x() - 2 ) );
+    const __m128i maxY0 = _mm_set1_epi32( static_cast< int >( size.y() - 2 ) );
+    const __m128i maxZ0 = _mm_set1_epi32( static_cast< int >( size.z() - 2 ) );
+    const __m128 background = _mm_set1_ps( BACKGROUND_HUV );
+    const std::size_t dy = size.x();
+    const std::size_t dz = static_cast< std::size_t >( size.x() ) * size.y();
+
+    for( ; x + 4 <= width; x += 4 )
+    {
+        const __m128 pixels = _mm_add_ps( _mm_set1_ps( static_cast< float >( x ) ), lanes );
+        const __m128 vx = _mm_add_ps( _mm_set1_ps( rowX ), _mm_mul_ps( pixels, _mm_set1_ps( sampling.step[ 0 ] ) ) );
+        const __m128 vy = _mm_add_ps( _mm_set1_ps( rowY ), _mm_mul_ps( pixels, _mm_set1_ps( sampling.step[ 1 ] ) ) );
+        const __m128 vz = _mm_add_ps( _mm_set1_ps( rowZ ), _mm_mul_ps( pixels, _mm_set1_ps( sampling.step[ 2 ] ) ) );
+
+        const __m128 inside = _mm_and_ps
+            ( _mm_and_ps
+                ( _mm_and_ps( _mm_cmpge_ps( vx, zero ), _mm_cmple_ps( vx, maxX ) )
+                , _mm_and_ps( _mm_cmpge_ps( vy, zero ), _mm_cmple_ps( vy, maxY ) ) )
+            , _mm_and_ps( _mm_cmpge_ps( vz, zero ), _mm_cmple_ps( vz, maxZ ) ) );
+        if( _mm_movemask_ps( inside ) == 0 )
+        {
+            _mm_storeu_ps( huvs + x, background );
+            continue;
+        }
+
+        /* Clamp the coordinates, s.t. the gathered voxels are valid even for the
+         * samples outside. These are masked out later.
+         */
+        const __m128 cx = _mm_min_ps( _mm_max_ps( vx, zero ), maxX );
+        const __m128 cy = _mm_min_ps( _mm_max_ps( vy, zero ), maxY );
+        const __m128 cz = _mm_min_ps( _mm_max_ps( vz, zero ), maxZ );
+        __m128i ix = _mm_cvttps_epi32( cx );
+        __m128i iy = _mm_cvttps_epi32( cy );
+        __m128i iz = _mm_cvttps_epi32( cz );
+        ix = _mm_sub_epi32( ix, _mm_and_si128( _mm_cmpgt_epi32( ix, maxX0 ), _mm_set1_epi32( 1 ) ) );
+        iy = _mm_sub_epi32( iy, _mm_and_si128( _mm_cmpgt_epi32( iy, maxY0 ), _mm_set1_epi32( 1 ) ) );
+        iz = _mm_sub_epi32( iz, _mm_and_si128( _mm_cmpgt_epi32( iz, maxZ0 ), _mm_set1_epi32( 1 ) ) );
+        const __m128 fx = _mm_sub_ps( cx, _mm_cvtepi32_ps( ix ) );
+        const __m128 fy = _mm_sub_ps( cy, _mm_cvtepi32_ps( iy ) );
+        const __m128 fz = _mm_sub_ps( cz, _mm_cvtepi32_ps( iz ) );
+
+        int ixs[ 4 ], iys[ 4 ], izs[ 4 ];
+        _mm_storeu_si128( reinterpret_cast< __m128i* >( ixs ), ix );
+        _mm_storeu_si128( reinterpret_cast< __m128i* >( iys ), iy );
+        _mm_storeu_si128( reinterpret_cast< __m128i* >( izs ), iz );
+        float corners[ 8 ][ 4 ];
+        for( unsigned int lane = 0; lane < 4; ++lane )
+        {
+            const signed short* const v = &voxels[ izs[ lane ] * dz + iys[ lane ] * dy + ixs[ lane ] ];
+            corners[ 0 ][ lane ] = v[ 0 ];
+            corners[ 1 ][ lane ] = v[ 1 ];
+            corners[ 2 ][ lane ] = v[ dy ];
+            corners[ 3 ][ lane ] = v[ dy + 1 ];
+            corners[ 4 ][ lane ] = v[ dz ];
+            corners[ 5 ][ lane ] = v[ dz + 1 ];
+            corners[ 6 ][ lane ] = v[ dz + dy ];
+            corners[ 7 ][ lane ] = v[ dz + dy + 1 ];
+        }
+
+        const __m128 v000 = _mm_loadu_ps( corners[ 0 ] );
+        const __m128 v100 = _mm_loadu_ps( corners[ 1 ] );
+        const __m128 v010 = _mm_loadu_ps( corners[ 2 ] );
+        const __m128 v110 = _mm_loadu_ps( corners[ 3 ] );
+        const __m128 v001 = _mm_loadu_ps( corners[ 4 ] );
+        const __m128 v101 = _mm_loadu_ps( corners[ 5 ] );
+        const __m128 v011 = _mm_loadu_ps( corners[ 6 ] );
+        const __m128 v111 = _mm_loadu_ps( corners[ 7 ] );
+        const __m128 c00 = _mm_add_ps( v000, _mm_mul_ps( fx, _mm_sub_ps( v100, v000 ) ) );
+        const __m128 c10 = _mm_add_ps( v010, _mm_mul_ps( fx, _mm_sub_ps( v110, v010 ) ) );
+        const __m128 c01 = _mm_add_ps( v001, _mm_mul_ps( fx, _mm_sub_ps( v101, v001 ) ) );
+        const __m128 c11 = _mm_add_ps( v011, _mm_mul_ps( fx, _mm_sub_ps( v111, v011 ) ) );
+        const __m128 c0  = _mm_add_ps( c00, _mm_mul_ps( fy, _mm_sub_ps( c10, c00 ) ) );
+        const __m128 c1  = _mm_add_ps( c01, _mm_mul_ps( fy, _mm_sub_ps( c11, c01 ) ) );
+        const __m128 c   = _mm_add_ps( c0 , _mm_mul_ps( fz, _mm_sub_ps( c1 , c0  ) ) );
+        _mm_storeu_ps( huvs + x, _mm_or_ps( _mm_and_ps( inside, c ), _mm_andnot_ps( inside, background ) ) );
+    }
+
+#endif
+
+    for( ; x < width; ++x )
+    {
+        huvs[ x ] = sample
+            ( rowX + x * sampling.step[ 0 ]
+            , rowY + x * sampling.step[ 1 ]
+            , rowZ + x * sampling.step[ 2 ] );
+    }
+}
+
+
+template< typename RowWriter >
+void Reslicer::Details::compute( const base::math::Matrix4f& sliceTransform, unsigned int width, unsigned int height, const RowWriter& writeRow )
+{
+    const Sampling sampling( sliceTransform, size );
+
+    /* Each thread computes a band of rows. There are more bands than threads, s.t.
+     * the load is balanced if the slice crosses the volume only partially.
+     */
+    struct Band : public QRunnable
+    {
+        Band( const Details& details, const Sampling& sampling, unsigned int width, unsigned int firstRow, unsigned int lastRow, const RowWriter& writeRow )
+            : details( details ), sampling( sampling ), width( width ), firstRow( firstRow ), lastRow( lastRow ), writeRow( writeRow )
+        {
+        }
+
+        const Details& details;
+        const Sampling& sampling;
+        const unsigned int width;
+        const unsigned int firstRow;
+        const unsigned int lastRow;
+        const RowWriter& writeRow;
+
+        virtual void run() override
+        {
+            std::vector< float > huvs( width );
+            for( unsigned int y = firstRow; y < lastRow; ++y )
+            {
+                details.sampleRow( sampling, y, width, huvs.data() );
+                writeRow( y, huvs.data() );
+            }
+        }
+    };
+
+    const unsigned int bands = std::min( height, static_cast< unsigned int >( threadPool.maxThreadCount() ) * 4 );
+    for( unsigned int band = 0; band < bands; ++band )
+    {
+        const unsigned int firstRow = static_cast< unsigned int >( static_cast< std::size_t >( height ) *  band       / bands );
+        const unsigned int  lastRow = static_cast< unsigned int >( static_cast< std::size_t >( height ) * ( band + 1 ) / bands );
+        threadPool.start( new Band( *this, sampling, width, firstRow, lastRow, writeRow ) );
+    }
+    threadPool.waitForDone();
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// Reslicer
+// ----------------------------------------------------------------------------------
+
+const signed short Reslicer::BACKGROUND_HUV = -1024;
+
+
+Reslicer::Reslicer( const base::HUVolume& volume )
+    : pimpl( new Details( volume ) )
+{
+    pimpl->threadPool.setMaxThreadCount( std::max( 1, QThread::idealThreadCount() ) );
+}
+
+
+Reslicer::~Reslicer()
+{
+}
+
+
+const base::math::Vector3ui& Reslicer::size() const
+{
+    return pimpl->size;
+}
+
+
+void Reslicer::setThreads( unsigned int threads )
+{
+    CARNA_ASSERT( threads > 0 );
+    pimpl->threadPool.setMaxThreadCount( static_cast< int >( threads ) );
+}
+
+
+unsigned int Reslicer::threads() const
+{
+    return static_cast< unsigned int >( pimpl->threadPool.maxThreadCount() );
+}
+
+
+base::math::Matrix4f Reslicer::computeSliceTransform
+    ( const base::math::Matrix4f& volumeWorldTransform
+    , const base::math::Matrix4f& planeWorldTransform
+    , unsigned int width
+    , unsigned int height
+    , float pixelSize )
+{
+    /* Map the pixel coordinates to the plane's x/y-plane, where the rows are
+     * ordered top-down and the image is centered in the origin.
+     */
+    base::math::Matrix4f pixelsToPlane = base::math::identity4f();
+    pixelsToPlane( 0, 0 ) = +pixelSize;
+    pixelsToPlane( 1, 1 ) = -pixelSize;
+    pixelsToPlane( 0, 3 ) = -pixelSize * width  / 2.f;
+    pixelsToPlane( 1, 3 ) = +pixelSize * height / 2.f;
+    return volumeWorldTransform.inverse() * planeWorldTransform * pixelsToPlane;
+}
+
+
+void Reslicer::sample( const base::math::Vector3f* positions, std::size_t count, float* huvs ) const
+{
+    const Details& details = *pimpl;
+    struct Chunk : public QRunnable
+    {
+        Chunk( const Details& details, const base::math::Vector3f* positions, std::size_t count, float* huvs )
+            : details( details ), positions( positions ), count( count ), huvs( huvs )
+        {
+        }
+
+        const Details& details;
+        const base::math::Vector3f* const positions;
+        const std::size_t count;
+        float* const huvs;
+
+        virtual void run() override
+        {
+            const float scaleX = static_cast< float >( details.size.x() - 1 );
+            const float scaleY = static_cast< float >( details.size.y() - 1 );
+            const float scaleZ = static_cast< float >( details.size.z() - 1 );
+            for( std::size_t idx = 0; idx < count; ++idx )
+            {
+                const base::math::Vector3f& p = positions[ idx ];
+                huvs[ idx ] = details.sample( ( p.x() + 0.5f ) * scaleX, ( p.y() + 0.5f ) * scaleY, ( p.z() + 0.5f ) * scaleZ );
+            }
+        }
+    };
+
+    const std::size_t chunks = std::min< std::size_t >( ( count + 1023 ) / 1024, pimpl->threadPool.maxThreadCount() * 4 );
+    for( std::size_t chunk = 0; chunk < chunks; ++chunk )
+    {
+        const std::size_t first = count *  chunk       / chunks;
+        const std::size_t  last = count * ( chunk + 1 ) / chunks;
+        pimpl->threadPool.start( new Chunk( details, positions + first, last - first, huvs + first ) );
+    }
+    pimpl->threadPool.waitForDone();
+}
+
+
+void Reslicer::reslice( const base::math::Matrix4f& sliceTransform, unsigned int width, unsigned int height, signed short* huvs ) const
+{
+    const auto writeRow = [huvs, width]( unsigned int y, const float* row )
+    {
+        signed short* const out = huvs + static_cast< std::size_t >( y ) * width;
+        for( unsigned int x = 0; x < width; ++x )
+        {
+            out[ x ] = static_cast< signed short >( std::floor( row[ x ] + 0.5f ) );
+        }
+    };
+    pimpl->compute( sliceTransform, width, height, writeRow );
+}
+
+
+void Reslicer::reslice
+    ( const base::math::Matrix4f& sliceTransform
+    , unsigned int width
+    , unsigned int height
+    , base::HUV windowingLevel
+    , unsigned int windowingWidth
+    , unsigned char* intensities ) const
+{
+    const float minimumHUV = windowingLevel - windowingWidth / 2.f;
+    const float scale = 255.f / std::max( 1u, windowingWidth );
+    const auto writeRow = [intensities, width, minimumHUV, scale]( unsigned int y, const float* row )
+    {
+        unsigned char* const out = intensities + static_cast< std::size_t >( y ) * width;
+        for( unsigned int x = 0; x < width; ++x )
+        {
+            const float intensity = ( row[ x ] - minimumHUV ) * scale;
+            out[ x ] = static_cast< unsigned char >( std::min( 255.f, std::max( 0.f, intensity ) ) + 0.5f );
+        }
+    };
+    pimpl->compute( sliceTransform, width, height, writeRow );
+}
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
@@ -0,0 +1,181 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#include <Carna/qt/ShaderCache.h>
+#include <QDataStream>
+#include <QFile>
+#include <QDir>
+#if QT_VERSION >= 0x050000
+#include <QStandardPaths>
+#else
+#include <QDesktopServices>
+#endif
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// ShaderCache :: Details
+// ----------------------------------------------------------------------------------
+
+struct ShaderCache::Details
+{
+    Details();
+
+    const static quint32 MAGIC   = 0x43515343; // "CQSC"
+    const static quint32 VERSION = 1;
+
+    QString directory;
+    std::size_t hits;
+    std::size_t misses;
+
+    static Details& instance();
+    QString fileName( const QString& key ) const;
+};
+
+
+ShaderCache::Details::Details()
+    : hits( 0 )
+    , misses( 0 )
+{
+#if QT_VERSION >= 0x050000
+    const QString cacheLocation = QStandardPaths::writableLocation( QStandardPaths::CacheLocation );
+#else
+    const QString cacheLocation = QDesktopServices::storageLocation( QDesktopServices::CacheLocation );
+#endif
+    if( !cacheLocation.isEmpty() )
+    {
+        directory = cacheLocation + "/shaders";
+    }
+}
+
+
+ShaderCache::Details& ShaderCache::Details::instance()
+{
+    static Details details;
+    return details;
+}
+
+
+QString ShaderCache::Details::fileName( const QString& key ) const
+{
+    return directory + "/" + key + ".bin";
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// ShaderCache
+// ----------------------------------------------------------------------------------
+
+bool ShaderCache::load( const QString& key, unsigned int& format, QByteArray& binary )
+{
+    const Details& details = Details::instance();
+    if( details.directory.isEmpty() )
+    {
+        return false;
+    }
+
+    QFile file( details.fileName( key ) );
+    if( !file.open( QIODevice::ReadOnly ) )
+    {
+        return false;
+    }
+
+    QDataStream in( &file );
+    in.setVersion( QDataStream::Qt_4_6 );
+    quint32 magic, version, binaryFormat;
+    in >> magic >> version >> binaryFormat >> binary;
+    if( in.status() != QDataStream::Ok || magic != Details::MAGIC || version != Details::VERSION || binary.isEmpty() )
+    {
+        return false;
+    }
+    format = binaryFormat;
+    return true;
+}
+
+
+void ShaderCache::store( const QString& key, unsigned int format, const QByteArray& binary )
+{
+    const Details& details = Details::instance();
+    if( details.directory.isEmpty() || !QDir().mkpath( details.directory ) )
+    {
+        return;
+    }
+
+    /* A file, that is written only partially, is rejected when it is loaded.
+     */
+    QFile file( details.fileName( key ) );
+    if( file.open( QIODevice::WriteOnly ) )
+    {
+        QDataStream out( &file );
+        out.setVersion( QDataStream::Qt_4_6 );
+        out << Details::MAGIC << Details::VERSION << static_cast< quint32 >( format ) << binary;
+    }
+}
+
+
+void ShaderCache::recordLink( bool fromCache )
+{
+    Details& details = Details::instance();
+    ++( fromCache ? details.hits : details.misses );
+}
+
+
+void ShaderCache::setDirectory( const QString& directory )
+{
+    Details::instance().directory = directory;
+}
+
+
+const QString& ShaderCache::directory()
+{
+    return Details::instance().directory;
+}
+
+
+void ShaderCache::clear()
+{
+    const QString& directory = Details::instance().directory;
+    if( directory.isEmpty() )
+    {
+        return;
+    }
+    QDir dir( directory );
+    const QStringList files = dir.entryList( QStringList() << "*.bin", QDir::Files );
+    for( auto fileItr = files.begin(); fileItr != files.end(); ++fileItr )
+    {
+        dir.remove( *fileItr );
+    }
+}
+
+
+std::size_t ShaderCache::hits()
+{
+    return Details::instance().hits;
+}
+
+
+std::size_t ShaderCache::misses()
+{
+    return Details::instance().misses;
+}
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
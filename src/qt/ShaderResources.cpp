@@ -0,0 +1,243 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#include <Carna/base/glew.h>
+#include <Carna/qt/ShaderResources.h>
+#include <Carna/qt/ShaderCache.h>
+#include <Carna/base/ShaderManager.h>
+#include <Carna/base/ShaderProgram.h>
+#include <Carna/base/CarnaException.h>
+#include <Carna/base/Log.h>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <map>
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// ShaderResources
+// ----------------------------------------------------------------------------------
+
+std::string ShaderResources::read( const std::string& name )
+{
+    QFile srcFile( QString::fromStdString( name ) );
+    const bool ok = srcFile.open( QFile::ReadOnly | QFile::Text );
+    CARNA_ASSERT_EX( ok, "Failed to open resource file: \"" << name + "\"" );
+    QTextStream in( &srcFile );
+    const QString text = in.readAll();
+    srcFile.close();
+    return text.toStdString();
+}
+
+
+std::vector< std::string > ShaderResources::names()
+{
+    const QStringList vertNames = QDir( ":/shaders" ).entryList( QStringList( "*.vert" ), QDir::Files, QDir::Name );
+    std::vector< std::string > shaderNames;
+    shaderNames.reserve( vertNames.size() );
+    for( auto vertNameItr = vertNames.begin(); vertNameItr != vertNames.end(); ++vertNameItr )
+    {
+        shaderNames.push_back( QFileInfo( *vertNameItr ).completeBaseName().toStdString() );
+    }
+    return shaderNames;
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// ShaderResourcesProgram
+// ----------------------------------------------------------------------------------
+
+/* The programs are created by the 'ShaderManager' when they are acquired for the
+ * first time, hence the acquisitions are counted to tell when they are linked.
+ */
+struct ShaderResourcesProgram
+{
+    ShaderResourcesProgram();
+    unsigned int acquisitions;
+    const base::ShaderProgram* shader;
+};
+
+
+ShaderResourcesProgram::ShaderResourcesProgram()
+    : acquisitions( 0 )
+    , shader( nullptr )
+{
+}
+
+
+static std::map< std::string, ShaderResourcesProgram >& shaderResourcesPrograms()
+{
+    static std::map< std::string, ShaderResourcesProgram > programs;
+    return programs;
+}
+
+
+/* The stub shaders are compiled instead of the actual ones, when the program is
+ * linked from its binary.
+ */
+static const char* const SHADER_RESOURCES_STUB_VERTEX_SHADER =
+    "#version 330\n"
+    "void main() { gl_Position = vec4( 0 ); }\n";
+
+static const char* const SHADER_RESOURCES_STUB_FRAGMENT_SHADER =
+    "#version 330\n"
+    "out vec4 gl_FragColor;\n"
+    "void main() { gl_FragColor = vec4( 0 ); }\n";
+
+
+static bool isProgramBinarySupported()
+{
+    GLint formats = 0;
+    if( GLEW_ARB_get_program_binary )
+    {
+        glGetIntegerv( GL_NUM_PROGRAM_BINARY_FORMATS, &formats );
+    }
+    return formats > 0;
+}
+
+
+static QString shaderCacheKey( const std::string& shaderName, const std::string& vertSrc, const std::string& fragSrc )
+{
+    QCryptographicHash hash( QCryptographicHash::Sha1 );
+    hash.addData( vertSrc.c_str(), static_cast< int >( vertSrc.size() ) );
+    hash.addData( fragSrc.c_str(), static_cast< int >( fragSrc.size() ) );
+    const GLenum driverStrings[ 3 ] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+    for( int stringIdx = 0; stringIdx < 3; ++stringIdx )
+    {
+        hash.addData( reinterpret_cast< const char* >( glGetString( driverStrings[ stringIdx ] ) ) );
+    }
+    return QString::fromStdString( shaderName ) + "-" + QString( hash.result().toHex() );
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// ShaderResources
+// ----------------------------------------------------------------------------------
+
+const base::ShaderProgram& ShaderResources::acquire( const std::string& shaderName )
+{
+    base::ShaderManager& shaderManager = base::ShaderManager::instance();
+    ShaderResourcesProgram& program = shaderResourcesPrograms()[ shaderName ];
+    if( program.acquisitions++ > 0 )
+    {
+        return shaderManager.acquireShader( shaderName );
+    }
+
+    const std::string vertName = shaderName + ".vert";
+    const std::string fragName = shaderName + ".frag";
+    const std::string vertSrc = read( ":/shaders/" + vertName );
+    const std::string fragSrc = read( ":/shaders/" + fragName );
+    const bool isCacheSupported = isProgramBinarySupported();
+    const QString key = isCacheSupported ? shaderCacheKey( shaderName, vertSrc, fragSrc ) : QString();
+
+    /* Link the program from the stored binary. The binary replaces the program,
+     * that is linked from the stub shaders.
+     */
+    unsigned int format;
+    QByteArray binary;
+    if( isCacheSupported && ShaderCache::load( key, format, binary ) )
+    {
+        shaderManager.setSource( vertName, SHADER_RESOURCES_STUB_VERTEX_SHADER );
+        shaderManager.setSource( fragName, SHADER_RESOURCES_STUB_FRAGMENT_SHADER );
+        const base::ShaderProgram& shader = shaderManager.acquireShader( shaderName );
+        glProgramBinary( shader.id, format, binary.constData(), binary.size() );
+        GLint linkStatus;
+        glGetProgramiv( shader.id, GL_LINK_STATUS, &linkStatus );
+        if( linkStatus == GL_TRUE )
+        {
+            ShaderCache::recordLink( true );
+            program.shader = &shader;
+            return shader;
+        }
+
+        /* The binary was rejected, e.g. because the driver was updated, hence the
+         * program is deleted and created again from the sources.
+         */
+        shaderManager.releaseShader( shader );
+    }
+
+    shaderManager.setSource( vertName, vertSrc );
+    shaderManager.setSource( fragName, fragSrc );
+    const base::ShaderProgram& shader = shaderManager.acquireShader( shaderName );
+    ShaderCache::recordLink( false );
+    program.shader = &shader;
+
+    /* Store the binary of the program. Some drivers provide it only if they were
+     * told so before linking. The program is linked by the shader manager, hence
+     * it must be linked once more then. If this fails, the program is created
+     * again from the sources and its binary is not stored.
+     */
+    if( isCacheSupported )
+    {
+        GLint length = 0;
+        glGetProgramiv( shader.id, GL_PROGRAM_BINARY_LENGTH, &length );
+        if( length == 0 )
+        {
+            glProgramParameteri( shader.id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE );
+            glLinkProgram( shader.id );
+            GLint linkStatus;
+            glGetProgramiv( shader.id, GL_LINK_STATUS, &linkStatus );
+            if( linkStatus != GL_TRUE )
+            {
+                base::Log::instance().record( base::Log::warning, "Relinking shader '" + shaderName + "' to retrieve its binary failed." );
+                shaderManager.releaseShader( shader );
+                const base::ShaderProgram& sourceShader = shaderManager.acquireShader( shaderName );
+                program.shader = &sourceShader;
+                return sourceShader;
+            }
+            glGetProgramiv( shader.id, GL_PROGRAM_BINARY_LENGTH, &length );
+        }
+        if( length > 0 )
+        {
+            GLenum binaryFormat;
+            binary.resize( length );
+            glGetProgramBinary( shader.id, length, nullptr, &binaryFormat, binary.data() );
+            ShaderCache::store( key, binaryFormat, binary );
+        }
+    }
+    return shader;
+}
+
+
+void ShaderResources::release( const base::ShaderProgram& shader )
+{
+    std::map< std::string, ShaderResourcesProgram >& programs = shaderResourcesPrograms();
+    for( auto programItr = programs.begin(); programItr != programs.end(); ++programItr )
+    {
+        ShaderResourcesProgram& program = programItr->second;
+        if( program.shader == &shader && program.acquisitions > 0 )
+        {
+            if( --program.acquisitions == 0 )
+            {
+                program.shader = nullptr;
+            }
+            break;
+        }
+    }
+    base::ShaderManager::instance().releaseShader( shader );
+}
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
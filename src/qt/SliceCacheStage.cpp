@@ -0,0 +1,1201 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#include <Carna/base/glew.h>
+#include <Carna/qt/SliceCacheStage.h>
+#include <Carna/qt/ShaderResources.h>
+#include <Carna/qt/MPRStage.h>
+#include <Carna/qt/MPRDataFeature.h>
+#include <Carna/presets/CuttingPlanesStage.h>
+#include <Carna/base/Mesh.h>
+#include <Carna/base/Vertex.h>
+#include <Carna/base/Viewport.h>
+#include <Carna/base/ShaderProgram.h>
+#include <Carna/base/Composition.h>
+#include <Carna/base/VertexBuffer.h>
+#include <Carna/base/IndexBuffer.h>
+#include <Carna/base/RenderState.h>
+#include <Carna/base/RenderTask.h>
+#include <Carna/base/FrameRenderer.h>
+#include <Carna/base/GLContext.h>
+#include <Carna/base/Geometry.h>
+#include <Carna/base/Texture.h>
+#include <Carna/base/Texture3D.h>
+#include <Carna/base/ManagedTexture3D.h>
+#include <Carna/base/Node.h>
+#include <QObject>
+#include <QBasicTimer>
+#include <QTimerEvent>
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include <map>
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// SliceCacheStage :: Details
+// ----------------------------------------------------------------------------------
+
+struct SliceCacheStage::Details
+{
+    Details( unsigned int geometryTypeVolume, unsigned int geometryTypePlanes );
+    ~Details();
+
+    /* The internal stage maps the HUV range linearly to [0.5, 1), s.t. zero
+     * denotes that no plane was rendered to a pixel.
+     */
+    const static base::HUV ENCODING_LEVEL = -1024;
+    const static unsigned int ENCODING_WIDTH = 8192;
+
+    const std::unique_ptr< presets::CuttingPlanesStage > planes;
+    base::HUV windowingLevel;
+    unsigned int windowingWidth;
+
+    float slabThickness;
+    MPRDisplay::SlabMode slabMode;
+    float slabStep;
+    float interactiveSlabStep;
+    bool isInteractive;
+
+    /* The planes are displaced temporarily to sample the slab. Their original
+     * local transforms are kept in 'planeTransforms'.
+     */
+    base::Node* root;
+    std::vector< base::Geometry* > planeGeometries;
+    std::vector< float > planeTransforms;
+    void displacePlanes( float distance );
+    void restorePlanes();
+    void sample( const base::math::Matrix4f& vt, base::RenderTask& rt, const base::Viewport& vp );
+
+    /* If the scene contains multiple volumes, they are sampled by a dedicated
+     * pass, that writes the HUV of each volume to a distinct channel, instead of
+     * the internal stage. The channels are blended by the windowing pass. Each
+     * pass samples up to 'MAX_FUSED_SEGMENTS' segments. If there are more, the
+     * batches of segments are sampled by multiple passes, that are combined by
+     * blending.
+     */
+    const static unsigned int MAX_FUSED_SEGMENTS = 8;
+    std::vector< MPRDisplay::FusedVolume > fusedVolumes;
+    struct FusedSegment
+    {
+        const base::Geometry* geometry;
+        int channel;
+    };
+    std::vector< FusedSegment > fusedSegments;
+    float background;
+    bool isFused() const;
+    int channelOf( const base::Spatial& geometry ) const;
+    void renderPlanes( const base::math::Matrix4f& vt, base::RenderTask& rt, const base::Viewport& vp );
+    void renderFusedPlanes( const base::math::Matrix4f& vt, base::RenderTask& rt, const base::Viewport& vp );
+    void renderFusedBatch( std::size_t firstSegment, std::size_t segments );
+
+    struct VideoResources;
+    std::unique_ptr< VideoResources > vr;
+    unsigned int width;
+    unsigned int height;
+
+    /* Each entry of the cache holds a sampled slice and the key of the frame it
+     * was sampled for. The entries are reused in the order they were filled, i.e.
+     * they form a ring. The containers are reused, s.t. computing the key does not
+     * allocate memory per frame. Besides the geometries, the key contains the
+     * textures of the volume geometries, s.t. replacing a texture, e.g. when it
+     * is streamed, causes the volume to be sampled again.
+     */
+    struct Entry;
+    std::vector< std::unique_ptr< Entry > > entries;
+    std::size_t nextEntry;
+    std::size_t samplings;
+    std::vector< float > key;
+    std::vector< const base::Geometry* > geometries;
+    std::vector< const base::GeometryFeature* > textures;
+    std::size_t sceneKeySize;
+    void appendKey( const base::math::Matrix4f& m );
+    void completeKey( const base::math::Matrix4f& vt, const base::math::Matrix4f& projection, const base::Viewport& vp );
+    void resizeEntries( std::size_t count, GLenum internalFormat );
+    Entry* findEntry() const;
+    Entry& acquireEntry( const Entry* keep );
+    void sampleInto( Entry& entry, const base::math::Matrix4f& vt, base::RenderTask& rt, const base::Viewport& vp );
+
+    /* The slices ahead of the prefetched plane are sampled speculatively after
+     * each frame. The key of such a slice differs from the frame's key only by
+     * the world transform of the plane, that is located at 'prefetchKeyOffset'.
+     * The frame is presented first: It only requests the prefetch, that is done
+     * by a zero-interval timer once the event loop is reached. The view, the
+     * projection and the viewport of the frame are kept for this purpose.
+     */
+    base::Geometry* prefetchPlane;
+    float prefetchStep;
+    unsigned int prefetchCount;
+    std::size_t prefetchKeyOffset;
+    std::size_t prefetches;
+    struct PrefetchTimer;
+    std::unique_ptr< PrefetchTimer > prefetchTimer;
+    const base::FrameRenderer* prefetchRenderer;
+    const std::unique_ptr< base::math::Matrix4f > prefetchView;
+    const std::unique_ptr< base::math::Matrix4f > prefetchProjection;
+    unsigned int prefetchViewport[ 4 ];
+    void requestPrefetch( const base::math::Matrix4f& vt, base::RenderTask& rt, const base::Viewport& vp );
+    void cancelPrefetch();
+    void prefetch( SliceCacheStage& self );
+    void prefetch( const Entry* presented, const base::math::Matrix4f& vt, base::RenderTask& rt, const base::Viewport& vp );
+};
+
+
+SliceCacheStage::Details::Details( unsigned int geometryTypeVolume, unsigned int geometryTypePlanes )
+    : planes( new presets::CuttingPlanesStage( geometryTypeVolume, geometryTypePlanes ) )
+    , windowingLevel( planes->windowingLevel() )
+    , windowingWidth( planes->windowingWidth() )
+    , slabThickness( 0 )
+    , slabMode( MPRDisplay::maximumIntensityProjection )
+    , slabStep( MPRDisplay::DEFAULT_SLAB_STEP )
+    , interactiveSlabStep( MPRDisplay::DEFAULT_INTERACTIVE_SLAB_STEP )
+    , isInteractive( false )
+    , root( nullptr )
+    , background( 0 )
+    , width( 0 )
+    , height( 0 )
+    , nextEntry( 0 )
+    , samplings( 0 )
+    , sceneKeySize( 0 )
+    , prefetchPlane( nullptr )
+    , prefetchStep( 0 )
+    , prefetchCount( 0 )
+    , prefetchKeyOffset( 0 )
+    , prefetches( 0 )
+    , prefetchRenderer( nullptr )
+    , prefetchView( new base::math::Matrix4f() )
+    , prefetchProjection( new base::math::Matrix4f() )
+{
+    planes->setWindowingLevel( ENCODING_LEVEL );
+    planes->setWindowingWidth( ENCODING_WIDTH );
+}
+
+
+SliceCacheStage::Details::~Details()
+{
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// SliceCacheStage :: Details :: PrefetchTimer
+// ----------------------------------------------------------------------------------
+
+struct SliceCacheStage::Details::PrefetchTimer : public QObject
+{
+    explicit PrefetchTimer( SliceCacheStage& stage );
+    SliceCacheStage& stage;
+    QBasicTimer timer;
+    virtual void timerEvent( QTimerEvent* ev ) override;
+};
+
+
+SliceCacheStage::Details::PrefetchTimer::PrefetchTimer( SliceCacheStage& stage )
+    : stage( stage )
+{
+}
+
+
+void SliceCacheStage::Details::PrefetchTimer::timerEvent( QTimerEvent* ev )
+{
+    if( ev->timerId() == timer.timerId() )
+    {
+        timer.stop();
+        stage.pimpl->prefetch( stage );
+    }
+    else
+    {
+        QObject::timerEvent( ev );
+    }
+}
+
+
+void SliceCacheStage::Details::appendKey( const base::math::Matrix4f& m )
+{
+    key.insert( key.end(), m.data(), m.data() + 16 );
+}
+
+
+void SliceCacheStage::Details::displacePlanes( float distance )
+{
+    for( std::size_t planeIdx = 0; planeIdx < planeGeometries.size(); ++planeIdx )
+    {
+        base::Geometry& plane = *planeGeometries[ planeIdx ];
+        base::math::Matrix4f& localTransform = plane.localTransform;
+        std::copy( &planeTransforms[ planeIdx * 16 ], &planeTransforms[ planeIdx * 16 ] + 16, localTransform.data() );
+
+        /* The distance is given in world space, whereas the normal might be scaled
+         * by the parent nodes.
+         */
+        const float normalLength = plane.worldTransform().col( 2 ).head< 3 >().norm();
+        localTransform = localTransform * base::math::translation4f( 0, 0, distance / normalLength );
+        plane.updateWorldTransform();
+    }
+}
+
+
+void SliceCacheStage::Details::restorePlanes()
+{
+    for( std::size_t planeIdx = 0; planeIdx < planeGeometries.size(); ++planeIdx )
+    {
+        base::Geometry& plane = *planeGeometries[ planeIdx ];
+        std::copy( &planeTransforms[ planeIdx * 16 ], &planeTransforms[ planeIdx * 16 ] + 16, plane.localTransform.data() );
+        plane.updateWorldTransform();
+    }
+}
+
+
+void SliceCacheStage::Details::sample( const base::math::Matrix4f& vt, base::RenderTask& rt, const base::Viewport& vp )
+{
+    base::GLContext& glc = rt.renderer.glContext();
+    base::RenderState rs;
+    rs.setDepthWrite( true );
+
+    /* The batches of fused segments are rendered at the same depths.
+     */
+    rs.setDepthTestFunction( GL_LEQUAL );
+
+    const float step = isInteractive ? interactiveSlabStep : slabStep;
+    const unsigned int halfSamples = slabThickness > 0 ? static_cast< unsigned int >( slabThickness / 2 / step ) : 0;
+    if( halfSamples == 0 )
+    {
+        background = 0;
+        glClearColor( 0, 0, 0, 0 );
+        glc.clearBuffers( base::GLContext::COLOR_BUFFER_BIT | base::GLContext::DEPTH_BUFFER_BIT );
+
+        /* The channels, that a batch of fused segments does not sample, are set
+         * to the background, that is neutral w.r.t. the maximum.
+         */
+        if( isFused() && fusedSegments.size() > MAX_FUSED_SEGMENTS )
+        {
+            rs.setBlend( true );
+            rs.setBlendEquation( GL_MAX );
+        }
+        vp.makeActive();
+        renderPlanes( vt, rt, vp );
+        vp.done();
+        return;
+    }
+
+    /* Project the samples by blending. The buffer is cleared to a value above the
+     * encoded HUV range for the minimum, s.t. the pixels that no plane is rendered
+     * to can still be told apart.
+     */
+    const unsigned int samples = 2 * halfSamples + 1;
+    rs.setBlend( true );
+    switch( slabMode )
+    {
+
+    case MPRDisplay::maximumIntensityProjection:
+        background = 0;
+        glClearColor( 0, 0, 0, 0 );
+        rs.setBlendEquation( GL_MAX );
+        break;
+
+    case MPRDisplay::minimumIntensityProjection:
+        background = 2;
+        glClearColor( 2, 2, 2, 2 );
+        rs.setBlendEquation( GL_MIN );
+        break;
+
+    case MPRDisplay::averageIntensityProjection:
+        background = 0;
+        glClearColor( 0, 0, 0, 0 );
+        rs.setBlendEquation( GL_FUNC_ADD );
+        rs.setBlendFunction( base::BlendFunction( GL_CONSTANT_ALPHA, GL_ONE ) );
+        glBlendColor( 0, 0, 0, 1.f / samples );
+        break;
+
+    default:
+        CARNA_FAIL( "Unknown slab mode." );
+
+    }
+    glc.clearBuffers( base::GLContext::COLOR_BUFFER_BIT );
+
+    planeTransforms.clear();
+    for( std::size_t planeIdx = 0; planeIdx < planeGeometries.size(); ++planeIdx )
+    {
+        const base::math::Matrix4f& localTransform = planeGeometries[ planeIdx ]->localTransform;
+        planeTransforms.insert( planeTransforms.end(), localTransform.data(), localTransform.data() + 16 );
+    }
+
+    vp.makeActive();
+    for( unsigned int sampleIdx = 0; sampleIdx < samples; ++sampleIdx )
+    {
+        /* The central sample is rendered last, s.t. the depth buffer holds its
+         * depth eventually.
+         */
+        const int offset
+            = sampleIdx < halfSamples     ? static_cast< int >( sampleIdx ) - static_cast< int >( halfSamples )
+            : sampleIdx < 2 * halfSamples ? static_cast< int >( sampleIdx ) - static_cast< int >( halfSamples ) + 1
+            : 0;
+        displacePlanes( offset * step );
+        planes->prepareFrame( *root );
+        glc.clearBuffers( base::GLContext::DEPTH_BUFFER_BIT );
+        renderPlanes( vt, rt, vp );
+    }
+    vp.done();
+    restorePlanes();
+}
+
+
+
+bool SliceCacheStage::Details::isFused() const
+{
+    return fusedVolumes.size() > 1;
+}
+
+
+int SliceCacheStage::Details::channelOf( const base::Spatial& geometry ) const
+{
+    for( const base::Spatial* spatial = &geometry; ; spatial = &spatial->parent() )
+    {
+        for( std::size_t volumeIdx = 0; volumeIdx < fusedVolumes.size(); ++volumeIdx )
+        {
+            if( fusedVolumes[ volumeIdx ].volume == spatial )
+            {
+                return static_cast< int >( volumeIdx );
+            }
+        }
+        if( !spatial->hasParent() )
+        {
+            return -1;
+        }
+    }
+}
+
+
+void SliceCacheStage::Details::renderPlanes( const base::math::Matrix4f& vt, base::RenderTask& rt, const base::Viewport& vp )
+{
+    if( isFused() )
+    {
+        renderFusedPlanes( vt, rt, vp );
+    }
+    else
+    {
+        planes->renderPass( vt, rt, vp );
+    }
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// SliceCacheStage :: Details :: VideoResources
+// ----------------------------------------------------------------------------------
+
+struct SliceCacheStage::Details::VideoResources
+{
+    VideoResources();
+    ~VideoResources();
+
+    typedef base::Mesh< base::VertexBase, uint8_t > QuadMesh;
+    const std::unique_ptr< QuadMesh > quadMesh;
+    static QuadMesh* createQuadMesh();
+    const base::ShaderProgram& shader;
+
+    const GLint huvsLocation;
+    const GLint depthsLocation;
+    const GLint encodingMinimumLocation;
+    const GLint encodingWidthLocation;
+    const GLint minimumHUVLocation;
+    const GLint windowingWidthLocation;
+
+    const base::ShaderProgram& planesShader;
+    const GLint segmentTexturesLocation;
+    const GLint worldTextureLocation;
+    const GLint segmentChannelsLocation;
+    const GLint segmentsLocation;
+    const GLint clipWorldLocation;
+    const GLint worldClipLocation;
+    const GLint viewportLocation;
+    const GLint planeLocation;
+    const GLint planesEncodingMinimumLocation;
+    const GLint planesEncodingWidthLocation;
+    const GLint backgroundLocation;
+
+    const base::ShaderProgram& fusionShader;
+    const GLint fusionHUVsLocation;
+    const GLint fusionDepthsLocation;
+    const GLint fusionEncodingMinimumLocation;
+    const GLint fusionEncodingWidthLocation;
+    const GLint minimumHUVsLocation;
+    const GLint windowingWidthsLocation;
+    const GLint weightsLocation;
+
+    /* The textures of the volume segments are kept acquired, as long as the
+     * segments are part of the scene.
+     */
+    GLuint sampler;
+    std::map< const base::ManagedTexture3D*, std::unique_ptr< base::ManagedTexture3D::ManagedInterface > > textures;
+    std::vector< float > worldTextures;
+    std::vector< GLint > segmentChannels;
+    std::vector< GLint > segmentUnits;
+    const base::Texture< 3 >& acquireTexture( const base::ManagedTexture3D& texture );
+    void releaseTextures( const std::vector< FusedSegment >& segments );
+};
+
+
+SliceCacheStage::Details::VideoResources::VideoResources()
+    : quadMesh( createQuadMesh() )
+    , shader( ShaderResources::acquire( "slicecache" ) )
+    , huvsLocation( glGetUniformLocation( shader.id, "huvs" ) )
+    , depthsLocation( glGetUniformLocation( shader.id, "depths" ) )
+    , encodingMinimumLocation( glGetUniformLocation( shader.id, "encodingMinimum" ) )
+    , encodingWidthLocation( glGetUniformLocation( shader.id, "encodingWidth" ) )
+    , minimumHUVLocation( glGetUniformLocation( shader.id, "minimumHUV" ) )
+    , windowingWidthLocation( glGetUniformLocation( shader.id, "windowingWidth" ) )
+    , planesShader( ShaderResources::acquire( "sliceplanes" ) )
+    , segmentTexturesLocation( glGetUniformLocation( planesShader.id, "segmentTextures" ) )
+    , worldTextureLocation( glGetUniformLocation( planesShader.id, "worldTexture" ) )
+    , segmentChannelsLocation( glGetUniformLocation( planesShader.id, "segmentChannels" ) )
+    , segmentsLocation( glGetUniformLocation( planesShader.id, "segments" ) )
+    , clipWorldLocation( glGetUniformLocation( planesShader.id, "clipWorld" ) )
+    , worldClipLocation( glGetUniformLocation( planesShader.id, "worldClip" ) )
+    , viewportLocation( glGetUniformLocation( planesShader.id, "viewport" ) )
+    , planeLocation( glGetUniformLocation( planesShader.id, "plane" ) )
+    , planesEncodingMinimumLocation( glGetUniformLocation( planesShader.id, "encodingMinimum" ) )
+    , planesEncodingWidthLocation( glGetUniformLocation( planesShader.id, "encodingWidth" ) )
+    , backgroundLocation( glGetUniformLocation( planesShader.id, "background" ) )
+    , fusionShader( ShaderResources::acquire( "slicefusion" ) )
+    , fusionHUVsLocation( glGetUniformLocation( fusionShader.id, "huvs" ) )
+    , fusionDepthsLocation( glGetUniformLocation( fusionShader.id, "depths" ) )
+    , fusionEncodingMinimumLocation( glGetUniformLocation( fusionShader.id, "encodingMinimum" ) )
+    , fusionEncodingWidthLocation( glGetUniformLocation( fusionShader.id, "encodingWidth" ) )
+    , minimumHUVsLocation( glGetUniformLocation( fusionShader.id, "minimumHUVs" ) )
+    , windowingWidthsLocation( glGetUniformLocation( fusionShader.id, "windowingWidths" ) )
+    , weightsLocation( glGetUniformLocation( fusionShader.id, "weights" ) )
+    , worldTextures( MAX_FUSED_SEGMENTS * 16 )
+    , segmentChannels( MAX_FUSED_SEGMENTS )
+    , segmentUnits( MAX_FUSED_SEGMENTS )
+{
+    glGenSamplers( 1, &sampler );
+    glSamplerParameteri( sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+    glSamplerParameteri( sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+    glSamplerParameteri( sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+    glSamplerParameteri( sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+    glSamplerParameteri( sampler, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE );
+}
+
+
+SliceCacheStage::Details::VideoResources::~VideoResources()
+{
+    textures.clear();
+    glDeleteSamplers( 1, &sampler );
+    ShaderResources::release( fusionShader );
+    ShaderResources::release( planesShader );
+    ShaderResources::release( shader );
+}
+
+
+const base::Texture< 3 >& SliceCacheStage::Details::VideoResources::acquireTexture( const base::ManagedTexture3D& texture )
+{
+    std::unique_ptr< base::ManagedTexture3D::ManagedInterface >& textureVR = textures[ &texture ];
+    if( textureVR.get() == nullptr )
+    {
+        textureVR.reset( const_cast< base::ManagedTexture3D& >( texture ).acquireVideoResource() );
+    }
+    return textureVR->get();
+}
+
+
+void SliceCacheStage::Details::VideoResources::releaseTextures( const std::vector< FusedSegment >& segments )
+{
+    for( auto textureItr = textures.begin(); textureItr != textures.end(); )
+    {
+        const auto segmentItr = std::find_if( segments.begin(), segments.end(), [&textureItr]( const FusedSegment& segment )
+            {
+                return &segment.geometry->feature( presets::CuttingPlanesStage::ROLE_HU_VOLUME ) == textureItr->first;
+            }
+        );
+        if( segmentItr == segments.end() )
+        {
+            textureItr = textures.erase( textureItr );
+        }
+        else
+        {
+            ++textureItr;
+        }
+    }
+}
+
+
+SliceCacheStage::Details::VideoResources::QuadMesh* SliceCacheStage::Details::VideoResources::createQuadMesh()
+{
+    base::VertexBase vertices[ 4 ];
+    uint8_t indices[ 6 ];
+
+    vertices[ 0 ].x = -1;
+    vertices[ 0 ].y = -1;
+
+    vertices[ 1 ].x = +1;
+    vertices[ 1 ].y = -1;
+
+    vertices[ 2 ].x = +1;
+    vertices[ 2 ].y = +1;
+
+    vertices[ 3 ].x = -1;
+    vertices[ 3 ].y = +1;
+
+    indices[ 0 ] = 0;
+    indices[ 1 ] = 1;
+    indices[ 2 ] = 2;
+    indices[ 3 ] = 0;
+    indices[ 4 ] = 2;
+    indices[ 5 ] = 3;
+
+    /* Create vertex buffer.
+     */
+    typedef base::VertexBuffer< QuadMesh::Vertex > VBuffer;
+    VBuffer* const vertexBuffer = new VBuffer();
+    vertexBuffer->copy( vertices, 4 );
+
+    /* Create index buffer.
+     */
+    typedef base::IndexBuffer< QuadMesh::Index > IBuffer;
+    IBuffer* const indexBuffer = new IBuffer( base::IndexBufferBase::PRIMITIVE_TYPE_TRIANGLES );
+    indexBuffer->copy( indices, 6 );
+
+    /* Create the mesh.
+     */
+    return new QuadMesh
+        ( new base::Composition< base::VertexBufferBase >( vertexBuffer )
+        , new base::Composition< base:: IndexBufferBase >(  indexBuffer ) );
+}
+
+
+
+void SliceCacheStage::Details::renderFusedPlanes( const base::math::Matrix4f& vt, base::RenderTask& rt, const base::Viewport& vp )
+{
+    rt.renderer.glContext().setShader( vr->planesShader );
+    const base::math::Matrix4f worldClip = rt.projection * vt;
+    const base::math::Matrix4f clipWorld = worldClip.inverse();
+    glUniformMatrix4fv( vr->clipWorldLocation, 1, GL_FALSE, clipWorld.data() );
+    glUniformMatrix4fv( vr->worldClipLocation, 1, GL_FALSE, worldClip.data() );
+    glUniform4f( vr->viewportLocation
+        , static_cast< float >( vp.left() ), static_cast< float >( vp.top() )
+        , static_cast< float >( vp.width() ), static_cast< float >( vp.height() ) );
+    glUniform1f( vr->planesEncodingMinimumLocation, ENCODING_LEVEL - ENCODING_WIDTH / 2.f );
+    glUniform1f( vr->planesEncodingWidthLocation, static_cast< float >( ENCODING_WIDTH ) );
+    glUniform1f( vr->backgroundLocation, background );
+    for( std::size_t firstSegment = 0; firstSegment < fusedSegments.size(); firstSegment += MAX_FUSED_SEGMENTS )
+    {
+        renderFusedBatch( firstSegment, std::min< std::size_t >( MAX_FUSED_SEGMENTS, fusedSegments.size() - firstSegment ) );
+    }
+}
+
+
+void SliceCacheStage::Details::renderFusedBatch( std::size_t firstSegment, std::size_t segments )
+{
+    /* The texture coordinates of the segments map the centers of the corner
+     * voxels to the corners of the unit cube.
+     */
+    const unsigned int firstUnit = base::Texture< 0 >::SETUP_UNIT + 1;
+    for( std::size_t segmentIdx = 0; segmentIdx < MAX_FUSED_SEGMENTS; ++segmentIdx )
+    {
+        const GLint unit = static_cast< GLint >( firstUnit + segmentIdx );
+        vr->segmentUnits[ segmentIdx ] = unit;
+        glActiveTexture( GL_TEXTURE0 + unit );
+        if( segmentIdx < segments )
+        {
+            const FusedSegment& segment = fusedSegments[ firstSegment + segmentIdx ];
+            const base::ManagedTexture3D& texture = static_cast< const base::ManagedTexture3D& >
+                ( segment.geometry->feature( presets::CuttingPlanesStage::ROLE_HU_VOLUME ) );
+            glBindTexture( GL_TEXTURE_3D, vr->acquireTexture( texture ).id );
+            glBindSampler( unit, vr->sampler );
+
+            base::math::Matrix4f modelTexture = base::math::identity4f();
+            for( unsigned int axis = 0; axis < 3; ++axis )
+            {
+                const float size = static_cast< float >( texture.size[ axis ] );
+                modelTexture( axis, axis ) = ( size - 1 ) / size;
+                modelTexture( axis, 3 ) = modelTexture( axis, axis ) / 2 + 0.5f / size;
+            }
+            const base::math::Matrix4f worldTexture = modelTexture * segment.geometry->worldTransform().inverse();
+            std::copy( worldTexture.data(), worldTexture.data() + 16, &vr->worldTextures[ segmentIdx * 16 ] );
+            vr->segmentChannels[ segmentIdx ] = segment.channel;
+        }
+        else
+        {
+            glBindTexture( GL_TEXTURE_3D, 0 );
+        }
+    }
+
+    glUniform1iv( vr->segmentTexturesLocation, MAX_FUSED_SEGMENTS, &vr->segmentUnits.front() );
+    glUniformMatrix4fv( vr->worldTextureLocation, MAX_FUSED_SEGMENTS, GL_FALSE, &vr->worldTextures.front() );
+    glUniform1iv( vr->segmentChannelsLocation, MAX_FUSED_SEGMENTS, &vr->segmentChannels.front() );
+    glUniform1i( vr->segmentsLocation, static_cast< GLint >( segments ) );
+
+    /* Each plane covers the whole viewport, the fragments beyond the volumes are
+     * discarded.
+     */
+    for( auto planeItr = planeGeometries.begin(); planeItr != planeGeometries.end(); ++planeItr )
+    {
+        const base::math::Matrix4f& planeWorld = ( **planeItr ).worldTransform();
+        const base::math::Vector3f normal = planeWorld.col( 2 ).head< 3 >().normalized();
+        const float offset = normal.dot( planeWorld.col( 3 ).head< 3 >() );
+        glUniform4f( vr->planeLocation, normal.x(), normal.y(), normal.z(), offset );
+        vr->quadMesh->render();
+    }
+
+    for( std::size_t segmentIdx = 0; segmentIdx < segments; ++segmentIdx )
+    {
+        glBindSampler( vr->segmentUnits[ segmentIdx ], 0 );
+    }
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// SliceCacheStage :: Details :: Entry
+// ----------------------------------------------------------------------------------
+
+struct SliceCacheStage::Details::Entry
+{
+    Entry( unsigned int width, unsigned int height, GLenum internalFormat );
+    ~Entry();
+
+    const GLenum internalFormat;
+    GLuint huvs;
+    GLuint depths;
+    GLuint fbo;
+
+    bool isValid;
+    std::vector< float > key;
+    std::vector< const base::Geometry* > geometries;
+    std::vector< const base::GeometryFeature* > textures;
+};
+
+
+SliceCacheStage::Details::Entry::Entry( unsigned int width, unsigned int height, GLenum internalFormat )
+    : internalFormat( internalFormat )
+    , isValid( false )
+{
+    /* The depth is cached along with the HUV, s.t. the windowing pass can restore
+     * it for the stages that follow.
+     */
+    glGenTextures( 1, &huvs );
+    glBindTexture( GL_TEXTURE_2D, huvs );
+    glTexImage2D( GL_TEXTURE_2D, 0, internalFormat, width, height, 0, internalFormat == GL_R32F ? GL_RED : GL_RGBA, GL_FLOAT, nullptr );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+
+    glGenTextures( 1, &depths );
+    glBindTexture( GL_TEXTURE_2D, depths );
+    glTexImage2D( GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+    glBindTexture( GL_TEXTURE_2D, 0 );
+
+    GLint previousFramebuffer;
+    glGetIntegerv( GL_FRAMEBUFFER_BINDING, &previousFramebuffer );
+    glGenFramebuffers( 1, &fbo );
+    glBindFramebuffer( GL_FRAMEBUFFER, fbo );
+    glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, huvs, 0 );
+    glFramebufferTexture2D( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depths, 0 );
+    CARNA_ASSERT( glCheckFramebufferStatus( GL_FRAMEBUFFER ) == GL_FRAMEBUFFER_COMPLETE );
+    glBindFramebuffer( GL_FRAMEBUFFER, previousFramebuffer );
+}
+
+
+SliceCacheStage::Details::Entry::~Entry()
+{
+    glDeleteFramebuffers( 1, &fbo );
+    glDeleteTextures( 1, &depths );
+    glDeleteTextures( 1, &huvs );
+}
+
+
+void SliceCacheStage::Details::completeKey( const base::math::Matrix4f& vt, const base::math::Matrix4f& projection, const base::Viewport& vp )
+{
+    key.resize( sceneKeySize );
+    appendKey( vt );
+    appendKey( projection );
+    key.push_back( static_cast< float >( vp.left  () ) );
+    key.push_back( static_cast< float >( vp.top   () ) );
+    key.push_back( static_cast< float >( vp.width () ) );
+    key.push_back( static_cast< float >( vp.height() ) );
+    key.push_back( slabThickness );
+    key.push_back( static_cast< float >( slabMode ) );
+    key.push_back( isInteractive ? interactiveSlabStep : slabStep );
+}
+
+
+void SliceCacheStage::Details::resizeEntries( std::size_t count, GLenum internalFormat )
+{
+    if( !entries.empty() && entries.front()->internalFormat != internalFormat )
+    {
+        entries.clear();
+    }
+    while( entries.size() > count )
+    {
+        entries.pop_back();
+    }
+    while( entries.size() < count )
+    {
+        entries.push_back( std::unique_ptr< Entry >( new Entry( width, height, internalFormat ) ) );
+    }
+    nextEntry %= count;
+}
+
+
+SliceCacheStage::Details::Entry* SliceCacheStage::Details::findEntry() const
+{
+    for( auto entryItr = entries.begin(); entryItr != entries.end(); ++entryItr )
+    {
+        Entry& entry = **entryItr;
+        if( entry.isValid && entry.key == key && entry.geometries == geometries && entry.textures == textures )
+        {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+
+SliceCacheStage::Details::Entry& SliceCacheStage::Details::acquireEntry( const Entry* keep )
+{
+    Entry* entry = entries[ nextEntry ].get();
+    nextEntry = ( nextEntry + 1 ) % entries.size();
+    if( entry == keep )
+    {
+        entry = entries[ nextEntry ].get();
+        nextEntry = ( nextEntry + 1 ) % entries.size();
+    }
+    return *entry;
+}
+
+
+void SliceCacheStage::Details::sampleInto( Entry& entry, const base::math::Matrix4f& vt, base::RenderTask& rt, const base::Viewport& vp )
+{
+    /* The framebuffer that is currently bound is restored afterwards, whatever it
+     * is.
+     */
+    GLint previousFramebuffer;
+    glGetIntegerv( GL_FRAMEBUFFER_BINDING, &previousFramebuffer );
+    glBindFramebuffer( GL_FRAMEBUFFER, entry.fbo );
+    sample( vt, rt, vp );
+    glBindFramebuffer( GL_FRAMEBUFFER, previousFramebuffer );
+
+    entry.key = key;
+    entry.geometries = geometries;
+    entry.textures = textures;
+    entry.isValid = true;
+    ++samplings;
+}
+
+
+void SliceCacheStage::Details::requestPrefetch( const base::math::Matrix4f& vt, base::RenderTask& rt, const base::Viewport& vp )
+{
+    prefetchRenderer = &rt.renderer;
+    *prefetchView = vt;
+    *prefetchProjection = rt.projection;
+    prefetchViewport[ 0 ] = vp.left();
+    prefetchViewport[ 1 ] = vp.top();
+    prefetchViewport[ 2 ] = vp.width();
+    prefetchViewport[ 3 ] = vp.height();
+    prefetchTimer->timer.start( 0, prefetchTimer.get() );
+}
+
+
+void SliceCacheStage::Details::cancelPrefetch()
+{
+    prefetchRenderer = nullptr;
+    prefetchTimer->timer.stop();
+}
+
+
+void SliceCacheStage::Details::prefetch( SliceCacheStage& self )
+{
+    if( prefetchRenderer == nullptr || root == nullptr || vr.get() == nullptr )
+    {
+        return;
+    }
+    const base::FrameRenderer& renderer = *prefetchRenderer;
+    prefetchRenderer = nullptr;
+    renderer.glContext().makeCurrent();
+
+    /* The scene might have changed since the frame was rendered, hence the key is
+     * composed again. The slices are prefetched ahead of the plane's current
+     * position then, that the next frame of the cine mode starts from.
+     */
+    self.prepareFrame( *root );
+    if( prefetchPlane == nullptr || prefetchKeyOffset == std::numeric_limits< std::size_t >::max() )
+    {
+        return;
+    }
+    const base::Viewport rootViewport( renderer, false );
+    const base::Viewport vp( rootViewport, prefetchViewport[ 0 ], prefetchViewport[ 1 ], prefetchViewport[ 2 ], prefetchViewport[ 3 ] );
+    base::RenderTask rt( renderer, *prefetchProjection, *prefetchView );
+    vr->releaseTextures( fusedSegments );
+    completeKey( *prefetchView, *prefetchProjection, vp );
+    prefetch( findEntry(), *prefetchView, rt, vp );
+}
+
+
+void SliceCacheStage::Details::prefetch( const Entry* presented, const base::math::Matrix4f& vt, base::RenderTask& rt, const base::Viewport& vp )
+{
+    /* The plane is displaced exactly like it is advanced by the cine mode, s.t.
+     * the keys match bit by bit.
+     */
+    base::Geometry& plane = *prefetchPlane;
+    const base::math::Matrix4f originalTransform = plane.localTransform;
+    for( unsigned int sliceIdx = 0; sliceIdx < prefetchCount; ++sliceIdx )
+    {
+        plane.localTransform = plane.localTransform * base::math::translation4f( 0, 0, prefetchStep );
+        plane.updateWorldTransform();
+        std::copy( plane.worldTransform().data(), plane.worldTransform().data() + 16, &key[ prefetchKeyOffset ] );
+        if( findEntry() == nullptr )
+        {
+            planes->prepareFrame( *root );
+            sampleInto( acquireEntry( presented ), vt, rt, vp );
+            ++prefetches;
+        }
+    }
+    plane.localTransform = originalTransform;
+    plane.updateWorldTransform();
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// SliceCacheStage
+// ----------------------------------------------------------------------------------
+
+SliceCacheStage::SliceCacheStage( unsigned int geometryTypeVolume, unsigned int geometryTypePlanes )
+    : pimpl( new Details( geometryTypeVolume, geometryTypePlanes ) )
+    , geometryTypeVolume( geometryTypeVolume )
+    , geometryTypePlanes( geometryTypePlanes )
+{
+    pimpl->prefetchTimer.reset( new Details::PrefetchTimer( *this ) );
+}
+
+
+SliceCacheStage::~SliceCacheStage()
+{
+}
+
+
+SliceCacheStage* SliceCacheStage::clone() const
+{
+    SliceCacheStage* const result = new SliceCacheStage( geometryTypeVolume, geometryTypePlanes );
+    result->setWindowingLevel( windowingLevel() );
+    result->setWindowingWidth( windowingWidth() );
+    result->setSlabThickness( slabThickness() );
+    result->setSlabMode( slabMode() );
+    result->setSlabStep( slabStep() );
+    result->setInteractiveSlabStep( interactiveSlabStep() );
+    result->setFusedVolumes( pimpl->fusedVolumes );
+    result->setEnabled( isEnabled() );
+    return result;
+}
+
+
+void SliceCacheStage::addConsumedGeometryTypes( std::set< unsigned int >& types ) const
+{
+    types.insert( geometryTypeVolume );
+    types.insert( geometryTypePlanes );
+}
+
+
+void SliceCacheStage::reshape( base::FrameRenderer& fr, unsigned int width, unsigned int height )
+{
+    base::RenderStage::reshape( fr, width, height );
+    pimpl->planes->reshape( fr, width, height );
+    pimpl->width  = width;
+    pimpl->height = height;
+    pimpl->vr.reset();
+    pimpl->entries.clear();
+    pimpl->cancelPrefetch();
+}
+
+
+bool SliceCacheStage::isInitialized() const
+{
+    return pimpl->planes->isInitialized();
+}
+
+
+void SliceCacheStage::prepareFrame( base::Node& root )
+{
+    base::RenderStage::prepareFrame( root );
+    pimpl->planes->prepareFrame( root );
+    pimpl->root = &root;
+
+    /* Compose the part of the key that depends on the scene.
+     */
+    pimpl->key.clear();
+    pimpl->geometries.clear();
+    pimpl->textures.clear();
+    pimpl->planeGeometries.clear();
+    pimpl->isInteractive = false;
+    pimpl->prefetchKeyOffset = std::numeric_limits< std::size_t >::max();
+    pimpl->fusedSegments.clear();
+    root.visitChildren( true, [this]( base::Spatial& spatial )
+        {
+            base::Geometry* const geometry = dynamic_cast< base::Geometry* >( &spatial );
+            if( geometry != nullptr
+                && ( geometry->geometryType == geometryTypeVolume || geometry->geometryType == geometryTypePlanes ) )
+            {
+                if( geometry == pimpl->prefetchPlane )
+                {
+                    pimpl->prefetchKeyOffset = pimpl->key.size();
+                }
+                pimpl->geometries.push_back( geometry );
+                pimpl->appendKey( geometry->worldTransform() );
+                if( geometry->geometryType == geometryTypeVolume )
+                {
+                    pimpl->textures.push_back( geometry->hasFeature( presets::CuttingPlanesStage::ROLE_HU_VOLUME )
+                        ? &geometry->feature( presets::CuttingPlanesStage::ROLE_HU_VOLUME )
+                        : nullptr );
+                }
+                if( geometry->geometryType == geometryTypeVolume && pimpl->isFused() )
+                {
+                    /* The key also depends on the channel each volume is sampled to.
+                     */
+                    const Details::FusedSegment segment = { geometry, pimpl->channelOf( *geometry ) };
+                    pimpl->key.push_back( static_cast< float >( segment.channel ) );
+                    if( segment.channel >= 0 && geometry->hasFeature( presets::CuttingPlanesStage::ROLE_HU_VOLUME ) )
+                    {
+                        pimpl->fusedSegments.push_back( segment );
+                    }
+                }
+                if( geometry->geometryType == geometryTypePlanes )
+                {
+                    pimpl->planeGeometries.push_back( geometry );
+                    if( geometry->hasFeature( MPRStage::ROLE_PLANE_DATA ) )
+                    {
+                        const MPRDataFeature& planeData = static_cast< const MPRDataFeature& >( geometry->feature( MPRStage::ROLE_PLANE_DATA ) );
+                        pimpl->isInteractive = pimpl->isInteractive || planeData.isMoving;
+                    }
+                }
+            }
+        }
+    );
+    pimpl->sceneKeySize = pimpl->key.size();
+}
+
+
+void SliceCacheStage::renderPass
+    ( const base::math::Matrix4f& vt
+    , base::RenderTask& rt
+    , const base::Viewport& vp )
+{
+    if( pimpl->vr.get() == nullptr )
+    {
+        pimpl->vr.reset( new Details::VideoResources() );
+    }
+    const bool prefetching = pimpl->prefetchPlane != nullptr && pimpl->prefetchKeyOffset != std::numeric_limits< std::size_t >::max();
+    pimpl->resizeEntries( 1 + ( prefetching ? pimpl->prefetchCount : 0 ), pimpl->isFused() ? GL_RGBA32F : GL_R32F );
+    pimpl->vr->releaseTextures( pimpl->fusedSegments );
+
+    /* Complete the key by the view, the projection and the viewport.
+     */
+    pimpl->completeKey( vt, rt.projection, vp );
+
+    Details::Entry* entry = pimpl->findEntry();
+    if( entry == nullptr )
+    {
+        entry = &pimpl->acquireEntry( nullptr );
+        pimpl->sampleInto( *entry, vt, rt, vp );
+    }
+
+    /* Map the cached HUV to intensities and restore the depth. The depth test
+     * must be enabled for the depth to be written, but it must always pass.
+     */
+    base::RenderState rs;
+    rs.setDepthTest( true );
+    rs.setDepthWrite( true );
+    rs.setDepthTestFunction( GL_ALWAYS );
+    rs.setBlend( false );
+
+    const unsigned int huvsUnit   = base::Texture< 0 >::SETUP_UNIT + 1;
+    const unsigned int depthsUnit = base::Texture< 0 >::SETUP_UNIT + 2;
+    glActiveTexture( GL_TEXTURE0 + huvsUnit );
+    glBindTexture( GL_TEXTURE_2D, entry->huvs );
+    glActiveTexture( GL_TEXTURE0 + depthsUnit );
+    glBindTexture( GL_TEXTURE_2D, entry->depths );
+
+    if( pimpl->isFused() )
+    {
+        /* Blend the volumes, that are stored in distinct channels.
+         */
+        float minimumHUVs[ 4 ] = { 0, 0, 0, 0 };
+        float windowingWidths[ 4 ] = { 1, 1, 1, 1 };
+        float weights[ 4 ] = { 0, 0, 0, 0 };
+        for( std::size_t volumeIdx = 0; volumeIdx < pimpl->fusedVolumes.size(); ++volumeIdx )
+        {
+            const MPRDisplay::FusedVolume& volume = pimpl->fusedVolumes[ volumeIdx ];
+            minimumHUVs[ volumeIdx ] = volume.windowingLevel - volume.windowingWidth / 2.f;
+            windowingWidths[ volumeIdx ] = static_cast< float >( std::max( 1u, volume.windowingWidth ) );
+            weights[ volumeIdx ] = volume.weight;
+        }
+        rt.renderer.glContext().setShader( pimpl->vr->fusionShader );
+        glUniform1i( pimpl->vr->fusionHUVsLocation, huvsUnit );
+        glUniform1i( pimpl->vr->fusionDepthsLocation, depthsUnit );
+        glUniform1f( pimpl->vr->fusionEncodingMinimumLocation, Details::ENCODING_LEVEL - Details::ENCODING_WIDTH / 2.f );
+        glUniform1f( pimpl->vr->fusionEncodingWidthLocation, static_cast< float >( Details::ENCODING_WIDTH ) );
+        glUniform4fv( pimpl->vr->minimumHUVsLocation, 1, minimumHUVs );
+        glUniform4fv( pimpl->vr->windowingWidthsLocation, 1, windowingWidths );
+        glUniform4fv( pimpl->vr->weightsLocation, 1, weights );
+    }
+    else
+    {
+        rt.renderer.glContext().setShader( pimpl->vr->shader );
+        glUniform1i( pimpl->vr->huvsLocation, huvsUnit );
+        glUniform1i( pimpl->vr->depthsLocation, depthsUnit );
+        glUniform1f( pimpl->vr->encodingMinimumLocation, Details::ENCODING_LEVEL - Details::ENCODING_WIDTH / 2.f );
+        glUniform1f( pimpl->vr->encodingWidthLocation, static_cast< float >( Details::ENCODING_WIDTH ) );
+        glUniform1f( pimpl->vr->minimumHUVLocation, pimpl->windowingLevel - pimpl->windowingWidth / 2.f );
+        glUniform1f( pimpl->vr->windowingWidthLocation, static_cast< float >( std::max( 1u, pimpl->windowingWidth ) ) );
+    }
+
+    vp.makeActive();
+    pimpl->vr->quadMesh->render();
+    vp.done();
+
+    if( prefetching )
+    {
+        pimpl->requestPrefetch( vt, rt, vp );
+    }
+}
+
+
+void SliceCacheStage::setWindowingLevel( base::HUV windowingLevel )
+{
+    pimpl->windowingLevel = windowingLevel;
+}
+
+
+void SliceCacheStage::setWindowingWidth( unsigned int windowingWidth )
+{
+    pimpl->windowingWidth = windowingWidth;
+}
+
+
+base::HUV SliceCacheStage::windowingLevel() const
+{
+    return pimpl->windowingLevel;
+}
+
+
+unsigned int SliceCacheStage::windowingWidth() const
+{
+    return pimpl->windowingWidth;
+}
+
+
+base::HUV SliceCacheStage::minimumHUV() const
+{
+    return static_cast< base::HUV >( pimpl->windowingLevel - static_cast< int >( pimpl->windowingWidth / 2 ) );
+}
+
+
+base::HUV SliceCacheStage::maximumHUV() const
+{
+    return static_cast< base::HUV >( pimpl->windowingLevel + static_cast< int >( pimpl->windowingWidth / 2 ) );
+}
+
+
+void SliceCacheStage::setSlabThickness( float thickness )
+{
+    pimpl->slabThickness = thickness;
+}
+
+
+float SliceCacheStage::slabThickness() const
+{
+    return pimpl->slabThickness;
+}
+
+
+void SliceCacheStage::setSlabMode( MPRDisplay::SlabMode mode )
+{
+    pimpl->slabMode = mode;
+}
+
+
+MPRDisplay::SlabMode SliceCacheStage::slabMode() const
+{
+    return pimpl->slabMode;
+}
+
+
+void SliceCacheStage::setSlabStep( float step )
+{
+    pimpl->slabStep = step;
+}
+
+
+float SliceCacheStage::slabStep() const
+{
+    return pimpl->slabStep;
+}
+
+
+void SliceCacheStage::setInteractiveSlabStep( float step )
+{
+    pimpl->interactiveSlabStep = step;
+}
+
+
+float SliceCacheStage::interactiveSlabStep() const
+{
+    return pimpl->interactiveSlabStep;
+}
+
+
+void SliceCacheStage::setPrefetch( base::Geometry* plane, float step, unsigned int count )
+{
+    pimpl->prefetchPlane = plane;
+    pimpl->prefetchStep  = step;
+    pimpl->prefetchCount = plane == nullptr ? 0 : count;
+    pimpl->cancelPrefetch();
+}
+
+
+std::size_t SliceCacheStage::prefetches() const
+{
+    return pimpl->prefetches;
+}
+
+
+void SliceCacheStage::setFusedVolumes( const std::vector< MPRDisplay::FusedVolume >& volumes )
+{
+    pimpl->fusedVolumes = volumes;
+}
+
+
+void SliceCacheStage::invalidate()
+{
+    for( auto entryItr = pimpl->entries.begin(); entryItr != pimpl->entries.end(); ++entryItr )
+    {
+        ( **entryItr ).isValid = false;
+    }
+}
+
+
+std::size_t SliceCacheStage::samplings() const
+{
+    return pimpl->samplings;
+}
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
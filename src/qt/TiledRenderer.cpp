@@ -0,0 +1,245 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#include <Carna/base/glew.h>
+#include <Carna/qt/TiledRenderer.h>
+#include <Carna/qt/Display.h>
+#include <Carna/base/FrameRenderer.h>
+#include <Carna/base/GLContext.h>
+#include <Carna/base/Framebuffer.h>
+#include <Carna/base/RenderTexture.h>
+#include <Carna/base/ProjectionControl.h>
+#include <Carna/base/Viewport.h>
+#include <Carna/base/Camera.h>
+#include <Carna/base/Log.h>
+#include <Carna/base/math.h>
+#include <QImage>
+#include <algorithm>
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// TiledRenderer :: TileSink
+// ----------------------------------------------------------------------------------
+
+TiledRenderer::TileSink::~TileSink()
+{
+}
+
+
+void TiledRenderer::TileSink::begin( unsigned int width, unsigned int height, unsigned int columns, unsigned int rows )
+{
+}
+
+
+void TiledRenderer::TileSink::finish()
+{
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// TiledRenderer :: TileFileSink
+// ----------------------------------------------------------------------------------
+
+TiledRenderer::TileFileSink::TileFileSink( const QString& prefix, const QString& format )
+    : prefix( prefix )
+    , format( format )
+{
+}
+
+
+QString TiledRenderer::TileFileSink::fileName( unsigned int column, unsigned int row ) const
+{
+    return QString( "%1_%2_%3.%4" ).arg( prefix ).arg( row ).arg( column ).arg( format );
+}
+
+
+void TiledRenderer::TileFileSink::write
+    ( unsigned int column, unsigned int row
+    , unsigned int left, unsigned int top
+    , const QImage& tile )
+{
+    const QString path = fileName( column, row );
+    if( !tile.save( path, format.toStdString().c_str() ) )
+    {
+        base::Log::instance().record( base::Log::error, "Failed to write tile: " + path.toStdString() );
+    }
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// TiledRenderer :: Details
+// ----------------------------------------------------------------------------------
+
+struct TiledRenderer::Details
+{
+    Details( Display& display, unsigned int tileSize );
+
+    Display& display;
+    const unsigned int tileSize;
+
+    static base::math::Matrix4f subFrustum
+        ( unsigned int width, unsigned int height
+        , unsigned int left, unsigned int top
+        , unsigned int tileWidth, unsigned int tileHeight );
+};
+
+
+TiledRenderer::Details::Details( Display& display, unsigned int tileSize )
+    : display( display )
+    , tileSize( tileSize )
+{
+}
+
+
+base::math::Matrix4f TiledRenderer::Details::subFrustum
+    ( unsigned int width, unsigned int height
+    , unsigned int left, unsigned int top
+    , unsigned int tileWidth, unsigned int tileHeight )
+{
+    /* Compute the tile's bounds in normalized device coordinates. Note that the
+     * y-axis points upwards, whereas 'top' refers to the upper edge.
+     */
+    const float x0 = -1 + 2.f *   left                 / width;
+    const float x1 = -1 + 2.f * ( left + tileWidth   ) / width;
+    const float y0 = +1 - 2.f * ( top  + tileHeight  ) / height;
+    const float y1 = +1 - 2.f *   top                  / height;
+
+    /* Map the bounds to [-1, +1]. Since the mapping is applied to the clip
+     * coordinates, it is valid for perspective projections as well.
+     */
+    base::math::Matrix4f result = base::math::identity4f();
+    result( 0, 0 ) = 2 / ( x1 - x0 );
+    result( 1, 1 ) = 2 / ( y1 - y0 );
+    result( 0, 3 ) = -( x1 + x0 ) / ( x1 - x0 );
+    result( 1, 3 ) = -( y1 + y0 ) / ( y1 - y0 );
+    return result;
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// TiledRenderer
+// ----------------------------------------------------------------------------------
+
+const unsigned int TiledRenderer::DEFAULT_TILE_SIZE = 2048;
+
+
+TiledRenderer::TiledRenderer( Display& display, unsigned int tileSize )
+    : pimpl( new Details( display, tileSize ) )
+{
+    CARNA_ASSERT( tileSize > 0 );
+}
+
+
+TiledRenderer::~TiledRenderer()
+{
+}
+
+
+unsigned int TiledRenderer::tileSize() const
+{
+    return pimpl->tileSize;
+}
+
+
+void TiledRenderer::render( unsigned int width, unsigned int height, TileSink& sink )
+{
+    Display& display = pimpl->display;
+    CARNA_ASSERT( display.hasRenderer() );
+    CARNA_ASSERT( display.hasCamera() );
+    CARNA_ASSERT( width > 0 && height > 0 );
+    CARNA_LOG_TAG_SCOPE( display.logTag() );
+
+    /* Activate the context through Carna, like the display does, s.t. Carna keeps
+     * track of the current context.
+     */
+    base::FrameRenderer& renderer = display.renderer();
+    renderer.glContext().makeCurrent();
+    base::Camera& cam = display.camera();
+    base::Node& root = cam.findRoot();
+
+    /* Fit the projection to the image's side lengths ratio if possible.
+     */
+    const base::math::Matrix4f displayProjection = cam.projection();
+    base::math::Matrix4f projection = displayProjection;
+    if( display.hasProjectionControl() )
+    {
+        display.projectionControl().setViewportWidth ( width  );
+        display.projectionControl().setViewportHeight( height );
+        display.projectionControl().updateProjection( projection );
+    }
+
+    /* Only a single tile is held in video memory and system memory at once.
+     */
+    const unsigned int tileSize = std::min( pimpl->tileSize, std::max( width, height ) );
+    const unsigned int displayWidth  = renderer.width();
+    const unsigned int displayHeight = renderer.height();
+    renderer.reshape( tileSize, tileSize, false );
+    {
+        base::RenderTexture colorBuffer( tileSize, tileSize );
+        base::Framebuffer fbo( tileSize, tileSize, colorBuffer );
+        const base::Viewport rootViewport( renderer, false );
+        QImage tile( tileSize, tileSize, QImage::Format_ARGB32 );
+
+        const unsigned int columns = ( width  + tileSize - 1 ) / tileSize;
+        const unsigned int rows    = ( height + tileSize - 1 ) / tileSize;
+        sink.begin( width, height, columns, rows );
+        for( unsigned int row = 0; row < rows; ++row )
+        for( unsigned int column = 0; column < columns; ++column )
+        {
+            const unsigned int left = column * tileSize;
+            const unsigned int top  = row    * tileSize;
+            const unsigned int tileWidth  = std::min( tileSize, width  - left );
+            const unsigned int tileHeight = std::min( tileSize, height - top  );
+
+            /* Tiles at the right and lower edges might be smaller. They are
+             * rendered to the lower left corner of the framebuffer.
+             */
+            const base::Viewport tileViewport( rootViewport, 0, tileSize - tileHeight, tileWidth, tileHeight );
+            cam.setProjection( Details::subFrustum( width, height, left, top, tileWidth, tileHeight ) * projection );
+            CARNA_RENDER_TO_FRAMEBUFFER( fbo,
+                renderer.render( cam, root, tileViewport );
+                glPixelStorei( GL_PACK_ALIGNMENT, 4 );
+                glPixelStorei( GL_PACK_ROW_LENGTH, tileSize );
+                glReadPixels( 0, 0, tileWidth, tileHeight, GL_BGRA, GL_UNSIGNED_BYTE, tile.bits() );
+                glPixelStorei( GL_PACK_ROW_LENGTH, 0 );
+            );
+
+            /* OpenGL stores the rows bottom-up, hence the tile must be mirrored.
+             */
+            const QImage tileImage = tile.copy( 0, 0, tileWidth, tileHeight ).mirrored( false, true );
+            sink.write( column, row, left, top, tileImage );
+        }
+        sink.finish();
+    }
+
+    /* Restore the display's state.
+     */
+    renderer.reshape( displayWidth, displayHeight, false );
+    cam.setProjection( displayProjection );
+    display.updateProjection();
+    display.invalidate();
+}
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
@@ -0,0 +1,690 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#include <Carna/base/glew.h>
+#include <Carna/qt/VolumeUploadScheduler.h>
+#include <Carna/base/Node.h>
+#include <Carna/base/NodeListener.h>
+#include <Carna/base/Geometry.h>
+#include <Carna/base/ManagedTexture3D.h>
+#include <Carna/base/Texture3D.h>
+#include <Carna/base/GLContext.h>
+#include <Carna/base/CarnaException.h>
+#include <Carna/base/glError.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include <set>
+#include <map>
+
+namespace Carna
+{
+
+namespace qt
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// bytesPerVoxel
+// ----------------------------------------------------------------------------------
+
+static std::size_t bytesPerVoxel( int pixelFormat, int bufferType )
+{
+    std::size_t components;
+    switch( pixelFormat )
+    {
+
+    case GL_RED:
+    case GL_RED_INTEGER:
+    case GL_DEPTH_COMPONENT:
+        components = 1;
+        break;
+
+    case GL_RG:
+    case GL_RG_INTEGER:
+        components = 2;
+        break;
+
+    case GL_RGB:
+    case GL_BGR:
+        components = 3;
+        break;
+
+    case GL_RGBA:
+    case GL_BGRA:
+        components = 4;
+        break;
+
+    default:
+        CARNA_FAIL( "Unsupported pixel format." );
+
+    }
+    switch( bufferType )
+    {
+
+    case GL_UNSIGNED_BYTE:
+    case GL_BYTE:
+        return components;
+
+    case GL_UNSIGNED_SHORT:
+    case GL_SHORT:
+    case GL_HALF_FLOAT:
+        return components * 2;
+
+    case GL_UNSIGNED_INT:
+    case GL_INT:
+    case GL_FLOAT:
+        return components * 4;
+
+    default:
+        CARNA_FAIL( "Unsupported buffer type." );
+
+    }
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// VolumeUploadScheduler :: Details
+// ----------------------------------------------------------------------------------
+
+struct VolumeUploadScheduler::Details
+{
+    Details();
+    ~Details();
+
+    std::size_t bytesPerFrame;
+    std::size_t bytesTotal;
+    std::size_t bytesUploaded;
+
+    struct Segment;
+    std::vector< Segment* > segments;
+    std::size_t nextSegment;
+    std::set< const base::Geometry* > enqueued;
+    std::set< const base::Geometry* > resident;
+    bool isFinishPending;
+
+    /* The parents of the segments are watched, s.t. segments, that are removed
+     * from the scene or deleted, are dropped before their geometries become
+     * invalid. A segment's geometry is still alive when it is detached from its
+     * parent, but it is not when its parent is deleted.
+     */
+    struct ParentWatch;
+    std::map< const base::Node*, ParentWatch* > parentWatches;
+    void watch( base::Node& parent );
+    void dropSegments( const base::Node& parent, const std::set< const base::Spatial* >* children );
+    void dropSegment( std::size_t segmentIdx, bool isGeometryAlive );
+
+    /* The context that the textures and buffers were created with. It is made
+     * current when they are deleted.
+     */
+    const base::GLContext* glContext;
+
+    /* The original textures are put on this geometry, which never becomes part of
+     * the scene, s.t. they stay alive while the placeholders are shown.
+     */
+    base::Geometry originals;
+    unsigned int nextOriginalRole;
+
+    /* Streamed textures must not be released before the rendering stages have
+     * acquired them, otherwise they would be deleted and re-created empty.
+     */
+    std::vector< base::ManagedTexture3D::ManagedInterface* > retiring;
+    void releaseRetired();
+
+    const static std::size_t PBO_COUNT = 2;
+    unsigned int pbos[ PBO_COUNT ];
+    unsigned int nextPbo;
+    void createPbos();
+
+    static const void* placeholderData();
+    bool upload( Segment& segment, std::size_t budget );
+};
+
+
+struct VolumeUploadScheduler::Details::Segment
+{
+    Segment
+        ( base::Geometry& geometry
+        , unsigned int role
+        , unsigned int originalRole
+        , base::ManagedTexture3D& original
+        , base::ManagedTexture3D& target
+        , base::ManagedTexture3D& placeholder );
+    ~Segment();
+
+    base::Geometry& geometry;
+    const base::Node& parent;
+    const unsigned int role;
+    const unsigned int originalRole;
+    base::ManagedTexture3D& original;
+    base::ManagedTexture3D& target;
+    base::ManagedTexture3D& placeholder;
+    std::unique_ptr< base::ManagedTexture3D::ManagedInterface > targetVR;
+
+    const std::size_t bytesPerSlice;
+    const unsigned int slices;
+    unsigned int nextSlice;
+    bool isComplete() const;
+    void restoreOriginal();
+};
+
+
+VolumeUploadScheduler::Details::Segment::Segment
+        ( base::Geometry& geometry
+        , unsigned int role
+        , unsigned int originalRole
+        , base::ManagedTexture3D& original
+        , base::ManagedTexture3D& target
+        , base::ManagedTexture3D& placeholder )
+    : geometry( geometry )
+    , parent( geometry.parent() )
+    , role( role )
+    , originalRole( originalRole )
+    , original( original )
+    , target( target )
+    , placeholder( placeholder )
+    , bytesPerSlice( original.size.x() * original.size.y() * bytesPerVoxel( original.pixelFormat, original.bufferType ) )
+    , slices( original.size.z() )
+    , nextSlice( 0 )
+{
+}
+
+
+VolumeUploadScheduler::Details::Segment::~Segment()
+{
+    /* Our reference to the streamed texture is handed over to the geometry when the
+     * segment is complete, otherwise we still have to release it. The original
+     * might be deleted already at this point, hence it is not accessed. The video
+     * resource is handed over to the retiring ones, if the segment is dropped.
+     */
+    if( !isComplete() )
+    {
+        targetVR.reset();
+        target.release();
+    }
+}
+
+
+bool VolumeUploadScheduler::Details::Segment::isComplete() const
+{
+    return nextSlice == slices;
+}
+
+
+void VolumeUploadScheduler::Details::Segment::restoreOriginal()
+{
+    /* Put the original texture back unless the placeholder was replaced by
+     * someone else meanwhile.
+     */
+    if( geometry.hasFeature( role ) && &geometry.feature( role ) == &placeholder )
+    {
+        geometry.removeFeature( role );
+        geometry.putFeature( role, original );
+    }
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// VolumeUploadScheduler :: Details :: ParentWatch
+// ----------------------------------------------------------------------------------
+
+struct VolumeUploadScheduler::Details::ParentWatch : public base::NodeListener
+{
+    ParentWatch( Details& scheduler, base::Node& parent );
+    virtual ~ParentWatch();
+    Details& scheduler;
+    base::Node& parent;
+    bool isDeleted;
+
+    virtual void onNodeDelete( const base::Node& node ) override;
+    virtual void onTreeChange( base::Node& node, bool inThisSubtree ) override;
+    virtual void onTreeInvalidated( base::Node& subtree ) override;
+};
+
+
+VolumeUploadScheduler::Details::ParentWatch::ParentWatch( Details& scheduler, base::Node& parent )
+    : scheduler( scheduler )
+    , parent( parent )
+    , isDeleted( false )
+{
+    parent.addNodeListener( *this );
+}
+
+
+VolumeUploadScheduler::Details::ParentWatch::~ParentWatch()
+{
+    if( !isDeleted )
+    {
+        parent.removeNodeListener( *this );
+    }
+}
+
+
+void VolumeUploadScheduler::Details::ParentWatch::onNodeDelete( const base::Node& node )
+{
+    /* The geometries of the segments are deleted together with their parent. We
+     * are not allowed to remove the listener from the dying node. This deletes
+     * the watch, hence nothing must be done afterwards.
+     */
+    isDeleted = true;
+    Details& scheduler = this->scheduler;
+    scheduler.dropSegments( parent, nullptr );
+    scheduler.parentWatches.erase( &parent );
+    delete this;
+}
+
+
+void VolumeUploadScheduler::Details::ParentWatch::onTreeChange( base::Node& node, bool inThisSubtree )
+{
+    /* Drop the segments, whose geometries are no longer children of the parent.
+     * These are still alive.
+     */
+    if( inThisSubtree )
+    {
+        std::set< const base::Spatial* > children;
+        parent.visitChildren( false, [&children]( const base::Spatial& child )
+            {
+                children.insert( &child );
+            }
+        );
+        scheduler.dropSegments( parent, &children );
+    }
+}
+
+
+void VolumeUploadScheduler::Details::ParentWatch::onTreeInvalidated( base::Node& subtree )
+{
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// VolumeUploadScheduler :: Details
+// ----------------------------------------------------------------------------------
+
+VolumeUploadScheduler::Details::Details()
+    : bytesPerFrame( DEFAULT_BYTES_PER_FRAME )
+    , bytesTotal( 0 )
+    , bytesUploaded( 0 )
+    , nextSegment( 0 )
+    , isFinishPending( false )
+    , glContext( nullptr )
+    , originals( 0 )
+    , nextOriginalRole( 0 )
+    , nextPbo( 0 )
+{
+    std::fill( pbos, pbos + PBO_COUNT, 0 );
+}
+
+
+VolumeUploadScheduler::Details::~Details()
+{
+    if( glContext != nullptr )
+    {
+        glContext->makeCurrent();
+    }
+    for( auto watchItr = parentWatches.begin(); watchItr != parentWatches.end(); ++watchItr )
+    {
+        delete watchItr->second;
+    }
+
+    /* The segments, that were not streamed completely, get their original textures
+     * back, s.t. they are not left with the placeholders.
+     */
+    for( std::size_t segmentIdx = nextSegment; segmentIdx < segments.size(); ++segmentIdx )
+    {
+        Segment& segment = *segments[ segmentIdx ];
+        segment.restoreOriginal();
+        originals.removeFeature( segment.originalRole );
+        if( segment.targetVR.get() != nullptr )
+        {
+            retiring.push_back( segment.targetVR.release() );
+        }
+    }
+    releaseRetired();
+    for( auto segmentItr = segments.begin(); segmentItr != segments.end(); ++segmentItr )
+    {
+        delete *segmentItr;
+    }
+    if( pbos[ 0 ] != 0 )
+    {
+        glDeleteBuffers( PBO_COUNT, pbos );
+    }
+}
+
+
+void VolumeUploadScheduler::Details::watch( base::Node& parent )
+{
+    if( parentWatches.find( &parent ) == parentWatches.end() )
+    {
+        parentWatches[ &parent ] = new ParentWatch( *this, parent );
+    }
+}
+
+
+void VolumeUploadScheduler::Details::dropSegments( const base::Node& parent, const std::set< const base::Spatial* >* children )
+{
+    for( std::size_t segmentIdx = segments.size(); segmentIdx > 0; --segmentIdx )
+    {
+        const Segment& segment = *segments[ segmentIdx - 1 ];
+        if( &segment.parent == &parent )
+        {
+            if( children == nullptr )
+            {
+                dropSegment( segmentIdx - 1, false );
+            }
+            else
+            if( children->find( &segment.geometry ) == children->end() )
+            {
+                dropSegment( segmentIdx - 1, true );
+            }
+        }
+    }
+}
+
+
+void VolumeUploadScheduler::Details::dropSegment( std::size_t segmentIdx, bool isGeometryAlive )
+{
+    Segment* const segment = segments[ segmentIdx ];
+    if( !segment->isComplete() )
+    {
+        if( isGeometryAlive )
+        {
+            segment->restoreOriginal();
+        }
+        originals.removeFeature( segment->originalRole );
+        bytesTotal    -= segment->bytesPerSlice * segment->slices;
+        bytesUploaded -= segment->bytesPerSlice * segment->nextSlice;
+
+        /* The video resource is released with the OpenGL context current, that is
+         * the next time the scheduler is processed.
+         */
+        if( segment->targetVR.get() != nullptr )
+        {
+            retiring.push_back( segment->targetVR.release() );
+        }
+    }
+    enqueued.erase( &segment->geometry );
+    resident.erase( &segment->geometry );
+    delete segment;
+    segments.erase( segments.begin() + segmentIdx );
+    if( segmentIdx < nextSegment )
+    {
+        --nextSegment;
+    }
+    else
+    if( nextSegment == segments.size() )
+    {
+        isFinishPending = true;
+    }
+}
+
+
+void VolumeUploadScheduler::Details::releaseRetired()
+{
+    for( auto vrItr = retiring.begin(); vrItr != retiring.end(); ++vrItr )
+    {
+        delete *vrItr;
+    }
+    retiring.clear();
+}
+
+
+void VolumeUploadScheduler::Details::createPbos()
+{
+    if( pbos[ 0 ] == 0 )
+    {
+        glGenBuffers( PBO_COUNT, pbos );
+    }
+}
+
+
+const void* VolumeUploadScheduler::Details::placeholderData()
+{
+    /* Sufficient for a single voxel of any supported format.
+     */
+    static const float zeros[ 4 ] = { 0, 0, 0, 0 };
+    return zeros;
+}
+
+
+bool VolumeUploadScheduler::Details::upload( Segment& segment, std::size_t budget )
+{
+    const base::math::Vector3ui& size = segment.original.size;
+    const unsigned int slicesLeft = segment.slices - segment.nextSlice;
+    const unsigned int slices = std::min
+        ( slicesLeft
+        , static_cast< unsigned int >( std::max< std::size_t >( 1, budget / segment.bytesPerSlice ) ) );
+    const std::size_t bytes = slices * segment.bytesPerSlice;
+    const char* const src = static_cast< const char* >( segment.original.bufferPtr ) + segment.nextSlice * segment.bytesPerSlice;
+
+    /* Allocate the texture storage if not done yet. Since the target was created
+     * without any data, no upload takes place here.
+     */
+    if( segment.targetVR.get() == nullptr )
+    {
+        segment.targetVR.reset( segment.target.acquireVideoResource() );
+    }
+
+    /* Orphan the buffer s.t. we do not have to wait for the driver to finish any
+     * transfer that is still pending from the previous frame, then fill it.
+     */
+    const unsigned int pbo = pbos[ nextPbo ];
+    nextPbo = ( nextPbo + 1 ) % PBO_COUNT;
+    glBindBuffer( GL_PIXEL_UNPACK_BUFFER, pbo );
+    glBufferData( GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW );
+    void* const dst = glMapBufferRange( GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT );
+    CARNA_ASSERT( dst != nullptr );
+    std::memcpy( dst, src, bytes );
+    glUnmapBuffer( GL_PIXEL_UNPACK_BUFFER );
+
+    /* The transfer from the buffer to the texture runs asynchronously.
+     */
+    glBindTexture( GL_TEXTURE_3D, segment.targetVR->get().id );
+    glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+    glTexSubImage3D
+        ( GL_TEXTURE_3D, 0
+        , 0, 0, segment.nextSlice
+        , size.x(), size.y(), slices
+        , segment.original.pixelFormat, segment.original.bufferType, nullptr );
+    glBindTexture( GL_TEXTURE_3D, 0 );
+    glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+    REPORT_GL_ERROR;
+
+    segment.nextSlice += slices;
+    bytesUploaded += bytes;
+    return segment.isComplete();
+}
+
+
+
+// ----------------------------------------------------------------------------------
+// VolumeUploadScheduler
+// ----------------------------------------------------------------------------------
+
+const std::size_t VolumeUploadScheduler::DEFAULT_BYTES_PER_FRAME = 16 * 1024 * 1024;
+
+
+VolumeUploadScheduler::VolumeUploadScheduler( unsigned int geometryTypeVolume, unsigned int roleHUVolume )
+    : pimpl( new Details() )
+    , geometryTypeVolume( geometryTypeVolume )
+    , roleHUVolume( roleHUVolume )
+{
+}
+
+
+VolumeUploadScheduler::~VolumeUploadScheduler()
+{
+}
+
+
+void VolumeUploadScheduler::setBytesPerFrame( std::size_t bytesPerFrame )
+{
+    CARNA_ASSERT( bytesPerFrame > 0 );
+    pimpl->bytesPerFrame = bytesPerFrame;
+}
+
+
+std::size_t VolumeUploadScheduler::bytesPerFrame() const
+{
+    return pimpl->bytesPerFrame;
+}
+
+
+void VolumeUploadScheduler::enqueue( base::Node& root )
+{
+    /* Gather the segments first since we are not going to modify the scene while
+     * visiting it.
+     */
+    const unsigned int geometryType = geometryTypeVolume;
+    const unsigned int role = roleHUVolume;
+    std::vector< base::Geometry* > found;
+    const std::set< const base::Geometry* >& enqueued = pimpl->enqueued;
+    root.visitChildren( true, [geometryType, role, &enqueued, &found]( base::Spatial& spatial )
+        {
+            base::Geometry* const geometry = dynamic_cast< base::Geometry* >( &spatial );
+            if( geometry != nullptr
+                && geometry->geometryType == geometryType
+                && geometry->hasFeature( role )
+                && enqueued.find( geometry ) == enqueued.end() )
+            {
+                found.push_back( geometry );
+            }
+        }
+    );
+
+    for( auto geomItr = found.begin(); geomItr != found.end(); ++geomItr )
+    {
+        base::Geometry& geometry = **geomItr;
+        base::ManagedTexture3D* const original = dynamic_cast< base::ManagedTexture3D* >( &geometry.feature( role ) );
+        if( original == nullptr || original->bufferPtr == nullptr )
+        {
+            /* This is not a texture we know how to stream.
+             */
+            continue;
+        }
+
+        base::ManagedTexture3D& target = base::ManagedTexture3D::create
+            ( original->size, original->internalFormat, original->pixelFormat, original->bufferType, nullptr );
+        base::ManagedTexture3D& placeholder = base::ManagedTexture3D::create
+            ( base::math::Vector3ui( 1, 1, 1 ), original->internalFormat, original->pixelFormat, original->bufferType, Details::placeholderData() );
+
+        /* Swap the original texture for the placeholder.
+         */
+        const unsigned int originalRole = pimpl->nextOriginalRole++;
+        pimpl->originals.putFeature( originalRole, *original );
+        geometry.removeFeature( role );
+        geometry.putFeature( role, placeholder );
+        placeholder.release();
+
+        Details::Segment* const segment = new Details::Segment( geometry, role, originalRole, *original, target, placeholder );
+        pimpl->segments.push_back( segment );
+        pimpl->enqueued.insert( &geometry );
+        pimpl->watch( geometry.parent() );
+        pimpl->bytesTotal += segment->bytesPerSlice * original->size.z();
+    }
+}
+
+
+void VolumeUploadScheduler::process()
+{
+    /* The textures that were put in place during the previous frame have been
+     * acquired by the rendering stages meanwhile.
+     */
+    pimpl->releaseRetired();
+    if( isDone() )
+    {
+        /* The segments, that were left to stream, might have been dropped.
+         */
+        if( pimpl->isFinishPending )
+        {
+            pimpl->isFinishPending = false;
+            emit progressChanged( progress() );
+            emit finished();
+        }
+        return;
+    }
+    pimpl->glContext = &base::GLContext::current();
+    pimpl->createPbos();
+
+    std::size_t budget = pimpl->bytesPerFrame;
+    const std::size_t bytesUploadedBefore = pimpl->bytesUploaded;
+    while( !isDone() && pimpl->bytesUploaded - bytesUploadedBefore < budget )
+    {
+        Details::Segment& segment = *pimpl->segments[ pimpl->nextSegment ];
+        const std::size_t budgetLeft = budget - ( pimpl->bytesUploaded - bytesUploadedBefore );
+        if( pimpl->upload( segment, budgetLeft ) )
+        {
+            /* The segment is complete, put the streamed texture in place.
+             */
+            segment.geometry.removeFeature( segment.role );
+            segment.geometry.putFeature( segment.role, segment.target );
+            segment.target.release();
+            pimpl->originals.removeFeature( segment.originalRole );
+            pimpl->retiring.push_back( segment.targetVR.release() );
+            pimpl->resident.insert( &segment.geometry );
+            ++pimpl->nextSegment;
+        }
+    }
+
+    emit progressChanged( progress() );
+    if( isDone() )
+    {
+        pimpl->isFinishPending = false;
+        emit finished();
+    }
+}
+
+
+bool VolumeUploadScheduler::isDone() const
+{
+    return pimpl->nextSegment == pimpl->segments.size();
+}
+
+
+bool VolumeUploadScheduler::isResident( const base::Geometry& segment ) const
+{
+    return pimpl->resident.find( &segment ) != pimpl->resident.end();
+}
+
+
+std::size_t VolumeUploadScheduler::segments() const
+{
+    return pimpl->segments.size();
+}
+
+
+std::size_t VolumeUploadScheduler::residentSegments() const
+{
+    return pimpl->nextSegment;
+}
+
+
+float VolumeUploadScheduler::progress() const
+{
+    if( pimpl->bytesTotal == 0 )
+    {
+        return 1;
+    }
+    else
+    {
+        return static_cast< float >( pimpl->bytesUploaded ) / pimpl->bytesTotal;
+    }
+}
+
+
+
+}  // namespace Carna :: qt
+
+}  // namespace Carna
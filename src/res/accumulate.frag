@@ -0,0 +1,26 @@
+#version 330
+
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+uniform sampler2D frame;
+
+out vec4 gl_FragColor;
+
+
+// ----------------------------------------------------------------------------------
+// Fragment Procedure
+// ----------------------------------------------------------------------------------
+
+void main()
+{
+    gl_FragColor = texelFetch( frame, ivec2( gl_FragCoord.xy ), 0 );
+}
@@ -11,7 +11,7 @@
  *
  */
 
-uniform vec4 color;
+in vec4 color;
 
 out vec4 gl_FragColor;
 
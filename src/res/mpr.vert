@@ -11,10 +11,15 @@
  *
  */
 
-uniform mat4 modelViewProjection;
-uniform unsigned int isHorizontal;
+/* Each instance is a line, that is given by the clipping coordinates of its
+ * ends. The vertices only tell which of the ends they are.
+ */
+layout( location = 0 ) in float lineParameter;
+layout( location = 1 ) in vec4 lineStart;
+layout( location = 2 ) in vec4 lineEnd;
+layout( location = 3 ) in vec4 lineColor;
 
-layout( location = 0 ) in vec4 inPosition;
+out vec4 color;
 
 
 // ----------------------------------------------------------------------------------
@@ -23,14 +28,6 @@ layout( location = 0 ) in vec4 inPosition;
 
 void main()
 {
-    vec4 clippingCoordinates = modelViewProjection * inPosition;
-    if( isHorizontal > 0u )
-    {
-        clippingCoordinates.x = inPosition.x;
-    }
-    else
-    {
-        clippingCoordinates.y = inPosition.y;
-    }
-    gl_Position = clippingCoordinates;
+    gl_Position = mix( lineStart, lineEnd, lineParameter );
+    color = lineColor;
 }
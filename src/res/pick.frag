@@ -0,0 +1,26 @@
+#version 330
+
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+uniform vec4 geometryId;
+
+out vec4 gl_FragColor;
+
+
+// ----------------------------------------------------------------------------------
+// Fragment Procedure
+// ----------------------------------------------------------------------------------
+
+void main()
+{
+    gl_FragColor = geometryId;
+}
@@ -0,0 +1,41 @@
+#version 330
+
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+uniform sampler2D huvs;
+uniform sampler2D depths;
+uniform float encodingMinimum;
+uniform float encodingWidth;
+uniform float minimumHUV;
+uniform float windowingWidth;
+
+out vec4 gl_FragColor;
+
+
+// ----------------------------------------------------------------------------------
+// Fragment Procedure
+// ----------------------------------------------------------------------------------
+
+void main()
+{
+    ivec2 pixel = ivec2( gl_FragCoord.xy );
+    float encoded = texelFetch( huvs, pixel, 0 ).r;
+    if( encoded <= 0 || encoded > 1 )
+    {
+        discard;
+    }
+
+    float huv = encodingMinimum + encoded * encodingWidth;
+    float intensity = clamp( ( huv - minimumHUV ) / windowingWidth, 0, 1 );
+    gl_FragColor = vec4( vec3( intensity ), 1 );
+    gl_FragDepth = texelFetch( depths, pixel, 0 ).r;
+}
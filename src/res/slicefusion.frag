@@ -0,0 +1,48 @@
+#version 330
+
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+uniform sampler2D huvs;
+uniform sampler2D depths;
+uniform float encodingMinimum;
+uniform float encodingWidth;
+uniform vec4 minimumHUVs;
+uniform vec4 windowingWidths;
+uniform vec4 weights;
+
+out vec4 gl_FragColor;
+
+
+// ----------------------------------------------------------------------------------
+// Fragment Procedure
+// ----------------------------------------------------------------------------------
+
+void main()
+{
+    /* Each channel holds the HUV of another volume. The intensities of the
+     * volumes, that were rendered to the pixel, are averaged w.r.t. the weights.
+     */
+    ivec2 pixel = ivec2( gl_FragCoord.xy );
+    vec4 encoded = texelFetch( huvs, pixel, 0 );
+    vec4 covered = vec4( greaterThan( encoded, vec4( 0 ) ) ) * vec4( lessThanEqual( encoded, vec4( 1 ) ) );
+    float totalWeight = dot( covered, weights );
+    if( dot( covered, vec4( 1 ) ) == 0 )
+    {
+        discard;
+    }
+
+    vec4 huv = encodingMinimum + encoded * encodingWidth;
+    vec4 intensities = clamp( ( huv - minimumHUVs ) / windowingWidths, 0, 1 );
+    float intensity = totalWeight > 0 ? dot( intensities * covered, weights ) / totalWeight : 0;
+    gl_FragColor = vec4( vec3( intensity ), 1 );
+    gl_FragDepth = texelFetch( depths, pixel, 0 ).r;
+}
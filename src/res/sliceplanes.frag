@@ -0,0 +1,98 @@
+#version 330
+
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+const int MAX_SEGMENTS = 8;
+
+uniform sampler3D segmentTextures[ MAX_SEGMENTS ];
+uniform mat4 worldTexture[ MAX_SEGMENTS ];
+uniform int segmentChannels[ MAX_SEGMENTS ];
+uniform int segments;
+
+uniform mat4 clipWorld;
+uniform mat4 worldClip;
+uniform vec4 viewport;
+uniform vec4 plane;
+uniform float encodingMinimum;
+uniform float encodingWidth;
+uniform float background;
+
+out vec4 gl_FragColor;
+
+
+// ----------------------------------------------------------------------------------
+// Segment Sampling
+// ----------------------------------------------------------------------------------
+
+/* The HUV are stored with an offset of 1024 and 12 bits, scaled to 16 bits.
+ */
+bool sampleSegment( sampler3D huVolume, int segmentIdx, vec4 position, inout vec4 result )
+{
+    vec3 texturePosition = ( worldTexture[ segmentIdx ] * position ).xyz;
+    if( any( lessThan( texturePosition, vec3( 0 ) ) ) || any( greaterThan( texturePosition, vec3( 1 ) ) ) )
+    {
+        return false;
+    }
+    
+    float huv = texture( huVolume, texturePosition ).r * 4096 - 1024;
+    result[ segmentChannels[ segmentIdx ] ] = clamp( ( huv - encodingMinimum ) / encodingWidth, 0.5, 1 );
+    return true;
+}
+
+
+// ----------------------------------------------------------------------------------
+// Fragment Procedure
+// ----------------------------------------------------------------------------------
+
+void main()
+{
+    /* Intersect the ray through the fragment with the plane.
+     */
+    vec2 ndc = ( gl_FragCoord.xy - viewport.xy ) / viewport.zw * 2 - 1;
+    vec4 near = clipWorld * vec4( ndc, -1, 1 );
+    vec4 far  = clipWorld * vec4( ndc, +1, 1 );
+    near /= near.w;
+    far  /= far .w;
+    vec3 direction = far.xyz - near.xyz;
+    float denominator = dot( plane.xyz, direction );
+    if( abs( denominator ) < 1e-8 )
+    {
+        discard;
+    }
+    float t = ( plane.w - dot( plane.xyz, near.xyz ) ) / denominator;
+    if( t < 0 || t > 1 )
+    {
+        discard;
+    }
+    vec4 position = vec4( near.xyz + t * direction, 1 );
+    
+    /* Samplers must not be indexed dynamically, hence the segments are unrolled.
+     */
+    vec4 result = vec4( background );
+    bool hit = false;
+    if( segments > 0 ) hit = sampleSegment( segmentTextures[ 0 ], 0, position, result ) || hit;
+    if( segments > 1 ) hit = sampleSegment( segmentTextures[ 1 ], 1, position, result ) || hit;
+    if( segments > 2 ) hit = sampleSegment( segmentTextures[ 2 ], 2, position, result ) || hit;
+    if( segments > 3 ) hit = sampleSegment( segmentTextures[ 3 ], 3, position, result ) || hit;
+    if( segments > 4 ) hit = sampleSegment( segmentTextures[ 4 ], 4, position, result ) || hit;
+    if( segments > 5 ) hit = sampleSegment( segmentTextures[ 5 ], 5, position, result ) || hit;
+    if( segments > 6 ) hit = sampleSegment( segmentTextures[ 6 ], 6, position, result ) || hit;
+    if( segments > 7 ) hit = sampleSegment( segmentTextures[ 7 ], 7, position, result ) || hit;
+    if( !hit )
+    {
+        discard;
+    }
+    
+    vec4 clipPosition = worldClip * position;
+    gl_FragDepth = clipPosition.z / clipPosition.w * 0.5 + 0.5;
+    gl_FragColor = result;
+}
@@ -58,6 +58,14 @@ int main( int argc, char** argv )
      */
     qt::Application app( argc, argv );
     
+    /* Compile the shaders before the displays are created, s.t. their first frames
+     * do not hitch. The shaders of this library are always compiled. The materials
+     * of the meshes below use the 'unshaded' shader, that is supplied by Carna.
+     */
+    std::vector< std::string > presetShaders;
+    presetShaders.push_back( "unshaded" );
+    app.warmUpShaders( presetShaders );
+    
     /* Create MPR displays.
      */
     const qt::MPRDisplay::Parameters params( GEOMETRY_TYPE_VOLUMETRIC, GEOMETRY_TYPE_PLANES );
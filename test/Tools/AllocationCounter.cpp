@@ -0,0 +1,133 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#include <AllocationCounter.h>
+#include <cstdlib>
+#include <new>
+
+namespace Carna
+{
+
+namespace testing
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// AllocationCounter
+// ----------------------------------------------------------------------------------
+
+/* The 'thread_local' keyword is not supported by VS2010 and VS2013. Thread-local
+ * storage from Qt is not an option either, since it allocates memory itself,
+ * which would recurse into the replaced 'operator new'.
+ */
+#ifdef _MSC_VER
+#   define CARNA_TESTING_THREAD_LOCAL __declspec( thread )
+#else
+#   define CARNA_TESTING_THREAD_LOCAL __thread
+#endif
+
+static CARNA_TESTING_THREAD_LOCAL AllocationCounter* activeAllocationCounter = nullptr;
+
+
+AllocationCounter::AllocationCounter()
+    : outer( activeAllocationCounter )
+    , count( 0 )
+{
+    activeAllocationCounter = this;
+}
+
+
+AllocationCounter::~AllocationCounter()
+{
+    activeAllocationCounter = outer;
+}
+
+
+std::size_t AllocationCounter::allocations() const
+{
+    return count;
+}
+
+
+void AllocationCounter::notifyAllocation()
+{
+    if( activeAllocationCounter != nullptr )
+    {
+        ++activeAllocationCounter->count;
+    }
+}
+
+
+
+}  // namespace Carna :: testing
+
+}  // namespace Carna
+
+
+
+// ----------------------------------------------------------------------------------
+// operator new / operator delete
+// ----------------------------------------------------------------------------------
+
+void* operator new( std::size_t size )
+{
+    Carna::testing::AllocationCounter::notifyAllocation();
+    void* const ptr = std::malloc( size == 0 ? 1 : size );
+    if( ptr == nullptr )
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+
+void* operator new[]( std::size_t size )
+{
+    return operator new( size );
+}
+
+
+void* operator new( std::size_t size, const std::nothrow_t& ) throw()
+{
+    Carna::testing::AllocationCounter::notifyAllocation();
+    return std::malloc( size == 0 ? 1 : size );
+}
+
+
+void* operator new[]( std::size_t size, const std::nothrow_t& nt ) throw()
+{
+    return operator new( size, nt );
+}
+
+
+void operator delete( void* ptr ) throw()
+{
+    std::free( ptr );
+}
+
+
+void operator delete[]( void* ptr ) throw()
+{
+    std::free( ptr );
+}
+
+
+void operator delete( void* ptr, const std::nothrow_t& ) throw()
+{
+    std::free( ptr );
+}
+
+
+void operator delete[]( void* ptr, const std::nothrow_t& ) throw()
+{
+    std::free( ptr );
+}
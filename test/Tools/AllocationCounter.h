@@ -0,0 +1,58 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace Carna
+{
+
+namespace testing
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// AllocationCounter
+// ----------------------------------------------------------------------------------
+
+/** \brief
+  * Counts the heap allocations that the current thread performs while an instance
+  * exists.
+  *
+  * The test suite replaces the global `operator new`, s.t. each allocation is
+  * reported to the innermost living counter of the allocating thread. Counters may
+  * be nested, the outer counter does not see the allocations of the inner one.
+  */
+class AllocationCounter
+{
+
+    AllocationCounter* const outer;
+    std::size_t count;
+
+public:
+
+    AllocationCounter();
+
+    ~AllocationCounter();
+
+    std::size_t allocations() const;
+
+    static void notifyAllocation();
+
+}; // AllocationCounter
+
+
+
+}  // namespace Carna :: testing
+
+}  // namespace Carna
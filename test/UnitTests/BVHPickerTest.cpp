@@ -0,0 +1,234 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#include "BVHPickerTest.h"
+#include <Carna/qt/BVHPicker.h>
+#include <Carna/base/Node.h>
+#include <Carna/base/Geometry.h>
+#include <Carna/base/BoundingBox.h>
+#include <Carna/base/Aggregation.h>
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <cmath>
+
+namespace Carna
+{
+
+namespace testing
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// BVHPickerTest
+// ----------------------------------------------------------------------------------
+
+const static unsigned int BVH_PICKER_TEST_GEOMETRY_TYPE = 0;
+const static unsigned int BVH_PICKER_TEST_GRID_SIZE = 4;
+const static float BVH_PICKER_TEST_GRID_SPACING = 10;
+
+
+void BVHPickerTest::initTestCase()
+{
+}
+
+
+void BVHPickerTest::cleanupTestCase()
+{
+}
+
+
+void BVHPickerTest::init()
+{
+    /* Each geometry object is put beneath a dedicated pivot node, s.t. moving
+     * the pivot invalidates only the subtree of that object.
+     */
+    root.reset( new base::Node() );
+    pivots.clear();
+    geometries.clear();
+    const float offset = ( BVH_PICKER_TEST_GRID_SIZE - 1 ) * BVH_PICKER_TEST_GRID_SPACING / 2;
+    for( unsigned int z = 0; z < BVH_PICKER_TEST_GRID_SIZE; ++z )
+    for( unsigned int y = 0; y < BVH_PICKER_TEST_GRID_SIZE; ++y )
+    for( unsigned int x = 0; x < BVH_PICKER_TEST_GRID_SIZE; ++x )
+    {
+        base::Node* const pivot = new base::Node();
+        pivot->localTransform = base::math::translation4f
+            ( x * BVH_PICKER_TEST_GRID_SPACING - offset
+            , y * BVH_PICKER_TEST_GRID_SPACING - offset
+            , z * BVH_PICKER_TEST_GRID_SPACING - offset );
+        
+        /* Rotate every other object, s.t. the oriented boxes differ from their
+         * axis-aligned bounds.
+         */
+        base::Geometry* const geometry = new base::Geometry( BVH_PICKER_TEST_GEOMETRY_TYPE );
+        geometry->setBoundingVolume( new base::BoundingBox( 4, 6, 2 ) );
+        if( ( x + y + z ) % 2 == 1 )
+        {
+            geometry->localTransform = base::math::rotation4f( 0, 0, 1, base::math::deg2rad( 45 ) );
+        }
+        pivot->attachChild( geometry );
+        root->attachChild( pivot );
+        pivots.push_back( pivot );
+        geometries.push_back( geometry );
+    }
+    picker.reset( new qt::BVHPicker( *root, BVH_PICKER_TEST_GEOMETRY_TYPE ) );
+}
+
+
+void BVHPickerTest::cleanup()
+{
+    picker.reset();
+    root.reset();
+}
+
+
+const base::Geometry* BVHPickerTest::pickLinear
+    ( const base::math::Vector3f& origin
+    , const base::math::Vector3f& direction ) const
+{
+    /* Test the ray against the oriented box of each object within its local
+     * coordinates, using the slab method.
+     */
+    root->updateWorldTransform();
+    const base::Geometry* result = nullptr;
+    float tBest = std::numeric_limits< float >::max();
+    for( auto geometryItr = geometries.begin(); geometryItr != geometries.end(); ++geometryItr )
+    {
+        const base::Geometry& geometry = **geometryItr;
+        const base::BoundingBox& box = static_cast< const base::BoundingBox& >( geometry.boundingVolume() );
+        const base::math::Matrix4f toLocal = ( geometry.worldTransform() * box.transform() ).inverse();
+        const base::math::Vector3f localOrigin    = ( toLocal * base::math::Vector4f( origin.x(), origin.y(), origin.z(), 1 ) ).head< 3 >();
+        const base::math::Vector3f localDirection = ( toLocal * base::math::Vector4f( direction.x(), direction.y(), direction.z(), 0 ) ).head< 3 >();
+        const base::math::Vector3f halfSize = box.size() / 2;
+        
+        float t0 = 0;
+        float t1 = tBest;
+        for( unsigned int i = 0; i < 3 && t0 <= t1; ++i )
+        {
+            if( std::abs( localDirection[ i ] ) < std::numeric_limits< float >::epsilon() )
+            {
+                if( std::abs( localOrigin[ i ] ) > halfSize[ i ] )
+                {
+                    t1 = -1;
+                }
+            }
+            else
+            {
+                const float tA = ( -halfSize[ i ] - localOrigin[ i ] ) / localDirection[ i ];
+                const float tB = ( +halfSize[ i ] - localOrigin[ i ] ) / localDirection[ i ];
+                t0 = std::max( t0, std::min( tA, tB ) );
+                t1 = std::min( t1, std::max( tA, tB ) );
+            }
+        }
+        if( t0 <= t1 && t0 < tBest )
+        {
+            tBest  = t0;
+            result = &geometry;
+        }
+    }
+    return result;
+}
+
+
+void BVHPickerTest::verifyPicks( unsigned int seed )
+{
+    /* Cast rays from a sphere around the scene towards random points within it.
+     * About half of the rays hit some object.
+     */
+    std::mt19937 random( seed );
+    std::uniform_real_distribution< float > coordinate( -1, +1 );
+    const float extent = BVH_PICKER_TEST_GRID_SIZE * BVH_PICKER_TEST_GRID_SPACING;
+    std::size_t hits = 0;
+    for( unsigned int rayIdx = 0; rayIdx < 500; ++rayIdx )
+    {
+        base::math::Vector3f origin( coordinate( random ), coordinate( random ), coordinate( random ) );
+        origin = origin.normalized() * extent * 2;
+        const base::math::Vector3f target( coordinate( random ) * extent / 2, coordinate( random ) * extent / 2, coordinate( random ) * extent / 2 );
+        const base::math::Vector3f direction = target - origin;
+        
+        const base::Geometry* const expected = pickLinear( origin, direction );
+        const base::Geometry* const actual = picker->pick( origin, direction ).get();
+        QCOMPARE( actual, expected );
+        if( expected != nullptr )
+        {
+            ++hits;
+        }
+    }
+    QVERIFY( hits > 0 );
+}
+
+
+void BVHPickerTest::test_matchesLinear()
+{
+    QCOMPARE( picker->size(), geometries.size() );
+    verifyPicks( 1 );
+    QCOMPARE( picker->rebuilds(), static_cast< std::size_t >( 1 ) );
+}
+
+
+void BVHPickerTest::test_matchesLinearAfterRefit()
+{
+    verifyPicks( 2 );
+    
+    /* Move a single object. Only the leaf that holds it and the ancestors of that
+     * leaf are refitted.
+     */
+    base::Node& pivot = *pivots[ 5 ];
+    pivot.localTransform = base::math::translation4f( 3, -7, 12 ) * pivot.localTransform;
+    pivot.invalidate();
+    verifyPicks( 3 );
+    QCOMPARE( picker->rebuilds(), static_cast< std::size_t >( 1 ) );
+    QCOMPARE( picker->refits(), static_cast< std::size_t >( 1 ) );
+    
+    /* The hierarchy over 64 objects, whose leafs hold up to 4 objects each, is 5
+     * levels deep.
+     */
+    QVERIFY( picker->lastRefitNodes() >= 1 );
+    QVERIFY( picker->lastRefitNodes() <= 5 );
+    
+    /* Move many objects at once.
+     */
+    for( std::size_t pivotIdx = 0; pivotIdx < pivots.size(); pivotIdx += 3 )
+    {
+        base::Node& pivot = *pivots[ pivotIdx ];
+        pivot.localTransform = base::math::translation4f( 0, 0, pivotIdx % 7 ) * pivot.localTransform;
+        pivot.invalidate();
+    }
+    verifyPicks( 4 );
+    QCOMPARE( picker->rebuilds(), static_cast< std::size_t >( 1 ) );
+}
+
+
+void BVHPickerTest::test_matchesLinearAfterRebuild()
+{
+    verifyPicks( 5 );
+    
+    /* Remove every fourth object from the scene.
+     */
+    for( std::size_t pivotIdx = 0; pivotIdx < pivots.size(); pivotIdx += 4 )
+    {
+        base::Geometry* const geometry = geometries[ pivotIdx ];
+        delete geometry->detachFromParent();
+        geometries[ pivotIdx ] = nullptr;
+    }
+    geometries.erase( std::remove( geometries.begin(), geometries.end(), nullptr ), geometries.end() );
+    
+    QCOMPARE( picker->size(), geometries.size() );
+    verifyPicks( 6 );
+    QCOMPARE( picker->rebuilds(), static_cast< std::size_t >( 2 ) );
+}
+
+
+
+}  // namespace Carna :: testing
+
+}  // namespace Carna
@@ -0,0 +1,87 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#pragma once
+
+#include <Carna/qt/CarnaQt.h>
+#include <Carna/base/math.h>
+#include <memory>
+#include <vector>
+
+namespace Carna
+{
+
+namespace testing
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// BVHPickerTest
+// ----------------------------------------------------------------------------------
+
+class BVHPickerTest : public QObject
+{
+
+    Q_OBJECT
+
+private slots:
+
+    /** \brief
+      * Called before the first test function is executed.
+      */
+    void initTestCase();
+
+    /** \brief
+      * Called after the last test function is executed.
+      */
+    void cleanupTestCase();
+
+    /** \brief
+      * Called before each test function is executed.
+      */
+    void init();
+
+    /** \brief
+      * Called after each test function is executed.
+      */
+    void cleanup();
+
+ // ----------------------------------------------------------------------------------
+
+    void test_matchesLinear();
+
+    void test_matchesLinearAfterRefit();
+
+    void test_matchesLinearAfterRebuild();
+
+ // ----------------------------------------------------------------------------------
+
+private:
+
+    std::unique_ptr< base::Node > root;
+    std::unique_ptr< qt::BVHPicker > picker;
+    std::vector< base::Node* > pivots;
+    std::vector< base::Geometry* > geometries;
+
+    const base::Geometry* pickLinear
+        ( const base::math::Vector3f& origin
+        , const base::math::Vector3f& direction ) const;
+
+    void verifyPicks( unsigned int seed );
+
+}; // BVHPickerTest
+
+
+
+}  // namespace Carna :: testing
+
+}  // namespace Carna
@@ -0,0 +1,141 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#include "CPRDisplayTest.h"
+#include <HUGZSceneFactory.h>
+#include <Carna/qt/CPRDisplay.h>
+#include <Carna/qt/Reslicer.h>
+#include <QImage>
+#include <vector>
+
+namespace Carna
+{
+
+namespace testing
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// CPRDisplayTest
+// ----------------------------------------------------------------------------------
+
+/* Each segment of the centerline is 20 millimeters long, that are 40 columns with
+ * the default pixel size.
+ */
+const static unsigned int CPR_DISPLAY_TEST_SEGMENT_COLUMNS = 40;
+
+
+static std::vector< base::math::Vector3f > cprDisplayTestCenterline()
+{
+    std::vector< base::math::Vector3f > centerline;
+    centerline.push_back( base::math::Vector3f( -30, 0, 0 ) );
+    centerline.push_back( base::math::Vector3f( -10, 0, 0 ) );
+    centerline.push_back( base::math::Vector3f( +10, 0, 0 ) );
+    centerline.push_back( base::math::Vector3f( +30, 0, 0 ) );
+    return centerline;
+}
+
+
+static bool cprDisplayTestColumnsEqual( const QImage& image1, const QImage& image2, unsigned int columns )
+{
+    for( unsigned int column = 0; column < columns; ++column )
+    for( int row = 0; row < image1.height(); ++row )
+    {
+        if( image1.pixel( column, row ) != image2.pixel( column, row ) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+void CPRDisplayTest::initTestCase()
+{
+}
+
+
+void CPRDisplayTest::cleanupTestCase()
+{
+}
+
+
+void CPRDisplayTest::init()
+{
+    const std::unique_ptr< base::HUVolumeUInt16 > volume
+        ( HUGZSceneFactory::importVolume( std::string( SOURCE_PATH ) + "/res/pelves_reduced.hugz", spacing ) );
+    reslicer.reset( new qt::Reslicer( *volume ) );
+    cpr.reset( new qt::CPRDisplay( *reslicer, spacing ) );
+    cpr->setWindowingLevel( 200 );
+    cpr->setWindowingWidth( 1000 );
+    cpr->setCenterline( cprDisplayTestCenterline() );
+}
+
+
+void CPRDisplayTest::cleanup()
+{
+    cpr.reset();
+    reslicer.reset();
+}
+
+
+void CPRDisplayTest::test_partialResampling()
+{
+    const QImage initial = cpr->image();
+    QCOMPARE( static_cast< unsigned int >( initial.width() ), 3 * CPR_DISPLAY_TEST_SEGMENT_COLUMNS );
+    QCOMPARE( cpr->sampledColumns(), static_cast< std::size_t >( initial.width() ) );
+
+    /* Changing the windowing does not require any sampling.
+     */
+    cpr->setWindowingLevel( 0 );
+    cpr->image();
+    QCOMPARE( cpr->sampledColumns(), static_cast< std::size_t >( initial.width() ) );
+    cpr->setWindowingLevel( 200 );
+
+    /* Lift an inner control point by 15 millimeters. The two adjacent segments
+     * become 25 millimeters long, that are 50 columns each. The first segment is
+     * not sampled again.
+     */
+    std::size_t sampledColumns = cpr->sampledColumns();
+    cpr->setControlPoint( 2, base::math::Vector3f( +10, 0, 15 ) );
+    const QImage innerMoved = cpr->image();
+    QCOMPARE( cpr->sampledColumns() - sampledColumns, static_cast< std::size_t >( 2 * 50 ) );
+    QCOMPARE( static_cast< unsigned int >( innerMoved.width() ), CPR_DISPLAY_TEST_SEGMENT_COLUMNS + 2 * 50 );
+    QVERIFY( cprDisplayTestColumnsEqual( initial, innerMoved, CPR_DISPLAY_TEST_SEGMENT_COLUMNS ) );
+
+    /* Lift the last control point likewise. Only the last segment is sampled
+     * again, that is 20 millimeters long again.
+     */
+    sampledColumns = cpr->sampledColumns();
+    cpr->setControlPoint( 3, base::math::Vector3f( +30, 0, 15 ) );
+    const QImage lastMoved = cpr->image();
+    QCOMPARE( cpr->sampledColumns() - sampledColumns, static_cast< std::size_t >( CPR_DISPLAY_TEST_SEGMENT_COLUMNS ) );
+    QCOMPARE( static_cast< unsigned int >( lastMoved.width() ), 2 * CPR_DISPLAY_TEST_SEGMENT_COLUMNS + 50 );
+    QVERIFY( cprDisplayTestColumnsEqual( innerMoved, lastMoved, CPR_DISPLAY_TEST_SEGMENT_COLUMNS + 50 ) );
+}
+
+
+void CPRDisplayTest::test_sharedVolume()
+{
+    qt::CPRDisplay second( cpr->reslicer(), spacing );
+    QCOMPARE( &second.reslicer(), reslicer.get() );
+    second.setWindowingLevel( cpr->windowingLevel() );
+    second.setWindowingWidth( cpr->windowingWidth() );
+    second.setCenterline( cpr->centerline() );
+    QVERIFY( second.image() == cpr->image() );
+}
+
+
+
+}  // namespace Carna :: testing
+
+}  // namespace Carna
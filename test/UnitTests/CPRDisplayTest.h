@@ -0,0 +1,76 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#pragma once
+
+#include <Carna/qt/CarnaQt.h>
+#include <memory>
+
+namespace Carna
+{
+
+namespace testing
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// CPRDisplayTest
+// ----------------------------------------------------------------------------------
+
+class CPRDisplayTest : public QObject
+{
+
+    Q_OBJECT
+
+private slots:
+
+    /** \brief
+      * Called before the first test function is executed.
+      */
+    void initTestCase();
+
+    /** \brief
+      * Called after the last test function is executed.
+      */
+    void cleanupTestCase();
+
+    /** \brief
+      * Called before each test function is executed.
+      */
+    void init();
+
+    /** \brief
+      * Called after each test function is executed.
+      */
+    void cleanup();
+
+ // ----------------------------------------------------------------------------------
+
+    void test_partialResampling();
+
+    void test_sharedVolume();
+
+ // ----------------------------------------------------------------------------------
+
+private:
+
+    base::math::Vector3f spacing;
+    std::unique_ptr< qt::Reslicer > reslicer;
+    std::unique_ptr< qt::CPRDisplay > cpr;
+
+}; // CPRDisplayTest
+
+
+
+}  // namespace Carna :: testing
+
+}  // namespace Carna
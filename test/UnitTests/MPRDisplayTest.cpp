@@ -0,0 +1,580 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#include "MPRDisplayTest.h"
+#include <AllocationCounter.h>
+#include <TestScene.h>
+#include <Carna/qt/MPR.h>
+#include <Carna/qt/MPRDisplay.h>
+#include <Carna/qt/MPRDisplayPool.h>
+#include <Carna/qt/Display.h>
+#include <Carna/qt/InteractionTrace.h>
+#include <Carna/qt/InteractionReplay.h>
+#include <Carna/qt/VolumeUploadScheduler.h>
+#include <Carna/base/Aggregation.h>
+#include <Carna/base/Node.h>
+#include <Carna/base/Geometry.h>
+#include <Carna/base/ManagedTexture3D.h>
+#include <QMouseEvent>
+#include <QWidget>
+#include <QImage>
+#include <QEventLoop>
+#include <QTimer>
+#include <map>
+
+namespace Carna
+{
+
+namespace testing
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// MPRDisplayTest
+// ----------------------------------------------------------------------------------
+
+const static unsigned int MPR_DISPLAY_TEST_GEOMETRY_TYPE_PLANES = 1;
+const static unsigned int MPR_DISPLAY_TEST_GEOMETRY_TYPE_MARKERS = 2;
+
+
+void MPRDisplayTest::initTestCase()
+{
+}
+
+
+void MPRDisplayTest::cleanupTestCase()
+{
+}
+
+
+void MPRDisplayTest::init()
+{
+    scene.reset( new TestScene( TestScene::NORMAL_MAP_NOT_REQUIRED ) );
+    mpr.reset( new qt::MPR( TestScene::GEOMETRY_TYPE_VOLUMETRIC ) );
+    
+    const qt::MPRDisplay::Parameters params( TestScene::GEOMETRY_TYPE_VOLUMETRIC, MPR_DISPLAY_TEST_GEOMETRY_TYPE_PLANES );
+    mprDisplay.reset( new qt::MPRDisplay( params ) );
+    mprDisplay->setMPR( *mpr );
+    mpr->setRoot( scene->root() );
+    mprDisplay->resize( 256, 256 );
+    mprDisplay->show();
+    QApplication::processEvents();
+    
+    display = mprDisplay->findChild< qt::Display* >();
+    QVERIFY( display != nullptr );
+    
+    /* Warm up, s.t. all lazily initialized resources and containers are set up
+     * before the allocations are counted.
+     */
+    for( int frameIdx = 0; frameIdx < 3; ++frameIdx )
+    {
+        hover( 10 );
+        display->updateGL();
+        QApplication::processEvents();
+    }
+}
+
+
+void MPRDisplayTest::cleanup()
+{
+    mprDisplay.reset();
+    mpr.reset();
+    scene.reset();
+}
+
+
+void MPRDisplayTest::hover( int frames )
+{
+    for( int frameIdx = 0; frameIdx < frames; ++frameIdx )
+    {
+        const QPoint pos( 10 + frameIdx % 200, 20 + frameIdx % 100 );
+        QMouseEvent ev( QEvent::MouseMove, pos, Qt::NoButton, Qt::NoButton, Qt::NoModifier );
+        QApplication::sendEvent( display, &ev );
+    }
+}
+
+
+void MPRDisplayTest::test_hoverAllocations()
+{
+    AllocationCounter counter;
+    hover( 100 );
+    QCOMPARE( counter.allocations(), static_cast< std::size_t >( 0 ) );
+}
+
+
+void MPRDisplayTest::test_frameAllocations()
+{
+    AllocationCounter counter;
+    for( int frameIdx = 0; frameIdx < 10; ++frameIdx )
+    {
+        display->updateGL();
+    }
+    QCOMPARE( counter.allocations(), static_cast< std::size_t >( 0 ) );
+}
+
+
+void MPRDisplayTest::test_volumes()
+{
+    QCOMPARE( mpr->volumes(), static_cast< std::size_t >( 1 ) );
+    base::Spatial& first = mpr->volumeAt( 0 );
+    
+    /* Attach a second volume, that consists of a single segment.
+     */
+    base::Node* const second = new base::Node();
+    second->attachChild( new base::Geometry( TestScene::GEOMETRY_TYPE_VOLUMETRIC ) );
+    scene->root().attachChild( second );
+    QCOMPARE( mpr->volumes(), static_cast< std::size_t >( 2 ) );
+    QCOMPARE( &mpr->volumeAt( 0 ), &first );
+    QCOMPARE( &mpr->volume(), &first );
+    
+    /* The fusion parameters are kept while the volume is detached.
+     */
+    const base::Spatial& secondVolume = mpr->volumeAt( 1 );
+    mpr->setVolumeWeight( secondVolume, 0.25f );
+    mpr->setVolumeWindowingLevel( secondVolume, 100 );
+    second->detachFromParent();
+    QCOMPARE( mpr->volumes(), static_cast< std::size_t >( 1 ) );
+    scene->root().attachChild( second );
+    QCOMPARE( mpr->volumes(), static_cast< std::size_t >( 2 ) );
+    QCOMPARE( mpr->volumeWeight( mpr->volumeAt( 1 ) ), 0.25f );
+    QCOMPARE( mpr->volumeWindowingLevel( mpr->volumeAt( 1 ) ), static_cast< base::HUV >( 100 ) );
+    QCOMPARE( mpr->volumeWindowingLevel( first ), mpr->windowingLevel() );
+    
+    display->updateGL();
+    delete second->detachFromParent();
+    QCOMPARE( mpr->volumes(), static_cast< std::size_t >( 1 ) );
+}
+
+
+void MPRDisplayTest::test_volumeMoves()
+{
+    QCOMPARE( mpr->volumes(), static_cast< std::size_t >( 1 ) );
+    base::Node* const groupA = new base::Node();
+    base::Node* const groupB = new base::Node();
+    scene->root().attachChild( groupA );
+    scene->root().attachChild( groupB );
+    
+    base::Node* const second = new base::Node();
+    second->attachChild( new base::Geometry( TestScene::GEOMETRY_TYPE_VOLUMETRIC ) );
+    groupA->attachChild( second );
+    QCOMPARE( mpr->volumes(), static_cast< std::size_t >( 2 ) );
+    
+    /* Detached subtrees are not watched anymore, hence changing them does not
+     * affect the MPR.
+     */
+    groupA->detachFromParent();
+    QCOMPARE( mpr->volumes(), static_cast< std::size_t >( 1 ) );
+    base::Node* const third = new base::Node();
+    third->attachChild( new base::Geometry( TestScene::GEOMETRY_TYPE_VOLUMETRIC ) );
+    groupA->attachChild( third );
+    QCOMPARE( mpr->volumes(), static_cast< std::size_t >( 1 ) );
+    
+    /* Re-attaching the subtree indexes it again, including the changes that were
+     * made while it was detached.
+     */
+    scene->root().attachChild( groupA );
+    QCOMPARE( mpr->volumes(), static_cast< std::size_t >( 3 ) );
+    
+    /* Moving a volume to another node within the scene keeps it indexed.
+     */
+    second->detachFromParent();
+    QCOMPARE( mpr->volumes(), static_cast< std::size_t >( 2 ) );
+    groupB->attachChild( second );
+    QCOMPARE( mpr->volumes(), static_cast< std::size_t >( 3 ) );
+    
+    delete groupA->detachFromParent();
+    QCOMPARE( mpr->volumes(), static_cast< std::size_t >( 2 ) );
+    delete groupB->detachFromParent();
+    QCOMPARE( mpr->volumes(), static_cast< std::size_t >( 1 ) );
+}
+
+
+
+void MPRDisplayTest::test_volumeLimit()
+{
+    /* The volumes beyond the limit are ignored, those found first are kept.
+     */
+    base::Spatial& first = mpr->volumeAt( 0 );
+    std::vector< base::Node* > volumes;
+    for( unsigned int volumeIdx = 0; volumeIdx < qt::MPR::MAX_VOLUMES; ++volumeIdx )
+    {
+        base::Node* const volume = new base::Node();
+        volume->attachChild( new base::Geometry( TestScene::GEOMETRY_TYPE_VOLUMETRIC ) );
+        scene->root().attachChild( volume );
+        volumes.push_back( volume );
+    }
+    QCOMPARE( mpr->volumes(), static_cast< std::size_t >( qt::MPR::MAX_VOLUMES ) );
+    QCOMPARE( &mpr->volumeAt( 0 ), &first );
+    
+    /* Querying the parameters of a volume, that is not part of the MPR, yields
+     * the defaults.
+     */
+    const base::Spatial& ignored = *volumes.back();
+    QCOMPARE( mpr->volumeWeight( ignored ), qt::MPR::DEFAULT_VOLUME_WEIGHT );
+    QCOMPARE( mpr->volumeWindowingLevel( ignored ), mpr->windowingLevel() );
+    
+    delete volumes.front()->detachFromParent();
+    QCOMPARE( mpr->volumes(), static_cast< std::size_t >( qt::MPR::MAX_VOLUMES ) );
+    QCOMPARE( &mpr->volumeAt( qt::MPR::MAX_VOLUMES - 1 ), &ignored );
+}
+
+
+void MPRDisplayTest::test_pool()
+{
+    qt::MPRDisplayPool pool( mprDisplay->parameters );
+    pool.reserveWidgets( 2 );
+    QCOMPARE( pool.idle(), static_cast< std::size_t >( 2 ) );
+    QCOMPARE( pool.created(), static_cast< std::size_t >( 2 ) );
+    
+    /* Released displays are handed out again instead of creating new ones.
+     */
+    qt::MPRDisplay& first = pool.acquire();
+    first.setMPR( *mpr );
+    QCOMPARE( pool.idle(), static_cast< std::size_t >( 1 ) );
+    
+    /* The settings of released displays are reset to their defaults.
+     */
+    const base::HUV windowingLevel = first.windowingLevel();
+    const unsigned int windowingWidth = first.windowingWidth();
+    first.setRotation( qt::MPRDisplay::ROTATION_LEFT );
+    first.setWindowingLevel( windowingLevel + 100 );
+    first.setWindowingWidth( windowingWidth + 100 );
+    first.setSlabThickness( 10 );
+    first.setSlabMode( qt::MPRDisplay::averageIntensityProjection );
+    first.setSlabStep( 2 );
+    first.setInteractiveSlabStep( 8 );
+    first.setCinePrefetch( 1 );
+    pool.release( first );
+    QCOMPARE( pool.idle(), static_cast< std::size_t >( 2 ) );
+    qt::MPRDisplay& second = pool.acquire();
+    QCOMPARE( &second, &first );
+    QCOMPARE( pool.created(), static_cast< std::size_t >( 2 ) );
+    QCOMPARE( second.windowingLevel(), windowingLevel );
+    QCOMPARE( second.windowingWidth(), windowingWidth );
+    QCOMPARE( second.slabThickness(), 0.f );
+    QCOMPARE( second.slabMode(), qt::MPRDisplay::maximumIntensityProjection );
+    QCOMPARE( second.slabStep(), qt::MPRDisplay::DEFAULT_SLAB_STEP );
+    QCOMPARE( second.interactiveSlabStep(), qt::MPRDisplay::DEFAULT_INTERACTIVE_SLAB_STEP );
+    QCOMPARE( second.cinePrefetch(), qt::MPRDisplay::DEFAULT_CINE_PREFETCH );
+    
+    /* The pool creates new displays when it runs out of idle ones.
+     */
+    qt::MPRDisplay& third  = pool.acquire();
+    qt::MPRDisplay& fourth = pool.acquire();
+    QCOMPARE( pool.idle(), static_cast< std::size_t >( 0 ) );
+    QCOMPARE( pool.created(), static_cast< std::size_t >( 3 ) );
+    pool.release( fourth );
+    pool.release( third );
+    pool.release( second );
+    QCOMPARE( pool.idle(), static_cast< std::size_t >( 3 ) );
+    
+    /* Displays, that are deleted by their parents instead of being released, are
+     * forgotten by the pool.
+     */
+    std::unique_ptr< QWidget > parent( new QWidget() );
+    pool.acquire( parent.get() );
+    qt::MPRDisplay& kept = pool.acquire( parent.get() );
+    kept.setParent( nullptr );
+    parent.reset();
+    QCOMPARE( pool.idle(), static_cast< std::size_t >( 1 ) );
+    QCOMPARE( pool.created(), static_cast< std::size_t >( 2 ) );
+    pool.release( kept );
+    QCOMPARE( pool.idle(), static_cast< std::size_t >( 2 ) );
+}
+
+
+void MPRDisplayTest::test_traceReplay()
+{
+    /* The frames are recorded by each repaint, not only by the refinement.
+     */
+    qt::InteractionTrace trace;
+    display->setInteractionRecorder( new base::Aggregation< qt::InteractionTrace >( trace ) );
+    for( int frameIdx = 0; frameIdx < 5; ++frameIdx )
+    {
+        display->updateGL();
+    }
+    display->setInteractionRecorder( nullptr );
+    QCOMPARE( trace.frames(), static_cast< std::size_t >( 5 ) );
+    
+    qt::InteractionReplay replay( *display, trace );
+    const qt::InteractionReplay::Statistics stats = replay.run( qt::InteractionReplay::fullSpeed );
+    QCOMPARE( stats.frames, static_cast< std::size_t >( 5 ) );
+    QCOMPARE( replay.frameTimes().size(), static_cast< std::size_t >( 5 ) );
+}
+
+
+void MPRDisplayTest::test_inputMerging()
+{
+    typedef qt::InteractionTrace::Event Event;
+    
+    /* Consecutive rotations about the same axis are merged.
+     */
+    for( int moveIdx = 0; moveIdx < 100; ++moveIdx )
+    {
+        display->replay( Event( Event::rotateHorizontally, 0, 0.01f, 0 ) );
+    }
+    QCOMPARE( display->pendingInputOperations(), static_cast< std::size_t >( 1 ) );
+    
+    /* Rotations about different axes do not commute, hence they are not merged
+     * across each other.
+     */
+    for( int moveIdx = 0; moveIdx < 10; ++moveIdx )
+    {
+        display->replay( Event( Event::rotateVertically  , 0, 0.01f, 0 ) );
+        display->replay( Event( Event::rotateHorizontally, 0, 0.01f, 0 ) );
+    }
+    QCOMPARE( display->pendingInputOperations(), static_cast< std::size_t >( 1 + 20 ) );
+    display->updateGL();
+    QCOMPARE( display->pendingInputOperations(), static_cast< std::size_t >( 0 ) );
+    
+    /* Movements commute with each other, but not with rotations.
+     */
+    for( int moveIdx = 0; moveIdx < 10; ++moveIdx )
+    {
+        display->replay( Event( Event::moveAxially  , 0, 0.01f, 0 ) );
+        display->replay( Event( Event::moveLaterally, 0, 0.01f, 0.02f ) );
+    }
+    QCOMPARE( display->pendingInputOperations(), static_cast< std::size_t >( 2 ) );
+    display->replay( Event( Event::rotateHorizontally, 0, 0.01f, 0 ) );
+    display->replay( Event( Event::moveAxially, 0, 0.01f, 0 ) );
+    QCOMPARE( display->pendingInputOperations(), static_cast< std::size_t >( 4 ) );
+    
+    display->updateGL();
+    QCOMPARE( display->pendingInputOperations(), static_cast< std::size_t >( 0 ) );
+}
+
+
+void MPRDisplayTest::test_uploadAbort()
+{
+    /* Remember the original textures of the volume segments.
+     */
+    std::map< base::Geometry*, const base::GeometryFeature* > originals;
+    scene->root().visitChildren( true, [&originals]( base::Spatial& spatial )
+        {
+            base::Geometry* const geometry = dynamic_cast< base::Geometry* >( &spatial );
+            if( geometry != nullptr
+                && geometry->geometryType == TestScene::GEOMETRY_TYPE_VOLUMETRIC
+                && geometry->hasFeature( TestScene::ROLE_HU_VOLUME ) )
+            {
+                originals[ geometry ] = &geometry->feature( TestScene::ROLE_HU_VOLUME );
+            }
+        }
+    );
+    QVERIFY( !originals.empty() );
+    
+    /* Stream a single slice, then delete the scheduler while it is not done.
+     */
+    std::unique_ptr< qt::VolumeUploadScheduler > scheduler
+        ( new qt::VolumeUploadScheduler( TestScene::GEOMETRY_TYPE_VOLUMETRIC, TestScene::ROLE_HU_VOLUME ) );
+    scheduler->setBytesPerFrame( 1 );
+    scheduler->enqueue( scene->root() );
+    display->setUploadScheduler( new base::Aggregation< qt::VolumeUploadScheduler >( *scheduler ) );
+    display->updateGL();
+    QVERIFY( !scheduler->isDone() );
+    display->setUploadScheduler( nullptr );
+    scheduler.reset();
+    
+    for( auto originalItr = originals.begin(); originalItr != originals.end(); ++originalItr )
+    {
+        QCOMPARE( &originalItr->first->feature( TestScene::ROLE_HU_VOLUME ), originalItr->second );
+    }
+    display->updateGL();
+}
+
+
+void MPRDisplayTest::test_uploadVolumeDeleted()
+{
+    /* Create a volume, that consists of two segments of eight slices each.
+     */
+    static const unsigned short voxels[ 8 * 8 * 8 ] = { 0 };
+    base::Node* const volume = new base::Node();
+    base::Geometry* segments[ 2 ];
+    for( unsigned int segmentIdx = 0; segmentIdx < 2; ++segmentIdx )
+    {
+        base::ManagedTexture3D& texture = base::ManagedTexture3D::create
+            ( base::math::Vector3ui( 8, 8, 8 ), GL_R16, GL_RED, GL_UNSIGNED_SHORT, voxels );
+        segments[ segmentIdx ] = new base::Geometry( TestScene::GEOMETRY_TYPE_VOLUMETRIC );
+        segments[ segmentIdx ]->putFeature( TestScene::ROLE_HU_VOLUME, texture );
+        texture.release();
+        volume->attachChild( segments[ segmentIdx ] );
+    }
+    scene->root().attachChild( volume );
+    const base::GeometryFeature& original = segments[ 0 ]->feature( TestScene::ROLE_HU_VOLUME );
+    
+    /* Stream a single slice.
+     */
+    std::unique_ptr< qt::VolumeUploadScheduler > scheduler
+        ( new qt::VolumeUploadScheduler( TestScene::GEOMETRY_TYPE_VOLUMETRIC, TestScene::ROLE_HU_VOLUME ) );
+    scheduler->setBytesPerFrame( 1 );
+    scheduler->enqueue( *volume );
+    QCOMPARE( scheduler->segments(), static_cast< std::size_t >( 2 ) );
+    display->setUploadScheduler( new base::Aggregation< qt::VolumeUploadScheduler >( *scheduler ) );
+    display->updateGL();
+    QVERIFY( !scheduler->isDone() );
+    
+    /* A segment, that is removed from the scene, gets its original texture back.
+     */
+    segments[ 0 ]->detachFromParent();
+    QCOMPARE( scheduler->segments(), static_cast< std::size_t >( 1 ) );
+    QCOMPARE( &segments[ 0 ]->feature( TestScene::ROLE_HU_VOLUME ), &original );
+    delete segments[ 0 ];
+    display->updateGL();
+    QVERIFY( !scheduler->isDone() );
+    
+    /* A segment, that is deleted with its parent, is dropped.
+     */
+    delete volume->detachFromParent();
+    QCOMPARE( scheduler->segments(), static_cast< std::size_t >( 0 ) );
+    QVERIFY( scheduler->isDone() );
+    display->updateGL();
+    
+    display->setUploadScheduler( nullptr );
+    scheduler.reset();
+    display->updateGL();
+}
+
+
+void MPRDisplayTest::test_textureSwap()
+{
+    base::Geometry* volumeGeometry = nullptr;
+    scene->root().visitChildren( true, [&volumeGeometry]( base::Spatial& spatial )
+        {
+            base::Geometry* const geometry = dynamic_cast< base::Geometry* >( &spatial );
+            if( volumeGeometry == nullptr
+                && geometry != nullptr
+                && geometry->geometryType == TestScene::GEOMETRY_TYPE_VOLUMETRIC
+                && geometry->hasFeature( TestScene::ROLE_HU_VOLUME ) )
+            {
+                volumeGeometry = geometry;
+            }
+        }
+    );
+    QVERIFY( volumeGeometry != nullptr );
+    
+    /* Repainting an unchanged scene does not sample the volume again.
+     */
+    display->updateGL();
+    const std::size_t samplings = mprDisplay->slicesSampled();
+    display->updateGL();
+    QCOMPARE( mprDisplay->slicesSampled(), samplings );
+    
+    /* Replacing the texture without moving the geometry does.
+     */
+    static const unsigned short zero = 0;
+    base::GeometryFeature& original = volumeGeometry->feature( TestScene::ROLE_HU_VOLUME );
+    base::ManagedTexture3D& replacement = base::ManagedTexture3D::create
+        ( base::math::Vector3ui( 1, 1, 1 ), GL_R16, GL_RED, GL_UNSIGNED_SHORT, &zero );
+    base::Geometry holder( TestScene::GEOMETRY_TYPE_VOLUMETRIC );
+    holder.putFeature( TestScene::ROLE_HU_VOLUME, original );
+    volumeGeometry->removeFeature( TestScene::ROLE_HU_VOLUME );
+    volumeGeometry->putFeature( TestScene::ROLE_HU_VOLUME, replacement );
+    replacement.release();
+    display->updateGL();
+    QCOMPARE( mprDisplay->slicesSampled(), samplings + 1 );
+    
+    /* Restore the original texture.
+     */
+    volumeGeometry->removeFeature( TestScene::ROLE_HU_VOLUME );
+    volumeGeometry->putFeature( TestScene::ROLE_HU_VOLUME, original );
+    holder.removeFeature( TestScene::ROLE_HU_VOLUME );
+    display->updateGL();
+    QCOMPARE( mprDisplay->slicesSampled(), samplings + 2 );
+    
+    /* Explicit invalidation samples the volume again as well.
+     */
+    mprDisplay->invalidateSlices();
+    display->updateGL();
+    QCOMPARE( mprDisplay->slicesSampled(), samplings + 3 );
+}
+
+
+void MPRDisplayTest::test_skippedRepaints()
+{
+    /* Attach a marker of a type, that none of the rendering stages consumes.
+     */
+    base::Geometry* const marker = new base::Geometry( MPR_DISPLAY_TEST_GEOMETRY_TYPE_MARKERS );
+    scene->root().attachChild( marker );
+    QApplication::processEvents();
+    display->updateGL();
+    const QImage frame = display->grabFrameBuffer();
+    const std::size_t skippedRepaints = display->skippedRepaints();
+    const std::size_t samplings = mprDisplay->slicesSampled();
+    
+    /* Moving the marker neither causes a repaint nor changes the frame.
+     */
+    marker->localTransform = base::math::translation4f( 10, 20, 30 );
+    marker->invalidate();
+    QCOMPARE( display->skippedRepaints(), skippedRepaints + 1 );
+    display->updateGL();
+    QCOMPARE( mprDisplay->slicesSampled(), samplings );
+    QVERIFY( display->grabFrameBuffer() == frame );
+    
+    /* Moving the volume does cause a repaint.
+     */
+    scene->volumeNode().localTransform = base::math::translation4f( 0, 0, 1 );
+    scene->volumeNode().invalidate();
+    QCOMPARE( display->skippedRepaints(), skippedRepaints + 1 );
+    
+    delete marker->detachFromParent();
+}
+
+
+void MPRDisplayTest::test_cinePrefetch()
+{
+    mprDisplay->setCinePrefetch( 3 );
+    mprDisplay->startCine( 1, 1 );
+    display->updateGL();
+    const std::size_t samplings = mprDisplay->slicesSampled();
+    
+    /* The slices ahead of the plane are not prefetched before the frame is
+     * presented, but once the event loop is reached.
+     */
+    for( int eventsIdx = 0; eventsIdx < 3; ++eventsIdx )
+    {
+        QApplication::processEvents();
+    }
+    QCOMPARE( mprDisplay->slicesSampled(), samplings + 3 );
+    QCOMPARE( mprDisplay->cinePrefetchMisses(), static_cast< std::size_t >( 0 ) );
+    
+    /* Play back two slices. Both were prefetched, hence they are presented
+     * without sampling the volume. Only the slices, that come into the prefetched
+     * range, are sampled.
+     */
+    QEventLoop playback;
+    QTimer::singleShot( 2700, &playback, SLOT( quit() ) );
+    playback.exec();
+    mprDisplay->stopCine();
+    QCOMPARE( mprDisplay->cineFramesAdvanced(), static_cast< std::size_t >( 2 ) );
+    QCOMPARE( mprDisplay->cineFramesDropped(), static_cast< std::size_t >( 0 ) );
+    QCOMPARE( mprDisplay->cinePrefetchMisses(), static_cast< std::size_t >( 0 ) );
+    QCOMPARE( mprDisplay->slicesSampled(), samplings + 3 + 2 );
+}
+
+
+void MPRDisplayTest::test_windowingCached()
+{
+    display->updateGL();
+    const std::size_t samplings = mprDisplay->slicesSampled();
+    
+    /* Changing the windowing only repeats the windowing pass, it does not
+     * sample the volume again.
+     */
+    mprDisplay->setWindowingLevel( mprDisplay->windowingLevel() + 100 );
+    mprDisplay->setWindowingWidth( 500 );
+    display->updateGL();
+    QCOMPARE( mprDisplay->slicesSampled(), samplings );
+}
+
+
+}  // namespace Carna :: testing
+
+}  // namespace Carna
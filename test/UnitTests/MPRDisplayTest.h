@@ -0,0 +1,105 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#pragma once
+
+#include <Carna/qt/CarnaQt.h>
+#include <memory>
+
+namespace Carna
+{
+
+namespace testing
+{
+
+class TestScene;
+
+
+
+// ----------------------------------------------------------------------------------
+// MPRDisplayTest
+// ----------------------------------------------------------------------------------
+
+class MPRDisplayTest : public QObject
+{
+
+    Q_OBJECT
+
+private slots:
+
+    /** \brief
+      * Called before the first test function is executed.
+      */
+    void initTestCase();
+
+    /** \brief
+      * Called after the last test function is executed.
+      */
+    void cleanupTestCase();
+
+    /** \brief
+      * Called before each test function is executed.
+      */
+    void init();
+
+    /** \brief
+      * Called after each test function is executed.
+      */
+    void cleanup();
+
+ // ----------------------------------------------------------------------------------
+ 
+    void test_hoverAllocations();
+    
+    void test_frameAllocations();
+    
+    void test_volumes();
+    
+    void test_volumeMoves();
+    
+    void test_volumeLimit();
+    
+    void test_pool();
+    
+    void test_traceReplay();
+    
+    void test_inputMerging();
+    
+    void test_uploadAbort();
+    
+    void test_uploadVolumeDeleted();
+    
+    void test_textureSwap();
+    
+    void test_skippedRepaints();
+    
+    void test_cinePrefetch();
+    
+    void test_windowingCached();
+
+ // ----------------------------------------------------------------------------------
+    
+private:
+
+    std::unique_ptr< TestScene > scene;
+    std::unique_ptr< qt::MPR > mpr;
+    std::unique_ptr< qt::MPRDisplay > mprDisplay;
+    qt::Display* display;
+    
+    void hover( int frames );
+    
+}; // MPRDisplayTest
+
+
+
+}  // namespace Carna :: testing
+
+}  // namespace Carna
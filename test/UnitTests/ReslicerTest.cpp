@@ -0,0 +1,202 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#include "ReslicerTest.h"
+#include <TestScene.h>
+#include <HUGZSceneFactory.h>
+#include <Carna/qt/Reslicer.h>
+#include <Carna/qt/Display.h>
+#include <Carna/qt/FrameRendererFactory.h>
+#include <Carna/qt/TiledRenderer.h>
+#include <Carna/presets/CuttingPlanesStage.h>
+#include <Carna/base/Node.h>
+#include <Carna/base/Geometry.h>
+#include <Carna/base/Camera.h>
+#include <QPainter>
+#include <QImage>
+#include <vector>
+#include <cstdlib>
+
+namespace Carna
+{
+
+namespace testing
+{
+
+
+
+// ----------------------------------------------------------------------------------
+// ReslicerTest
+// ----------------------------------------------------------------------------------
+
+const static unsigned int RESLICER_TEST_GEOMETRY_TYPE_PLANES = 1;
+const static unsigned int RESLICER_TEST_IMAGE_SIZE = 128;
+const static float RESLICER_TEST_FIELD_OF_VIEW = 400;
+const static base::HUV RESLICER_TEST_WINDOWING_LEVEL = 200;
+const static unsigned int RESLICER_TEST_WINDOWING_WIDTH = 1000;
+
+
+/* Assembles the tiles rendered by a 'TiledRenderer' into a single image.
+ */
+struct ReslicerTestImageSink : public qt::TiledRenderer::TileSink
+{
+    QImage image;
+
+    virtual void begin( unsigned int width, unsigned int height, unsigned int columns, unsigned int rows ) override
+    {
+        image = QImage( width, height, QImage::Format_RGB32 );
+    }
+
+    virtual void write( unsigned int column, unsigned int row, unsigned int left, unsigned int top, const QImage& tile ) override
+    {
+        QPainter painter( &image );
+        painter.drawImage( left, top, tile );
+    }
+};
+
+
+void ReslicerTest::initTestCase()
+{
+}
+
+
+void ReslicerTest::cleanupTestCase()
+{
+}
+
+
+void ReslicerTest::init()
+{
+    scene.reset( new TestScene( TestScene::NORMAL_MAP_NOT_REQUIRED ) );
+
+    base::math::Vector3f spacing;
+    const std::unique_ptr< base::HUVolumeUInt16 > volume
+        ( HUGZSceneFactory::importVolume( std::string( SOURCE_PATH ) + "/res/pelves_reduced.hugz", spacing ) );
+    reslicer.reset( new qt::Reslicer( *volume ) );
+
+    /* Look up the geometry that the volume is rendered with.
+     */
+    volumeGeometry = nullptr;
+    unsigned int volumeGeometries = 0;
+    scene->volumeNode().visitChildren( false, [this, &volumeGeometries]( base::Spatial& spatial )
+        {
+            base::Geometry* const geometry = dynamic_cast< base::Geometry* >( &spatial );
+            if( geometry != nullptr && geometry->geometryType == TestScene::GEOMETRY_TYPE_VOLUMETRIC )
+            {
+                volumeGeometry = geometry;
+                ++volumeGeometries;
+            }
+        }
+    );
+    QCOMPARE( volumeGeometries, 1u );
+
+    /* Render the plane with an orthogonal camera that looks along its normal.
+     */
+    plane = new base::Geometry( RESLICER_TEST_GEOMETRY_TYPE_PLANES );
+    scene->root().attachChild( plane );
+    base::Camera* const cam = new base::Camera();
+    cam->localTransform = base::math::translation4f( 0, 0, 500 );
+    cam->setProjection( base::math::ortho4f
+        ( -RESLICER_TEST_FIELD_OF_VIEW / 2, +RESLICER_TEST_FIELD_OF_VIEW / 2
+        , -RESLICER_TEST_FIELD_OF_VIEW / 2, +RESLICER_TEST_FIELD_OF_VIEW / 2
+        , 1, 1000 ) );
+    plane->attachChild( cam );
+
+    planes = new presets::CuttingPlanesStage( TestScene::GEOMETRY_TYPE_VOLUMETRIC, RESLICER_TEST_GEOMETRY_TYPE_PLANES );
+    planes->setWindowingLevel( RESLICER_TEST_WINDOWING_LEVEL );
+    planes->setWindowingWidth( RESLICER_TEST_WINDOWING_WIDTH );
+    qt::FrameRendererFactory* const frFactory = new qt::FrameRendererFactory();
+    frFactory->appendStage( planes );
+    display.reset( new qt::Display( frFactory ) );
+    display->setCamera( *cam );
+    display->resize( RESLICER_TEST_IMAGE_SIZE, RESLICER_TEST_IMAGE_SIZE );
+    display->show();
+    QApplication::processEvents();
+}
+
+
+void ReslicerTest::cleanup()
+{
+    display.reset();
+    reslicer.reset();
+    scene.reset();
+}
+
+
+base::math::Matrix4f ReslicerTest::sliceTransform() const
+{
+    scene->root().updateWorldTransform();
+    return qt::Reslicer::computeSliceTransform
+        ( volumeGeometry->worldTransform()
+        , plane->worldTransform()
+        , RESLICER_TEST_IMAGE_SIZE
+        , RESLICER_TEST_IMAGE_SIZE
+        , RESLICER_TEST_FIELD_OF_VIEW / RESLICER_TEST_IMAGE_SIZE );
+}
+
+
+void ReslicerTest::test_matchesGPU()
+{
+    /* Tilt the plane, s.t. the samples do not coincide with the voxel centers.
+     */
+    plane->localTransform
+        = base::math::translation4f( 3, -5, 7 )
+        * base::math::rotation4f( base::math::Vector3f( 1, 1, 0 ).normalized(), 0.3f );
+
+    ReslicerTestImageSink sink;
+    qt::TiledRenderer tiledRenderer( *display );
+    tiledRenderer.render( RESLICER_TEST_IMAGE_SIZE, RESLICER_TEST_IMAGE_SIZE, sink );
+
+    std::vector< unsigned char > intensities( RESLICER_TEST_IMAGE_SIZE * RESLICER_TEST_IMAGE_SIZE );
+    reslicer->reslice
+        ( sliceTransform(), RESLICER_TEST_IMAGE_SIZE, RESLICER_TEST_IMAGE_SIZE
+        , RESLICER_TEST_WINDOWING_LEVEL, RESLICER_TEST_WINDOWING_WIDTH, intensities.data() );
+
+    /* The GPU interpolates with reduced precision, hence small deviations are
+     * tolerated. Larger deviations are only tolerated at the volume's borders.
+     */
+    unsigned int deviations = 0;
+    for( unsigned int y = 0; y < RESLICER_TEST_IMAGE_SIZE; ++y )
+    for( unsigned int x = 0; x < RESLICER_TEST_IMAGE_SIZE; ++x )
+    {
+        const int gpu = qGray( sink.image.pixel( x, y ) );
+        const int cpu = intensities[ y * RESLICER_TEST_IMAGE_SIZE + x ];
+        if( std::abs( gpu - cpu ) > 2 )
+        {
+            ++deviations;
+        }
+    }
+    QVERIFY( deviations <= RESLICER_TEST_IMAGE_SIZE * RESLICER_TEST_IMAGE_SIZE / 100 );
+}
+
+
+void ReslicerTest::test_threads()
+{
+    plane->localTransform = base::math::rotation4f( base::math::Vector3f( 0, 1, 0 ), 0.5f );
+    const base::math::Matrix4f transform = sliceTransform();
+
+    std::vector< signed short > multiThreaded( RESLICER_TEST_IMAGE_SIZE * RESLICER_TEST_IMAGE_SIZE );
+    reslicer->setThreads( 4 );
+    reslicer->reslice( transform, RESLICER_TEST_IMAGE_SIZE, RESLICER_TEST_IMAGE_SIZE, multiThreaded.data() );
+
+    std::vector< signed short > singleThreaded( multiThreaded.size() );
+    reslicer->setThreads( 1 );
+    QCOMPARE( reslicer->threads(), 1u );
+    reslicer->reslice( transform, RESLICER_TEST_IMAGE_SIZE, RESLICER_TEST_IMAGE_SIZE, singleThreaded.data() );
+
+    QVERIFY( multiThreaded == singleThreaded );
+}
+
+
+
+}  // namespace Carna :: testing
+
+}  // namespace Carna
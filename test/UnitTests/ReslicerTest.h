@@ -0,0 +1,83 @@
+/*
+ *  Copyright (C) 2010 - 2015 Leonid Kostrykin
+ *
+ *  Chair of Medical Engineering (mediTEC)
+ *  RWTH Aachen University
+ *  Pauwelsstr. 20
+ *  52074 Aachen
+ *  Germany
+ *
+ */
+
+#pragma once
+
+#include <Carna/qt/CarnaQt.h>
+#include <memory>
+
+namespace Carna
+{
+
+namespace testing
+{
+
+class TestScene;
+
+
+
+// ----------------------------------------------------------------------------------
+// ReslicerTest
+// ----------------------------------------------------------------------------------
+
+class ReslicerTest : public QObject
+{
+
+    Q_OBJECT
+
+private slots:
+
+    /** \brief
+      * Called before the first test function is executed.
+      */
+    void initTestCase();
+
+    /** \brief
+      * Called after the last test function is executed.
+      */
+    void cleanupTestCase();
+
+    /** \brief
+      * Called before each test function is executed.
+      */
+    void init();
+
+    /** \brief
+      * Called after each test function is executed.
+      */
+    void cleanup();
+
+ // ----------------------------------------------------------------------------------
+
+    void test_matchesGPU();
+
+    void test_threads();
+
+ // ----------------------------------------------------------------------------------
+
+private:
+
+    std::unique_ptr< TestScene > scene;
+    std::unique_ptr< qt::Reslicer > reslicer;
+    std::unique_ptr< qt::Display > display;
+    presets::CuttingPlanesStage* planes;
+    base::Geometry* plane;
+    base::Geometry* volumeGeometry;
+
+    base::math::Matrix4f sliceTransform() const;
+
+}; // ReslicerTest
+
+
+
+}  // namespace Carna :: testing
+
+}  // namespace Carna
@@ -1,10 +1,18 @@
 include_directories( ${CMAKE_PROJECT_DIR}UnitTests )
 
 list( APPEND TESTS
+		BVHPickerTest
+		CPRDisplayTest
+		MPRDisplayTest
+		ReslicerTest
 		SpatialListModelTest
 	)
 
 list( APPEND TESTS_QOBJECT_HEADERS
+		UnitTests/BVHPickerTest.h
+		UnitTests/CPRDisplayTest.h
+		UnitTests/MPRDisplayTest.h
+		UnitTests/ReslicerTest.h
 		UnitTests/SpatialListModelTest.h
 	)
 
@@ -13,5 +21,9 @@ list( APPEND TESTS_HEADERS
 	)
 
 list( APPEND TESTS_SOURCES
+		UnitTests/BVHPickerTest.cpp
+		UnitTests/CPRDisplayTest.cpp
+		UnitTests/MPRDisplayTest.cpp
+		UnitTests/ReslicerTest.cpp
 		UnitTests/SpatialListModelTest.cpp
 	)